@@ -0,0 +1,54 @@
+#ifndef ANGLEESTIMATOR_H
+#define ANGLEESTIMATOR_H
+
+#include <Arduino.h>
+
+
+namespace Rotor {
+
+    // Angle Estimator Class
+    // *********************
+    // Alpha-beta filter estimating rotor angle and angular speed from every ADC sample.
+    // Measurements far off the prediction are rejected as outliers, a confidence value
+    // tells how well recent measurements agreed with the model.
+    class AngleEstimator {
+    private:
+        bool initialised = false;
+        unsigned long last_us = 0;
+        unsigned long last_accepted_us = 0;
+        float innovation_var = 0.04f;           // Running variance of accepted innovations, in °²
+        uint8_t n_consecutive_rejects = 0;
+
+        // => Restart filter at given measurement and speed
+        void reset(const float measured_angle, const unsigned long us, const float speed = 0.0f);
+
+    public:
+        // Filter gains, beta follows from alpha (Benedict-Bordner)
+        const float alpha = 0.05f;
+        const float beta = alpha * alpha / (2.0f - alpha);
+
+        // Filtered values
+        float angle = 0.0f;             // in °
+        float angular_speed = 0.0f;     // in °/s
+        float confidence = 0.0f;        // 0 to 1
+
+        // Statistics
+        uint32_t n_samples = 0;
+        uint32_t n_rejected = 0;
+        uint32_t n_resets = 0;          // Restarts after lasting jumps
+
+        AngleEstimator() {};
+
+        // => Feed a new angle measurement taken at given time.
+        // Returns false if the measurement was rejected as outlier.
+        bool update(const float measured_angle, const unsigned long us);
+
+        // => Forget filter state, next measurement restarts the filter
+        void invalidate() { initialised = false; }
+
+        // => Standard deviation of accepted innovations, in °
+        float getNoise() const { return sqrt(innovation_var); }
+    };
+}
+
+#endif //ANGLEESTIMATOR_H
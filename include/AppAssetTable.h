@@ -0,0 +1,23 @@
+// Generated by scripts/asset_table.py, do not edit.
+// Embedded web assets sorted by path, to be included once by the asset router.
+#ifndef APPASSETTABLE_H
+#define APPASSETTABLE_H
+
+#include <AppIndex.h>
+#include <AppAssets.h>
+#include <RotorServer.h>
+
+const RotorServer::Asset app_assets[] = {
+  {"/", "text/html", index_html_gzip, index_html_gzip_len, "\"29f81570b6fb95dd\"", INDEX_CACHE_CONTROL, true, true},
+  {"/android-chrome-192x192.png", "image/png", android_chrome_192x192_png, android_chrome_192x192_png_len, "\"9a2e842430f82daf\"", ASSET_CACHE_CONTROL, false, false},
+  {"/android-chrome-512x512.png", "image/png", android_chrome_512x512_png, android_chrome_512x512_png_len, "\"eff984275e49b385\"", ASSET_CACHE_CONTROL, false, false},
+  {"/apple-touch-icon.png", "image/png", apple_touch_icon_png, apple_touch_icon_png_len, "\"62d5df914ad971f4\"", ASSET_CACHE_CONTROL, false, false},
+  {"/favicon-16x16.png", "image/png", favicon_16x16_png, favicon_16x16_png_len, "\"3277adc0fe4bd263\"", ASSET_CACHE_CONTROL, false, false},
+  {"/favicon-32x32.png", "image/png", favicon_32x32_png, favicon_32x32_png_len, "\"664caa0512fe70b0\"", ASSET_CACHE_CONTROL, false, false},
+  {"/inter-700.woff2", "font/woff2", inter_700_woff2, inter_700_woff2_len, "\"9594f24367800a20\"", ASSET_CACHE_CONTROL, false, false},
+  {"/inter-regular.woff2", "font/woff2", inter_regular_woff2, inter_regular_woff2_len, "\"4af50379e1351455\"", ASSET_CACHE_CONTROL, false, false},
+};
+
+#define app_assets_len (sizeof(app_assets) / sizeof(app_assets[0]))
+
+#endif //APPASSETTABLE_H
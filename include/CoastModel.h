@@ -0,0 +1,67 @@
+#ifndef COASTMODEL_H
+#define COASTMODEL_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <atomic>
+
+#define COAST_SPEED_BUCKETS 10
+
+// Learned changes are saved at most this often, in ms
+#ifndef COAST_SAVE_INTERVAL
+#define COAST_SAVE_INTERVAL 60000UL
+#endif
+
+
+namespace Rotor {
+
+    // Coast Model Class
+    // *****************
+    // Learns how far the rotor coasts after the relays are cut.
+    // The coast distance is modeled as tau * angular speed, with one time constant tau
+    // per DAC speed bucket (0-9 %, 10-19 %, ..., 90-100 %). Persisted in PREFS by the loop,
+    // learned by the control task.
+    class CoastModel {
+    private:
+        Preferences coast_prefs;
+
+        float tau[COAST_SPEED_BUCKETS];         // Coast time constant in s
+        uint16_t n[COAST_SPEED_BUCKETS];        // N of learned samples
+
+        // Learned since the last save
+        std::atomic<bool> changed{false};
+        unsigned long last_save_ms = 0;         // 0 if not saved since boot
+
+        // => Get bucket index for DAC speed
+        uint8_t getBucket(const uint8_t speed) const;
+
+    public:
+        CoastModel() {};
+
+        // => Load model from PREFS
+        void load();
+
+        // => Save model to PREFS
+        void save();
+
+        // => Reset model and save
+        void reset();
+
+        // => Predicted coast distance in degrees for DAC speed (%) and angular speed (°/s).
+        // Returns 0 if nothing has been learned for this speed yet.
+        float predict(const uint8_t speed, const float angular_speed) const;
+
+        // => Save model to PREFS if it learned since the last save, at most every COAST_SAVE_INTERVAL.
+        // To be called from loop(), writing flash stalls the calling task.
+        void saveChanged();
+
+        // => Learn from a measured coast distance (°) after cutting at given DAC speed and angular speed.
+        // Saved by saveChanged().
+        void learn(const uint8_t speed, const float angular_speed, const float distance);
+
+        // => Print model to Serial
+        void printToSerial() const;
+    };
+}
+
+#endif //COASTMODEL_H
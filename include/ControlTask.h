@@ -0,0 +1,32 @@
+#ifndef CONTROLTASK_H
+#define CONTROLTASK_H
+
+#include <Arduino.h>
+
+#define CONTROL_PERIOD_MS 10
+
+
+namespace ControlTask {
+
+    // Timing statistics of the control task, all in µs
+    struct Stats {
+        uint32_t n_ticks = 0;
+        uint32_t period_us = CONTROL_PERIOD_MS * 1000;
+        uint32_t last_period_us = 0;
+        uint32_t max_jitter_us = 0;     // Since last report
+        uint32_t worst_jitter_us = 0;   // Since start
+        uint32_t max_tick_us = 0;       // Since last report
+        uint32_t worst_tick_us = 0;     // Since start
+        uint64_t sum_tick_us = 0;       // Since start, for mean tick time
+    };
+
+    extern struct Stats stats;
+
+    // => Start the fixed-rate rotor control task, pinned to core 1
+    void start();
+
+    // => Print timing statistics to Serial and reset maxima since last report
+    void printStats();
+}
+
+#endif //CONTROLTASK_H
@@ -15,8 +15,9 @@ private:
 public:
     Favorites();
     void init();
-    void set(char* msg);
+    void set(const char* msg);
     void send() const;
+    void appendTo(String &buffer) const;
 };
 
 extern Favorites favorites;
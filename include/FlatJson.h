@@ -0,0 +1,67 @@
+#ifndef FLATJSON_H
+#define FLATJSON_H
+
+#include <Arduino.h>
+
+
+// Flat JSON Reader
+// ****************
+// Reads the key/value pairs of a flat JSON object in place, without copying or
+// allocating. Values are numbers, booleans, null or strings; nested objects and
+// arrays are rejected. Strings are returned raw, escape sequences are not decoded.
+namespace FlatJson {
+
+    enum class Type : uint8_t {
+        NUMBER,
+        BOOL,
+        NUL,
+        STRING
+    };
+
+    // A key/value pair, pointing into the parsed buffer
+    struct Pair {
+        const char* key = nullptr;
+        size_t key_len = 0;
+        Type type = Type::NUL;
+        const char* value = nullptr;    // Strings without quotes
+        size_t value_len = 0;
+
+        // => Compare key with a null-terminated string
+        bool is(const char* name) const {
+            return strncmp(key, name, key_len) == 0 && name[key_len] == '\0';
+        }
+
+        // => Value as number, booleans are 0 or 1, other types are 0
+        float toFloat() const;
+
+        // => Value as integer, exact for integral numbers. Fractions are rounded, out of range
+        // values saturate. Negative numbers are 0 as unsigned.
+        int32_t toInt() const;
+        uint32_t toUint() const;
+
+        // => Value as boolean, numbers are true if not 0
+        bool toBool() const;
+    };
+
+    class Reader {
+    private:
+        const char* pos;
+        const char* end;
+        bool error = false;
+
+        // => Skip whitespace, return false at end of buffer
+        bool skipSpace();
+
+    public:
+        // => Start reading an object from buffer, must begin with '{'
+        Reader(const char* json, const size_t len);
+
+        // => Read next pair. Returns false at the end of the object or on a syntax error.
+        bool next(Pair &pair);
+
+        // => Return wether reading stopped because of a syntax error
+        bool failed() const { return error; }
+    };
+}
+
+#endif //FLATJSON_H
@@ -0,0 +1,58 @@
+#ifndef GS232_H
+#define GS232_H
+
+#include <Arduino.h>
+
+#include <RotorCommands.h>
+
+// Raw TCP port for GS-232 commands
+#ifndef GS232_TCP_PORT
+#define GS232_TCP_PORT 4001
+#endif
+
+// Concurrent TCP connections
+#ifndef GS232_MAX_CLIENTS
+#define GS232_MAX_CLIENTS 2
+#endif
+
+// Baud rate of the GS-232 UART
+#ifndef GS232_BAUD
+#define GS232_BAUD 9600
+#endif
+
+#define GS232_LINE_SIZE 32
+
+
+// GS-232 Emulation
+// ****************
+// Yaesu GS-232A/B command interpreter on UART2 and a raw TCP socket, for station software
+// that drives rotors with C, C2, Mxxx, Waaa eee, R, L, A, S and Xn. Commands end with CR,
+// position answers use the GS-232B format (AZ=nnn), or GS-232A (+0nnn) with -D GS232_A.
+// Input is collected without blocking, whole lines are handled once complete.
+namespace GS232 {
+
+    // Partly received command of one connection
+    struct LineBuffer {
+        char line[GS232_LINE_SIZE];
+        size_t len = 0;
+        bool overflow = false;
+    };
+
+    // Response callback of a connection
+    typedef void (*Respond)(void* ctx, const char* response);
+
+    // => Collect received bytes and handle complete commands. Motion commands are handed to post.
+    void feed(LineBuffer &buffer, const char* data, const size_t len, Rotor::PostCommand post,
+              Respond respond, void* ctx);
+
+    // => Start UART2 and the TCP listener
+    void init();
+
+    // => Handle input pending on UART2, to be called from the loop. Never waits for input.
+    void pollSerial();
+
+    // => Print command counters to Serial
+    void printStats();
+}
+
+#endif //GS232_H
@@ -0,0 +1,17 @@
+#ifndef HISTORYBENCHMARK_H
+#define HISTORYBENCHMARK_H
+
+#include <Arduino.h>
+
+
+// History Benchmark
+// *****************
+// Memory footprint of the rotation history and cost of encoding, CSV and binary export.
+// Enabled with -D HISTORY_BENCHMARK=N.
+namespace HistoryBenchmark {
+
+    // => Record N samples of a simulated rotor into a scratch history and print size and timing
+    void run(const uint32_t n_samples);
+}
+
+#endif //HISTORYBENCHMARK_H
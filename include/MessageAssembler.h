@@ -0,0 +1,69 @@
+#ifndef MESSAGEASSEMBLER_H
+#define MESSAGEASSEMBLER_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+
+// Largest message assembled from several frames or TCP segments
+#ifndef SOCKET_MAX_MESSAGE_SIZE
+#define SOCKET_MAX_MESSAGE_SIZE 4096
+#endif
+
+// Reassembly buffers in the arena, shared by all clients
+#ifndef SOCKET_REASSEMBLY_SLOTS
+#define SOCKET_REASSEMBLY_SLOTS 2
+#endif
+
+
+// Message Assembler
+// *****************
+// Joins websocket text messages that arrive in several frames or TCP segments.
+// Buffers come from a preallocated arena, so large messages don't fragment the heap.
+// Not thread safe, to be used from the async_tcp task only.
+namespace RotorSocket {
+
+  // Reassembly of fragmented messages, since boot
+  struct ReassemblyStats {
+    uint32_t n_messages = 0;        // Messages assembled from several pieces
+    uint32_t n_too_large = 0;       // Dropped, larger than SOCKET_MAX_MESSAGE_SIZE
+    uint32_t n_no_slot = 0;         // Dropped, all reassembly buffers in use
+    size_t max_size = 0;            // Largest assembled message
+    uint8_t max_slots_used = 0;
+    uint32_t last_us = 0;           // Time from first to last piece
+    uint32_t max_us = 0;
+  };
+
+  class MessageAssembler {
+  private:
+    struct Slot {
+      bool in_use = false;
+      size_t len = 0;
+      bool too_large = false;
+      unsigned long start_us = 0;
+      char data[SOCKET_MAX_MESSAGE_SIZE + 1];
+    };
+    Slot arena[SOCKET_REASSEMBLY_SLOTS];
+
+    // => Take a free buffer, false if all are in use
+    bool acquire(int8_t &slot);
+
+    // => Collect a piece of a fragmented message, see feed()
+    char* feedPiece(int8_t &slot, const AwsFrameInfo &info, uint8_t* data, const size_t len, size_t &msg_len);
+
+  public:
+    ReassemblyStats stats;
+
+    // => Feed the data of a websocket data event. slot is the buffer held by the client, -1 if none.
+    // Returns the complete null-terminated text message and its length, or nullptr while pieces are
+    // missing or if the message was dropped. A message in a single frame is returned in place.
+    char* feed(int8_t &slot, const AwsFrameInfo &info, uint8_t* data, const size_t len, size_t &msg_len);
+
+    // => Return the buffer of a client to the arena
+    void release(int8_t &slot);
+
+    // => Size of the arena in bytes
+    size_t arenaSize() const { return sizeof(arena); }
+  };
+}
+
+#endif //MESSAGEASSEMBLER_H
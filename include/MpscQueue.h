@@ -0,0 +1,72 @@
+#ifndef MPSCQUEUE_H
+#define MPSCQUEUE_H
+
+#include <Arduino.h>
+#include <atomic>
+
+
+// MPSC Queue Class
+// ****************
+// Bounded lock-free multi-producer / single-consumer queue with a fixed capacity.
+// Producers on any task claim a cell with compare-and-swap, every cell carries a
+// sequence number telling wether it is free, filled or being filled.
+// Capacity must be a power of two.
+template <typename T, size_t N>
+class MpscQueue {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "MpscQueue capacity must be a power of two.");
+
+private:
+    struct Cell {
+        std::atomic<uint32_t> seq;
+        T data;
+    };
+
+    Cell cells[N];
+    std::atomic<uint32_t> enqueue_pos{0};   // Shared by producers
+    uint32_t dequeue_pos = 0;               // Owned by consumer
+
+public:
+    MpscQueue() {
+        for (uint32_t i = 0; i < N; ++i) {
+            cells[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // => Push an item, safe to be called from any task. Returns false if the queue is full.
+    bool push(const T &item) {
+        uint32_t pos = enqueue_pos.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell &cell = cells[pos & (N - 1)];
+            int32_t diff = (int32_t) (cell.seq.load(std::memory_order_acquire) - pos);
+            if (diff == 0) {
+                // Cell is free, try to claim it
+                if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.data = item;
+                    cell.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                // Queue is full
+                return false;
+            } else {
+                // Another producer claimed the cell first
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // => Pop the oldest item, consumer side. Returns false if the queue is empty.
+    bool pop(T &item) {
+        Cell &cell = cells[dequeue_pos & (N - 1)];
+        int32_t diff = (int32_t) (cell.seq.load(std::memory_order_acquire) - (dequeue_pos + 1));
+        if (diff < 0) {
+            return false;
+        }
+        item = cell.data;
+        cell.seq.store(dequeue_pos + N, std::memory_order_release);
+        dequeue_pos++;
+        return true;
+    }
+};
+
+#endif //MPSCQUEUE_H
@@ -0,0 +1,74 @@
+#ifndef MQTTCLIENT_H
+#define MQTTCLIENT_H
+
+#include <Arduino.h>
+
+// Default broker, an empty host disables MQTT until configured at /mqtt
+#ifndef MQTT_HOST
+#define MQTT_HOST ""
+#endif
+#ifndef MQTT_PORT
+#define MQTT_PORT 1883
+#endif
+#ifndef MQTT_BASE_TOPIC
+#define MQTT_BASE_TOPIC "rotor"
+#endif
+
+// Sizes of the config strings, including the terminating null. Topics below the base topic
+// must fit MQTT_TOPIC_SIZE.
+#define MQTT_HOST_SIZE 64
+#define MQTT_USER_SIZE 64
+#define MQTT_PASSWORD_SIZE 64
+#define MQTT_BASE_TOPIC_SIZE 48
+
+// Interval of telemetry messages during motion, in ms
+#ifndef MQTT_TELEMETRY_INTERVAL_MS
+#define MQTT_TELEMETRY_INTERVAL_MS 500
+#endif
+
+namespace Rotor {
+    struct Snapshot;
+}
+
+
+// MQTT Client
+// ***********
+// Connects to a broker in station mode and publishes, below the base topic:
+//   status      "online" / "offline" (last will), retained
+//   state       angle, target, rotation and speed, retained, on every change of state
+//               and on angle changes at rest. Target is null unless auto-rotating.
+//   telemetry   angle, angular speed and time, rate limited, only during motion
+// Messages published to <base>/cmd take the websocket ROTOR format (e.g. ROTOR|{"rotation":0})
+// and are handled by the same handler. Other messages are rejected. Connecting and publishing never block the loop.
+namespace Mqtt {
+
+    // Broker configuration, stored in Preferences. Fixed buffers, the client keeps pointers to them.
+    struct Config {
+        char host[MQTT_HOST_SIZE] = MQTT_HOST;
+        uint16_t port = MQTT_PORT;
+        char user[MQTT_USER_SIZE] = "";
+        char password[MQTT_PASSWORD_SIZE] = "";
+        char base_topic[MQTT_BASE_TOPIC_SIZE] = MQTT_BASE_TOPIC;
+    };
+
+    // => Load config from Preferences and set up the client, to be called once in station mode
+    void init();
+
+    // => Copy of the config, including one set but not yet applied. Safe to call from any task.
+    Config getConfig();
+
+    // => Check a config and hand it to the loop, which saves it and reconnects with the next update.
+    // Safe to call from any task. Returns false if the config is invalid or the client is not set up.
+    bool setConfig(const Config &new_config);
+
+    // => Reconnect if needed and publish state changes, to be called from the loop
+    void update(const Rotor::Snapshot &state);
+
+    // => Return wether the client is connected to the broker
+    bool isConnected();
+
+    // => Print connection and message counters to Serial
+    void printStats();
+}
+
+#endif //MQTTCLIENT_H
@@ -0,0 +1,17 @@
+#ifndef PARSERBENCHMARK_H
+#define PARSERBENCHMARK_H
+
+#include <Arduino.h>
+
+
+// Parser Benchmark
+// ****************
+// Compares parse time per inbound message type of the in-place parser against
+// String identifiers with ArduinoJson documents. Enabled with -D PARSER_BENCHMARK=N.
+namespace ParserBenchmark {
+
+    // => Parse every sample message N times with both parsers and print µs per message
+    void run(const uint32_t iterations);
+}
+
+#endif //PARSERBENCHMARK_H
@@ -0,0 +1,157 @@
+#ifndef POSITIONLOG_H
+#define POSITIONLOG_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <atomic>
+
+#define LOG_DIR "/log"
+
+// Segment files are closed at this size, in bytes
+#ifndef LOG_SEGMENT_SIZE
+#define LOG_SEGMENT_SIZE 16384
+#endif
+
+// Oldest segments are removed above this count, bounds the log to about 128 kB
+#ifndef LOG_MAX_SEGMENTS
+#define LOG_MAX_SEGMENTS 8
+#endif
+
+// Records are collected in RAM and written once the batch is full or old
+#ifndef LOG_BATCH_SIZE
+#define LOG_BATCH_SIZE 1024
+#endif
+#ifndef LOG_FLUSH_INTERVAL_MS
+#define LOG_FLUSH_INTERVAL_MS 300000
+#endif
+
+// Resolution of record times, in ms
+#define LOG_TIME_UNIT_MS 100
+
+// Record tag: state bits of the rotor and the record type
+#define LOG_TAG_STATE_MASK 0x07         // Same bits as HISTORY_ROTATING, HISTORY_CW, HISTORY_AUTO
+#define LOG_TAG_SPEED 0x08              // Sample carries a speed byte
+#define LOG_TAG_EVENT 0x20
+#define LOG_TAG_KEYFRAME 0x40
+
+// Events written to the log
+enum LogEvent : uint8_t {
+    LOG_EVENT_BOOT = 1,                 // Argument: boot counter
+    LOG_EVENT_AUTO_ABORTED,             // Auto rotation timed out, argument: target in °
+    LOG_EVENT_CLIENTS_LOST,             // All clients disconnected, rotor stopped
+    LOG_EVENT_WIFI_LOST,
+    LOG_EVENT_FIRMWARE_UPDATE
+};
+
+
+namespace Rotor {
+
+    struct Snapshot;
+
+    // Position Log Class
+    // ******************
+    // Append-only log of rotor positions and events in segment files on LittleFS.
+    // Every batch starts with a keyframe (boot, unix time, ms since boot, angle, speed),
+    // followed by delta records like the rotation history, in LOG_TIME_UNIT_MS:
+    //   sample: tag, varint time step, zigzag varint angle change, [speed]
+    //   event:  tag, varint time step, varint event, varint argument
+    // Each segment has an index file with the unix time and offset of every batch,
+    // so downloads of a time range skip to the first batch they need.
+    class PositionLog {
+    private:
+        uint8_t batch[LOG_BATCH_SIZE];
+        size_t batch_len = 0;
+        uint32_t batch_unix = 0;        // Unix time of the keyframe, 0 if the clock was not set
+        unsigned long batch_start_ms = 0;
+
+        // Last record, base of the next delta
+        struct {
+            uint32_t ms = 0;
+            int32_t angle = 0;
+            uint8_t speed = 0;
+            uint8_t state = 0;
+        } last;
+        bool has_last = false;
+
+        uint32_t boot_id = 0;
+        uint32_t first_seq = 0;         // Oldest segment, 0 if there is none
+        uint32_t last_seq = 0;          // Segment being appended to
+        size_t segment_size = 0;
+        bool is_ready = false;
+
+        // Guards segment files against removal while a download reads them
+        SemaphoreHandle_t lock = nullptr;
+        std::atomic<uint8_t> n_readers{0};
+
+        // => Make room for a record, writes the batch if it is full
+        void reserve(const size_t len);
+
+        // => Start a batch with an absolute keyframe
+        void writeKeyframe(const uint32_t ms);
+
+        // => Remove oldest segments above LOG_MAX_SEGMENTS, unless a download is running
+        void removeOldSegments();
+
+        friend class LogReader;
+
+    public:
+        // Statistics since boot
+        uint32_t n_records = 0;
+        uint32_t n_batches = 0;
+        uint32_t n_bytes_written = 0;
+        uint32_t n_segments_removed = 0;
+
+        PositionLog() {};
+
+        // => Find segments on the filesystem and log the boot, to be called once after mounting it
+        bool init(const uint32_t boot, const Snapshot &state);
+
+        // => Log a sample if the rotor moved, changed state or was idle for long
+        void record(const Snapshot &state);
+
+        // => Log an event
+        void event(const LogEvent code, const uint32_t arg = 0);
+
+        // => Write the batch if it is full or old, or always if forced. To be called from the loop.
+        void flush(const bool force = false);
+
+        // => Path of a segment or index file
+        static void path(char *buffer, const size_t len, const uint32_t seq, const bool index);
+
+        // => Total size of all segments, in bytes
+        size_t totalSize() const;
+
+        // => Print size and write statistics to Serial
+        void printStats() const;
+    };
+
+    // Log Reader Class
+    // ****************
+    // Streams segment files of a time range as they are stored, in pieces of any size.
+    // Only one piece is held in RAM, segments are not removed while a reader exists.
+    class LogReader {
+    private:
+        PositionLog &log;
+        const uint32_t from_unix;       // 0: from the start of the log
+        const uint32_t to_unix;         // 0: to the end of the log
+        uint32_t seq = 0;               // Segment being read
+        File file;
+        size_t end = 0;                 // End of the range in the segment
+        uint8_t header_pos = 0;
+
+        // => Open the next segment and seek to the first batch in range, false at the end of the log
+        bool nextSegment();
+
+    public:
+        LogReader(PositionLog &log, const uint32_t from_unix, const uint32_t to_unix);
+        ~LogReader();
+
+        // => Write up to max_len bytes to buffer, returns 0 at the end of the range
+        size_t read(uint8_t *buffer, const size_t max_len);
+    };
+}
+
+// Expose global log instance
+extern Rotor::PositionLog position_log;
+
+#endif //POSITIONLOG_H
@@ -0,0 +1,59 @@
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <Arduino.h>
+#include <atomic>
+
+
+// Ring Buffer Class
+// *****************
+// Lock-free single-producer / single-consumer ring buffer with a fixed capacity.
+// The producer (e.g. an ISR-driven reader task) only writes head, the consumer
+// only writes tail, so no locks are required. Capacity must be a power of two.
+template <typename T, size_t N>
+class RingBuffer {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "RingBuffer capacity must be a power of two.");
+
+private:
+    T buffer[N];
+    std::atomic<uint32_t> head{0};      // Next index to write, owned by producer
+    std::atomic<uint32_t> tail{0};      // Next index to read, owned by consumer
+
+public:
+    RingBuffer() {};
+
+    // => Push an item, producer side. Returns false if the buffer is full.
+    bool push(const T &item) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= N) {
+            return false;
+        }
+        buffer[h & (N - 1)] = item;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // => Pop the oldest item, consumer side. Returns false if the buffer is empty.
+    bool pop(T &item) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = buffer[t & (N - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // => Number of items currently stored
+    size_t size() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+
+    // => Return wether buffer is empty
+    bool empty() const { return size() == 0; }
+
+    // => Capacity of buffer
+    constexpr size_t capacity() const { return N; }
+};
+
+#endif //RINGBUFFER_H
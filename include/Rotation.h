@@ -4,10 +4,21 @@
 #include <Arduino.h>
 #include <Adafruit_ADS1X15.h>
 #include <Preferences.h>
+#include <atomic>
+
+#include <RingBuffer.h>
+
+#define ADC_SAMPLE_BUFFER_SIZE 32
 
 
 namespace Rotor {
 
+    // A single timestamped ADC conversion result
+    struct ADCSample {
+        unsigned long us;       // micros() at end of conversion
+        int16_t value;          // Raw ADC value
+    };
+
     // Rotor Rotation Class
     // ********************
     // Handles the I/O stuff and calibration of the real rotor
@@ -17,9 +28,28 @@ namespace Rotor {
         Adafruit_ADS1115 adc;
         bool ads_failed = false;
 
+        // Samples pushed by the ADC reader task, consumed by update()
+        RingBuffer<ADCSample, ADC_SAMPLE_BUFFER_SIZE> samples;
+        TaskHandle_t reader_task = nullptr;
+
+        // => Start ADS1115 in continuous-conversion mode and launch reader task
+        void startContinuousConversion();
+
+        // => Reader task, reads a new conversion result whenever ALERT/RDY signals one
+        static void readerTask(void *param);
+
+        // => Buffer a sample for the control task, counts samples lost to a full buffer
+        void pushSample(const ADCSample &sample);
+
+        // => Compute volts and angle from a raw ADC sample
+        void applySample(const ADCSample &sample);
+
         // PREFS for calibration parameters
         Preferences cal_prefs;
 
+        // Calibration changed by the control task, still to be saved by the loop
+        std::atomic<bool> calibration_changed{false};
+
         // => Save calibration factors to PREFS
         void saveCalibration();        
 
@@ -30,11 +60,22 @@ namespace Rotor {
         void applyCalibration();
 
     public:
-        // Last rotor values
-        unsigned long last_ms = 0.0;
+        // Last rotor values, times are when the last sample was converted
+        unsigned long last_ms = 0;
+        unsigned long last_us = 0;
         uint16_t last_adc_value = 0;
         float last_adc_volts = 0.0;
         float last_angle = 0.0;
+
+        // Time of the last relay GPIO change, in µs
+        mutable unsigned long relay_us = 0;
+
+        // ADC sampling statistics
+        struct {
+            uint16_t rate = 0;              // Samples per second
+            uint32_t n_samples = 0;         // Samples read from ADC
+            uint32_t n_overruns = 0;        // Samples lost due to full buffer
+        } sampling;
         
         // Calibration parameters
         struct {
@@ -50,23 +91,27 @@ namespace Rotor {
         // => Initialistion, call from setup()
         bool init();
 
-        // => Set calibration factors and apply and save
+        // => Set calibration factors and apply, saved by saveChangedCalibration()
         void calibrate(const float u1, const float u2,
                        const float a1, const float a2);
 
-        // => Set constant angle-offset and save calibration
+        // => Set constant angle-offset, saved by saveChangedCalibration()
         void setAngleOffset(const float offset);
 
+        // => Save calibration to PREFS if it changed, to be called from loop().
+        // Writing flash stalls the calling task, so the control task doesn't.
+        void saveChangedCalibration();
+
         // => Return ADC status
         bool getADCStatus() { return !ads_failed; }
 
-        // => Get current raw ADC value
+        // => Get current raw ADC value, from last update()
         uint16_t getADCValue();
 
-        // => Get current ADC voltage
+        // => Get current ADC voltage, from last update()
         float getADCVolts();
 
-        // => Get current rotor's azimuth angle, a new value is pulled from ADC
+        // => Get current rotor's azimuth angle, from last update()
         float getAngle();
 
         // => Start rotation in given direction
@@ -78,8 +123,19 @@ namespace Rotor {
         // => Set DAC voltage on speed pin
         void setSpeedDAC(const uint8_t speed) const;
 
-        // => Read ADC and update last rotor position values
-        void update();        
+        // => Read the last conversion result, finished at given time, into the sample buffer.
+        // Must only be called from the reader task, which is the buffer's sole producer.
+        void readConversion(const unsigned long us);
+
+        // => Consume the oldest buffered ADC sample and update last rotor position values.
+        // Returns false if no sample is buffered.
+        // Must only be called from the control task, which is the buffer's sole consumer.
+        bool nextSample();
+
+        // => Consume all buffered ADC samples, last rotor position values are from the newest.
+        // Does not block, conversions are read by the reader task.
+        // Must only be called from the control task, which is the buffer's sole consumer.
+        void update();
     };
 }
 
@@ -0,0 +1,137 @@
+#ifndef ROTATIONHISTORY_H
+#define ROTATIONHISTORY_H
+
+#include <Arduino.h>
+
+// Delta records per block, each block starts with an absolute sample
+#ifndef HISTORY_BLOCK_SIZE
+#define HISTORY_BLOCK_SIZE 512
+#endif
+
+// Blocks in the ring, the oldest block is overwritten when all are full
+#ifndef HISTORY_BLOCKS
+#define HISTORY_BLOCKS 24
+#endif
+
+// Resolution of sample times, in ms
+#define HISTORY_TIME_UNIT_MS 10
+
+// State bits of a history sample
+#define HISTORY_ROTATING 0x01
+#define HISTORY_CW 0x02
+#define HISTORY_AUTO 0x04
+#define HISTORY_STATE_MASK 0x07
+// Record carries a speed byte
+#define HISTORY_SPEED_CHANGED 0x08
+
+
+namespace Rotor {
+
+    struct Snapshot;
+
+    // Decoded history sample
+    struct HistorySample {
+        uint32_t ms = 0;                // Device millis
+        int32_t angle = 0;              // in 1/100 °
+        uint8_t speed = 0;              // Current speed, 0% to 100%
+        uint8_t state = 0;              // HISTORY_* bits
+    };
+
+    // Absolute first sample of a block, followed by len bytes of delta records.
+    // Sent as is in binary exports, little-endian.
+    struct __attribute__((packed)) HistoryBlockHeader {
+        uint16_t len = 0;
+        uint32_t ms = 0;
+        int32_t angle = 0;
+        uint8_t speed = 0;
+        uint8_t state = 0;
+    };
+
+    struct HistoryBlock {
+        uint32_t seq = 0;               // Increases with every new block, 0 if unused
+        uint32_t last_ms = 0;           // Time of the last sample
+        HistoryBlockHeader header;
+        uint8_t data[HISTORY_BLOCK_SIZE];
+    };
+
+    // Rotation History Class
+    // **********************
+    // Fixed-size in-RAM ring of timestamped angle, speed and state samples.
+    // Samples are delta encoded: a state byte, the time since the last sample in
+    // HISTORY_TIME_UNIT_MS as varint, the angle change as zigzag varint and the
+    // speed only if it changed. A stationary rotor costs 3 bytes per sample.
+    class RotationHistory {
+    private:
+        HistoryBlock blocks[HISTORY_BLOCKS];
+        uint8_t head = 0;               // Block being written
+        uint32_t next_seq = 1;
+        HistorySample last;             // Last recorded sample, base of the next delta
+        bool has_last = false;
+        SemaphoreHandle_t lock = nullptr;
+
+        // => Start a new block with an absolute sample, overwrites the oldest block
+        void startBlock(const HistorySample &sample);
+
+    public:
+        // Statistics since boot
+        uint32_t n_samples = 0;
+        uint32_t n_blocks = 0;
+
+        RotationHistory() {};
+
+        // => Create lock, to be called once before recording
+        void init();
+
+        // => Record a sample if the rotor moved, changed state or was idle for long
+        void record(const Snapshot &state);
+
+        // => Append a sample, delta encoded
+        void append(const HistorySample &sample);
+
+        // => Copy the oldest block with a sequence number above seq that ends at or after since_ms.
+        // Returns false if there is none.
+        bool copyBlock(const uint32_t seq, const uint32_t since_ms, HistoryBlock &block) const;
+
+        // => Decode the next sample of a block at pos, starting from the block header.
+        // Returns false at the end of the block.
+        static bool decode(const HistoryBlock &block, size_t &pos, HistorySample &sample);
+
+        // => Bytes in use by encoded samples
+        size_t usedBytes() const;
+    };
+
+    // History Reader Class
+    // ********************
+    // Streams the history as binary blocks or as CSV, in pieces of any size.
+    // Blocks are copied one at a time, so the history keeps recording meanwhile.
+    class HistoryReader {
+    private:
+        const RotationHistory &history;
+        const uint32_t since_ms;
+        const bool csv;
+        HistoryBlock block;
+        bool has_block = false;
+        size_t pos = 0;                 // Read position in the block
+        HistorySample sample;
+        char line[48];                  // Pending output, stream header or CSV line
+        size_t line_len = 0;
+        size_t line_pos = 0;
+
+        // => Copy the next block, false at the end of the history
+        bool nextBlock();
+
+        // => Fill the pending line, false at the end of the history
+        bool nextLine();
+
+    public:
+        HistoryReader(const RotationHistory &history, const uint32_t since_ms, const bool csv);
+
+        // => Write up to max_len bytes to buffer, returns 0 at the end of the history
+        size_t read(uint8_t *buffer, const size_t max_len);
+    };
+}
+
+// Expose global history instance
+extern Rotor::RotationHistory rotation_history;
+
+#endif //ROTATIONHISTORY_H
@@ -0,0 +1,54 @@
+#ifndef ROTCTLD_H
+#define ROTCTLD_H
+
+#include <Arduino.h>
+
+#include <RotorCommands.h>
+
+// Default port of Hamlib's rotctld
+#ifndef ROTCTLD_PORT
+#define ROTCTLD_PORT 4533
+#endif
+
+// Concurrent rotctld connections
+#ifndef ROTCTLD_MAX_CLIENTS
+#define ROTCTLD_MAX_CLIENTS 4
+#endif
+
+#define ROTCTLD_LINE_SIZE 64
+
+
+// Rotctld Server
+// **************
+// Native Hamlib rotctld listener, so logging and satellite software can control the rotor
+// without a bridge. Speaks the rotctld line protocol (p, P az el, S, M dir speed, _ and
+// \dump_state plus their long forms). Motion commands are posted to the control task,
+// positions come from the last published rotor state. Elevation is always 0.
+namespace Rotctld {
+
+    // Number of connected rotctld clients
+    extern uint8_t clients_connected;
+
+    // Partly received line of one connection
+    struct LineBuffer {
+        char line[ROTCTLD_LINE_SIZE];
+        size_t len = 0;
+        bool overflow = false;
+    };
+
+    // Response callback of a connection
+    typedef void (*Respond)(void* ctx, const char* response);
+
+    // => Collect received bytes and handle complete lines, lines may span several TCP segments.
+    // Motion commands are handed to post. Returns false once the client asked to quit.
+    bool feed(LineBuffer &buffer, const char* data, const size_t len, Rotor::PostCommand post,
+              Respond respond, void* ctx);
+
+    // => Start listening on ROTCTLD_PORT
+    void initServer();
+
+    // => Print connection and command counters to Serial
+    void printStats();
+}
+
+#endif //ROTCTLD_H
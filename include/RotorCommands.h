@@ -0,0 +1,137 @@
+#ifndef ROTORCOMMANDS_H
+#define ROTORCOMMANDS_H
+
+#include <Arduino.h>
+#include <MpscQueue.h>
+#include <RingBuffer.h>
+
+#define COMMAND_QUEUE_SIZE 16
+#define ACK_QUEUE_SIZE 16
+#define LATENCY_BINS 8
+
+
+namespace Rotor {
+
+    enum class CommandType : uint8_t {
+        NONE,
+        STOP,
+        ROTATE,             // Start rotating in direction
+        ROTATE_TO,          // Auto-rotate to target
+        SET_SPEED,
+        SET_CALIBRATION,
+        SET_OFFSET
+    };
+
+    // Rotor Command
+    // *************
+    // Fixed-size command, parsed by network handlers and applied by the control task
+    struct Command {
+        CommandType type = CommandType::NONE;
+        uint8_t direction = 0;              // ROTATE: 0: CCW, 1: CW
+        uint8_t speed = 0;                  // SET_SPEED: 0% to 100%
+        bool use_overlap = true;            // ROTATE_TO
+        bool use_smooth_speed = false;      // ROTATE_TO
+        float values[4] = {0.0f};           // ROTATE_TO: target | SET_CALIBRATION: u1, u2, a1, a2 | SET_OFFSET: offset
+
+        // Origin, set by network handlers
+        uint32_t rx_us = 0;                 // Time the message was received, 0 if not from a client
+        uint32_t client_id = 0;             // Client to acknowledge to, 0 if no ack requested
+        uint32_t seq = 0;                   // Sequence number given by the client
+
+        // => Command factories
+        static Command stop() {
+            Command cmd;
+            cmd.type = CommandType::STOP;
+            return cmd;
+        }
+
+        static Command rotate(const uint8_t dir) {
+            Command cmd;
+            cmd.type = CommandType::ROTATE;
+            cmd.direction = dir;
+            return cmd;
+        }
+
+        static Command rotateTo(const float target, const bool use_overlap, const bool use_smooth_speed) {
+            Command cmd;
+            cmd.type = CommandType::ROTATE_TO;
+            cmd.values[0] = target;
+            cmd.use_overlap = use_overlap;
+            cmd.use_smooth_speed = use_smooth_speed;
+            return cmd;
+        }
+
+        static Command setSpeed(const uint8_t spd) {
+            Command cmd;
+            cmd.type = CommandType::SET_SPEED;
+            cmd.speed = spd;
+            return cmd;
+        }
+
+        static Command setCalibration(const float u1, const float u2, const float a1, const float a2) {
+            Command cmd;
+            cmd.type = CommandType::SET_CALIBRATION;
+            cmd.values[0] = u1;
+            cmd.values[1] = u2;
+            cmd.values[2] = a1;
+            cmd.values[3] = a2;
+            return cmd;
+        }
+
+        static Command setOffset(const float offset) {
+            Command cmd;
+            cmd.type = CommandType::SET_OFFSET;
+            cmd.values[0] = offset;
+            return cmd;
+        }
+    };
+
+    // Mailbox between network handlers (producers) and the control task (consumer)
+    typedef MpscQueue<Command, COMMAND_QUEUE_SIZE> CommandQueue;
+
+    // Hands a parsed command on, returns false if it was not taken. Protocol parsers get it
+    // passed in, so they run without the control task, e.g. in host tests.
+    typedef bool (*PostCommand)(const Command &cmd);
+
+    // Acknowledgement of an applied command, all times in device µs
+    struct CommandAck {
+        uint32_t client_id = 0;
+        uint32_t seq = 0;
+        uint32_t rx_us = 0;                 // Message received
+        uint32_t applied_us = 0;            // Command applied by the control task
+    };
+
+    // Acks from the control task (producer) to the loop (consumer)
+    typedef RingBuffer<CommandAck, ACK_QUEUE_SIZE> AckQueue;
+
+    // Latency Histogram
+    // *****************
+    // Time from a command message being received to the command being applied, or to the
+    // relay GPIO change for commands that start or stop the rotor.
+    // Bin i counts latencies below 2^i ms, the last bin all longer ones.
+    struct LatencyHistogram {
+        uint32_t bins[LATENCY_BINS] = {0};
+        uint32_t n = 0;
+        uint32_t max_us = 0;
+        uint64_t sum_us = 0;
+
+        // => Add a latency
+        void add(const uint32_t us) {
+            uint8_t bin = 0;
+            while (bin < LATENCY_BINS - 1 && us >= (1000UL << bin)) {
+                ++bin;
+            }
+            bins[bin]++;
+            n++;
+            max_us = max(max_us, us);
+            sum_us += us;
+        }
+
+        // => Upper limit of a bin in ms, -1 for the last one, which has no upper limit
+        static int32_t binLimitMs(const uint8_t bin) {
+            return bin < LATENCY_BINS - 1 ? 1L << bin : -1;
+        }
+    };
+}
+
+#endif //ROTORCOMMANDS_H
@@ -3,12 +3,32 @@
 
 #include <Arduino.h>
 #include <Timer.h>
+#include <SeqLock.h>
 #include <Rotation.h>
 #include <RotorMessenger.h>
+#include <RotorCommands.h>
+#include <CoastModel.h>
+#include <AngleEstimator.h>
 
 
 namespace Rotor {
 
+    // Consistent copy of the rotor state, published by the control task
+    struct Snapshot {
+        unsigned long ms = 0;
+        float adc_volts = 0.0f;
+        float angle = 0.0f;
+        float angular_speed = 0.0f;
+        float confidence = 0.0f;
+        float target = 0.0f;
+        bool is_rotating = false;
+        bool is_auto_rotating = false;
+        bool smooth_speed_active = false;
+        uint8_t direction = 0;
+        uint8_t max_speed = 0;
+        uint8_t current_speed = 0;
+    };
+
     // Rotor Controller Class
     // **********************
     // Controls rotor state and rotor-messenger
@@ -18,7 +38,7 @@ namespace Rotor {
         struct {
             const int max_angle = 449;
             const uint8_t min_distance = 2;
-            const float tolerance = 0.7f;
+            const float tolerance = 0.7f;       // Accepted final error, stop distance without coast prediction
             uint8_t timeout_counter = 0;
             const unsigned long timeout = 4000;
             const unsigned long counter_interval = 500;
@@ -26,11 +46,20 @@ namespace Rotor {
             Timer timer;
         } auto_rot;
 
-        // Rotor angle from previous angular speed calculation
+        // Settling after auto-rotation, rotor coasts after relays were cut
         struct {
-            unsigned long last_ms = 0;
-            float last_angle = 0.0f;
-        } previous;
+            bool active = false;
+            const unsigned long timeout = 4000;
+            unsigned long start_ms = 0;         // Start of auto-rotation
+            unsigned long cut_ms = 0;           // Relays cut
+            float cut_angle = 0.0f;
+            float cut_angular_speed = 0.0f;
+            uint8_t cut_speed = 0;              // DAC speed when relays were cut
+            float predicted_coast = 0.0f;
+        } settling;
+
+        // Learned coast distances
+        CoastModel coast_model;
 
         // Speed ramp variables
         struct {
@@ -50,6 +79,15 @@ namespace Rotor {
         // => Set current rotor speed (DAC), doesn't distribute to clients
         void setCurrentSpeed(const uint8_t spd);
 
+        // Last published rotor state
+        SeqLock<Snapshot> snapshot;
+
+        // Commands posted by other tasks, applied by the control task
+        CommandQueue commands;
+
+        // => Apply a single command
+        void applyCommand(const Command &cmd);
+
 
     public:
         // Rotor state
@@ -60,23 +98,54 @@ namespace Rotor {
         uint8_t direction = 0;              // 0: CCW, 1: CW
         uint8_t max_speed = 0;              // 0% to 100%
         uint8_t current_speed = 0;          // 0% to max_speed
-        float angular_speed = 0.0f;         // in °/s
+        float angle = 0.0f;                 // Filtered angle in °
+        float angular_speed = 0.0f;         // Filtered angular speed in °/s, 0 if stationary
 
         // Settings
         struct {
             bool use_overlap = true;
             bool use_smooth_speed = true;
+            bool use_coast_prediction = true;
         } settings;
 
-        // Messenger and rotor instances
+        // Auto-rotation statistics since boot
+        struct {
+            uint32_t n_completed = 0;
+            uint32_t n_aborted = 0;
+            uint32_t n_outside_tolerance = 0;   // Completed, but settled beyond the tolerance
+            float last_error = 0.0f;            // Final angle - target, in °
+            float max_abs_error = 0.0f;
+            float sum_abs_error = 0.0f;
+            unsigned long last_time_ms = 0;     // Time from start to settled rotor
+            unsigned long sum_time_ms = 0;
+        } auto_rot_stats;
+
+        // Acknowledgements of applied commands, consumed by the loop
+        AckQueue acks;
+
+        // Command latency, frame received to command applied or relay change, written by the control task
+        LatencyHistogram command_latency;
+
+        // Messenger, rotor and estimator instances
         Messenger messenger;
         Rotation rotor;
+        AngleEstimator estimator;
 
         RotorController() {};
 
         // => Initialisation, to be called from setup()
         bool init();
 
+        // => Post a command to the control task, safe to be called from any task.
+        // Returns false if the command queue is full.
+        bool post(const Command &cmd);
+
+        // => Apply all posted commands, to be called from the control task at the start of each tick
+        void applyCommands();
+
+        // The following commands must only be called from the control task,
+        // other tasks post() them instead.
+
         // => Start rotating in given direction, distribute new state to clients
         void startRotation(const uint8_t dir);
 
@@ -87,7 +156,8 @@ namespace Rotor {
         // Is applied to DAC only if speed is not ramping up / down.
         void setMaxSpeed(const uint8_t spd);
 
-        // => Set calibration parameters, distribute new state to clients
+        // => Set calibration parameters, distribute new state to clients.
+        // Saved to PREFS by savePending().
         void setCalibration(const float u1, const float u2,
                             const float a1, const float a2);
 
@@ -104,15 +174,49 @@ namespace Rotor {
         // If angular-speed is zero 3s into auto-rotation, start 3s timeout.
         void watchAutoRotation();
 
+        // => Finish auto-rotation once the rotor came to rest after the relays were cut.
+        // Learns the coast distance and updates auto-rotation statistics.
+        // To be called continously from the control task while settling.
+        void watchSettling();
+
+        // => Return wether rotor is settling after an auto-rotation
+        bool isSettling() const { return settling.active; }
+
+        // => Print auto-rotation statistics to Serial
+        void printAutoRotationStats() const;
+
         // => Set smooth speed to DAC.
         // To be called continously from main loop if speed ramp is active
         void watchSmoothSpeedRamp();
 
-        // => Update rotor values from ADC and calculate angular speed
-        void update(bool with_angular_speed = false);
+        // => Feed all new ADC samples to the estimator and update filtered angle and angular speed
+        void update();
+
+        // => A single control cycle: apply commands, update rotor, watch auto-rotation and speed ramp,
+        // publish the new state. To be called from the control task only.
+        void tick();
+
+        // => Create a snapshot from the current rotor state
+        Snapshot makeSnapshot() const;
+
+        // => Publish current rotor state and release messages marked during this tick,
+        // to be called from the control task only
+        void publishSnapshot();
+
+        // => Save calibration and learned coast distances changed by the control task to PREFS,
+        // to be called from loop()
+        void savePending();
+
+        // => Get last published rotor state, safe to be called from any task
+        Snapshot getSnapshot() const { return snapshot.read(); }
     };
 }
 
 extern Rotor::RotorController rotor_ctrl;
 
+namespace Rotor {
+    // => Post a command to the control task of rotor_ctrl, the PostCommand of network handlers
+    inline bool postToControl(const Command &cmd) { return rotor_ctrl.post(cmd); }
+}
+
 #endif //ROTORCONTROLLER_H
@@ -2,43 +2,140 @@
 #define ROTORMESSENGER_H
 
 #include <Arduino.h>
+#include <atomic>
+
+// Rotor message fields, marked dirty when changed and sent with the next flush
+#define MSG_FIELD_ROTATION 0x01
+#define MSG_FIELD_ANGLE 0x02
+#define MSG_FIELD_SPEED 0x04
+#define MSG_FIELD_TARGET 0x08
+#define MSG_FIELD_CALIBRATION 0x10
+#define MSG_FIELDS_ROTOR (MSG_FIELD_ROTATION | MSG_FIELD_ANGLE | MSG_FIELD_SPEED | MSG_FIELD_TARGET)
+// Marks a state change by the control task, frames with state changes are never held back
+#define MSG_STATE_CHANGE 0x80
 
 
 namespace Rotor {
 
     class RotorController;
+    struct Snapshot;
+
+    // Binary telemetry frames
+    // ***********************
+    // Sent instead of the JSON rotor messages to clients that negotiated binary frames
+    // with PROTOCOL|{"binary":true}. Fixed layout, little-endian, angles in 1/100 °.
+    enum FrameType : uint8_t {
+        FRAME_ROTATION = 1
+    };
+
+    // Flags of a rotation frame, tell which fields are valid.
+    // Angle frames also carry time and angular speed, so clients can interpolate.
+    #define FRAME_HAS_ANGLE 0x01
+    #define FRAME_HAS_TARGET 0x02
+    #define FRAME_HAS_SPEED 0x04
+
+    struct __attribute__((packed)) RotationFrame {
+        uint8_t type = FRAME_ROTATION;
+        int8_t rotation = 0;            // -1: CCW, 0: stop, 1: CW
+        uint8_t flags = 0;
+        int32_t angle = 0;              // in 1/100 °
+        uint16_t adc_mv = 0;            // in mV
+        int32_t target = 0;             // in 1/100 °
+        uint8_t speed = 0;              // 0% to 100%
+        uint32_t t = 0;                 // Time of the angle measurement, device millis
+        int16_t v = 0;                  // Angular speed, in 1/100 °/s
+    };
+
+    // Cost of one telemetry format, since last report
+    struct TelemetryStats {
+        uint32_t n_frames = 0;
+        uint32_t n_bytes = 0;           // Sent bytes, summed over all receiving clients
+        uint32_t serialize_us = 0;      // Time spent building frames
+    };
 
     // Rotor Messenger Class
     // *********************
-    // Handles outgoing messages with rotor data
+    // Handles outgoing messages with rotor data.
+    // Send requests only mark fields dirty, flush() merges all changes since the
+    // last flush into at most one frame per client and format.
     class Messenger {
     private:
-        String msg_buffer;
+        String msg_buffer;              // Text frame, rebuilt per distinct subscription
+        String settings_buffer;         // Changed settings of this flush
+        String calibration_buffer;      // Calibration of this flush
+
+        // Last calibration message, reused for connect snapshots
+        String calibration_msg;
+        SemaphoreHandle_t calibration_lock = nullptr;
+
+        // Dirty fields. Fields marked by the control task stay pending until the
+        // snapshot containing the change is published.
+        uint8_t pending = 0;
+        std::atomic<uint8_t> dirty{0};
+        std::atomic<uint32_t> n_requests{0};
+
+        // => Mark fields of the published snapshot dirty, safe to be called from any task
+        void markDirty(const uint8_t fields);
 
-        // => Create rotation JSON message from last rotor values and save in msg_buffer
-        void setLastRotationMsg(const bool with_angle);
+        // => Mark fields dirty once the next snapshot is published, control task only
+        void markPending(const uint8_t fields);
+
+        // => Append rotor JSON message with given fields to buffer
+        void appendRotorMsg(String &buffer, const Snapshot &state, const uint8_t fields) const;
+
+        // => Create binary rotation frame with given fields from rotor state
+        void setRotationFrame(RotationFrame &frame, const Snapshot &state, const uint8_t fields) const;
+
+        // Statistics since last report, written by the sending task
+        unsigned long stats_start_ms = 0;
 
     public:
+        // Telemetry statistics per format
+        TelemetryStats json_stats;
+        TelemetryStats binary_stats;
+
+        // Frames that were merged into others by flush(), since boot
+        uint32_t n_frames_saved = 0;
+
         // Pointer to rotor instance, declared in parent class
         RotorController* rotor_ptr;
 
         // Constructor
         Messenger();
 
-        // => Send last rotation valueset
+        // => Initialisation, to be called once rotor_ptr is set
+        void init();
+
+        // => Send last rotation valueset, to be called from the control task only
         void sendLastRotation(const bool with_angle);
 
-        // => Send new rotation values from ADC, always includes angle
+        // => Send newest published rotation values, always includes angle
         void sendNewRotation();
 
-        // => Send max speed
+        // => Send max speed, to be called from the control task only
         void sendSpeed();
 
-        // => Send current calibration parameters
+        // => Send current calibration parameters, to be called from the control task only
         void sendCalibration();
 
-        // => Send auto rotation target
+        // => Send auto rotation target, to be called from the control task only
         void sendTarget();
+
+        // => Release fields marked by the control task, called after publishing a snapshot
+        void releasePending();
+
+        // => Send all dirty fields and settings as one frame per client,
+        // filtered by the topics the client subscribed to. To be called once per loop cycle.
+        void flush();
+
+        // => Append last calibration message to a connect snapshot, safe to be called from any task
+        void appendCalibration(String &buffer);
+
+        // => Append rotor state, speed and target from the last published snapshot to a connect snapshot
+        void appendRotorState(String &buffer);
+
+        // => Print bytes per second and serialization time per frame of both formats, reset statistics
+        void printTelemetryStats();
     };
 }
 
@@ -7,6 +7,10 @@
 
 #include <globals.h>
 
+// Cache policies of embedded assets, the app index is revalidated daily
+#define ASSET_CACHE_CONTROL "private, max-age=31536000"
+#define INDEX_CACHE_CONTROL "private, max-age=86400"
+
 
 namespace RotorServer {
 
@@ -15,6 +19,42 @@ namespace RotorServer {
     // @return False if not authenticated but required, else true
     bool authenticateRequest(AsyncWebServerRequest *request);
 
+    // Web asset, entry of the generated table in AppAssetTable.h or of the UI partition
+    struct Asset {
+        const char* path;
+        const char* content_type;
+        const uint8_t* data;
+        size_t len;
+        const char* etag;               // Quoted content hash
+        const char* cache_control;
+        bool gzip;                      // Data is gzip compressed
+        bool needs_auth;                // Only sent to authenticated clients
+    };
+
+    // Embedded asset responses since boot, compare before and after clients cached them
+    struct AssetStats {
+        uint32_t n_requests = 0;
+        uint32_t n_not_modified = 0;    // Answered with 304, client had the current version
+        uint32_t n_not_found = 0;       // File paths without an asset, answered with 404
+        uint32_t n_bytes_sent = 0;      // Asset bytes sent in 200 responses
+        uint32_t n_bytes_saved = 0;     // Asset bytes not sent thanks to 304 responses
+    };
+
+    extern AssetStats asset_stats;
+
+    // => Find a web asset by path, binary search in the sorted asset table or UI archive
+    // @return False if there is none
+    bool findAsset(const char* path, Asset &asset);
+
+    // => Send an embedded asset with its ETag, or 304 Not Modified if If-None-Match matches it
+    void sendAsset(AsyncWebServerRequest *request, const Asset &asset);
+
+    // => Send the embedded asset at the request's path or 404, without the app index
+    void serveStaticAsset(AsyncWebServerRequest *request);
+
+    // => Print asset statistics to Serial
+    void printAssetStats();
+
     // Rotor Server Class
     // ------------------
     // - wraps AsyncWebServer
@@ -0,0 +1,58 @@
+#ifndef ROTORSIMULATOR_H
+#define ROTORSIMULATOR_H
+
+#include <Arduino.h>
+
+
+namespace Rotor {
+
+    // Rotor Simulator Class
+    // *********************
+    // Physical model of a Yaesu rotor and its control unit, replaces relays, speed DAC
+    // and ADS1115 when built with SIMULATE_ROTOR. Models inertia, speed vs. DAC response,
+    // coasting after the relays are cut, end stops and ADC noise.
+    class Simulator {
+    private:
+        unsigned long last_us = 0;
+
+        // => Gaussian random number with standard deviation 1
+        float randomGauss() const;
+
+    public:
+        // Model parameters
+        struct {
+            float full_speed = 6.5f;            // °/s at 5 V control voltage
+            float dac_max_fraction = 0.66f;     // DAC (3.3 V) reaches 66 % of full speed
+            float min_speed = 0.4f;             // °/s, motor barely turns at lowest DAC voltage
+            float accel_tau = 0.35f;            // s, time constant when motor is driven
+            float coast_tau = 0.25f;            // s, time constant when motor coasts
+            float end_stop_low = -5.0f;         // °, mechanical end stops
+            float end_stop_high = 455.0f;
+            float volts_per_degree = 4.5f / 450.0f;  // Position output of control unit
+            float volts_offset = 0.03f;
+            float noise_volts = 0.0004f;        // ADC noise, std. deviation at ADC input
+            float spike_probability = 0.001f;   // Chance of a single-sample spike
+        } model;
+
+        // Physical state
+        float angle = 180.0f;                   // °
+        float angular_speed = 0.0f;             // °/s
+
+        // Actuators, written by the control task
+        volatile int8_t relay = 0;              // -1: CCW, 0: off, 1: CW
+        volatile uint8_t dac_speed = 0;         // 0% to 100%
+
+        Simulator() {};
+
+        // => Integrate the model up to given time
+        void step(const unsigned long us);
+
+        // => Voltage at the ADC input for the current angle, including noise
+        float readADCVolts() const;
+    };
+}
+
+// Expose global simulator instance
+extern Rotor::Simulator rotor_sim;
+
+#endif //ROTORSIMULATOR_H
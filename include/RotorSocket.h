@@ -2,22 +2,133 @@
 #define ROTORSOCKET_H
 
 #include <ESPAsyncWebServer.h>
+#include <functional>
+
+#include <MessageAssembler.h>
 
 #define MSG_ID_ROTOR "ROTOR"
 #define MSG_ID_CALIBRATION "CALIBRATION"
 #define MSG_ID_SETTINGS "SETTINGS"
 #define MSG_ID_FAVORITES "FAVORITES"
 #define MSG_ID_LOCK "LOCK"
+#define MSG_ID_PROTOCOL "PROTOCOL"
+#define MSG_ID_SUBSCRIBE "SUBSCRIBE"
+#define MSG_ID_ACK "ACK"
+#define MSG_ID_PING "PING"
+#define MSG_ID_PONG "PONG"
+#define MSG_ID_DIAG "DIAG"
+
+// Topics clients can subscribe to, lock messages are always sent
+#define TOPIC_ROTATION 0x01             // Rotation, angle and target
+#define TOPIC_SPEED 0x02
+#define TOPIC_CALIBRATION 0x04
+#define TOPIC_SETTINGS 0x08
+#define TOPIC_FAVORITES 0x10
+#define TOPICS_ALL 0x1F
+
+// Registry size, follows the websocket client limit
+#ifdef DEFAULT_MAX_WS_CLIENTS
+#define SOCKET_MAX_CLIENTS DEFAULT_MAX_WS_CLIENTS
+#else
+#define SOCKET_MAX_CLIENTS 8
+#endif
+
+// Telemetry is held back once this many frames are queued for a client
+#ifndef TELEMETRY_MAX_QUEUED
+#define TELEMETRY_MAX_QUEUED 4
+#endif
 
 // Expose global socket instance
 extern AsyncWebSocket websocket;
 
 namespace RotorSocket {
+  // Per-client state, id 0 marks a free slot
+  struct ClientState {
+    uint32_t id = 0;
+    bool binary = false;            // Client negotiated binary telemetry frames
+    bool bundle = false;            // Client negotiated several messages per text frame, one per line
+    bool greeting_due = false;      // Connected, complete state not sent yet
+    bool telemetry_stale = false;   // Telemetry was held back, latest state still has to be sent
+    size_t max_queue_len = 0;       // Deepest send queue seen
+    uint32_t n_replaced = 0;        // Telemetry frames replaced by newer ones before sending
+    uint32_t n_dropped = 0;         // Frames dropped because the send queue was full
+    int8_t slot = -1;               // Reassembly buffer in use, -1 if none
+    uint8_t topics = TOPICS_ALL;    // Subscribed topics
+    uint16_t min_interval_ms = 0;   // Telemetry rate limit, 0 if unlimited
+    unsigned long last_telemetry_ms = 0;
+    uint32_t n_rate_limited = 0;    // Telemetry frames held back by the rate limit
+
+    // Round trip time, measured with PING / PONG
+    uint16_t ping_id = 0;           // Id of the last ping
+    unsigned long ping_us = 0;      // Time the last ping was sent, 0 if answered
+    uint32_t rtt_us = 0;            // Last round trip time
+    uint32_t min_rtt_us = 0;
+    uint32_t max_rtt_us = 0;
+    uint32_t n_pings = 0;
+    uint32_t n_pongs = 0;
+  };
+
+  // Outgoing frame for one client, parts not to be sent are nullptr
+  struct Frame {
+    const String *text = nullptr;           // Text frame, messages separated by newlines
+    const uint8_t *data = nullptr;          // Binary frame
+    size_t len = 0;
+  };
+
+  // How a frame is delivered
+  struct SendPolicy {
+    bool is_telemetry = false;              // Latest wins, held back for slow or rate limited clients
+    bool has_rotor_state = false;           // Carries the latest rotor state, clears stale telemetry
+    bool only_stale = false;                // Only for clients with stale telemetry
+  };
+
+  // Builds the frame for a client's topics and format, returns false if there is nothing to send.
+  // Consecutive calls with the same arguments should reuse the built frame.
+  typedef std::function<bool(const uint8_t topics, const bool binary, Frame &frame)> FrameBuilder;
+
   // Number of connected socket clients
   extern uint8_t clients_connected;
 
   // => Initialise websocket (add event handler)
   void initWebsocket();
+
+  // => Get registered client by id, nullptr if unknown. The registry is changed by the async_tcp
+  // task and walked by the loop, the state must only be used with the registry lock held.
+  ClientState* getClient(const uint32_t id);
+
+  // => Send a frame built per subscription to all registered clients.
+  // Telemetry is held back for clients with TELEMETRY_MAX_QUEUED frames queued or
+  // above their rate limit, other frames are only dropped if the queue is full.
+  // Text is sent as one frame to clients that negotiated bundling, else one frame per message.
+  // Returns the number of clients that got a frame, n_frames counts text and binary frames.
+  // Holds the registry lock, safe to call from the loop and the async_tcp task.
+  uint8_t sendAll(const SendPolicy &policy, const FrameBuilder &build, uint16_t *n_frames = nullptr);
+
+  // => Handle a null-terminated ID|json message received by another transport, e.g. MQTT.
+  // Only rotor commands (ROTOR) are accepted, calibration, settings, favorites, lock and
+  // messages that answer or configure a websocket client are rejected.
+  // To be called from the async_tcp task, like websocket events.
+  void receiveMessage(char* msg, const size_t len);
+
+  // => Send the complete state to clients that connected since the last call, to be called from the loop
+  void greetNewClients();
+
+  // => Apply favorites, lock and settings messages received since the last call, to be called from the loop.
+  // Handlers only hand them over, saving and distributing them would stall the async_tcp task.
+  void applyPending();
+
+  // => Send acknowledgements of commands applied by the control task
+  void sendAcks();
+
+  // => Ping all clients to measure round trip times
+  void pingClients();
+
+  // => Return wether a client with stale telemetry can take the latest state again
+  bool hasStaleClients();
+
+  // => Print send queue, drop/replace counters and round trip time of all clients,
+  // reassembly statistics and command latency to Serial
+  void printClientStats();
 }
 
 #endif //ROTORSOCKET_H
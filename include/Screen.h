@@ -4,6 +4,7 @@
 #include <Arduino.h>
 #include <Adafruit_SSD1306.h>
 #include <Timer.h>
+#include <RotorController.h>
 
 #define SCREEN_WIDTH 128
 #define SCREEN_HALF_WIDTH 64
@@ -22,8 +23,18 @@ namespace Screen {
 
         Timer alert_timer;
         String alert_txt;
+        SemaphoreHandle_t alert_lock = nullptr;
         bool disabled = false;
 
+        // Rotor state, read once per redraw
+        Rotor::Snapshot rotor_state;
+
+        // UI task redrawing the screen
+        TaskHandle_t ui_task = nullptr;
+
+        // => UI task, calls update() at a fixed rate
+        static void uiTask(void *param);
+
         uint8_t page = 0;
 
         // Variables for drawing compass
@@ -122,13 +133,16 @@ namespace Screen {
             disabled = false;
         }
 
-        // => Main draw function, to be called from main loop
+        // => Main draw function, called from the UI task
         void update();
 
+        // => Start UI task, which redraws the screen every 40 ms
+        void startTask();
+
         // => Set an alert message to be shown full screen for a few seconds
         void setAlert(const String &txt);
 
-        // => Set an alert message and show it on  the screen immediatly
+        // => Set an alert message and show it on  the screen immediatly, within a UI task period once it runs
         void setAlertImmediatly(const String &txt);
 
         // => Toggle through available screens
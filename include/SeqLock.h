@@ -0,0 +1,45 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <Arduino.h>
+#include <atomic>
+
+
+// Sequence Lock Class
+// *******************
+// Lock-free container for a small struct with a single writer and any number of readers.
+// The writer never blocks, readers retry if a write happened while they were copying.
+template <typename T>
+class SeqLock {
+private:
+    T data;
+    std::atomic<uint32_t> seq{0};   // Odd while a write is in progress
+
+public:
+    SeqLock() {};
+
+    // => Store a new value, writer side
+    void write(const T &value) {
+        uint32_t s = seq.load(std::memory_order_relaxed);
+        seq.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        data = value;
+        std::atomic_thread_fence(std::memory_order_release);
+        seq.store(s + 2, std::memory_order_release);
+    }
+
+    // => Read a consistent copy of the value, reader side
+    T read() const {
+        T value;
+        uint32_t s1, s2;
+        do {
+            s1 = seq.load(std::memory_order_acquire);
+            value = data;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            s2 = seq.load(std::memory_order_relaxed);
+        } while (s1 != s2 || (s1 & 1));
+        return value;
+    }
+};
+
+#endif //SEQLOCK_H
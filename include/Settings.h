@@ -1,20 +1,24 @@
 #ifndef SETTINGS_H
 #define SETTINGS_H
 
-namespace Settings {
-    extern String settings_buffer;
-
-    // => Reserve message buffer
-    void initBuffer();
+// Settings fields, marked dirty when changed and sent with the next messenger flush
+#define SETTINGS_FIELD_SCREEN 0x01
+#define SETTINGS_FIELD_BOOT_TIME 0x02
 
-    // => Send general settings to clients
-    void sendSettings();
+namespace Settings {
+    // => Append general settings to a connect snapshot, one line per message.
+    // Fixed settings are serialized once and reused.
+    void appendSettings(String &buffer);
 
-    // => Send screen setting to clients
+    // => Send screen setting to clients with the next flush
     void sendScreen();
 
-    // => Send on-time to clients
+    // => Send on-time to clients with the next flush
     void sendBootTime();
+
+    // => Append changed settings as one message to buffer, on a new line if buffer isn't empty.
+    // Returns the number of send requests merged into it.
+    uint32_t appendChanges(String &buffer);
 }
 
 #endif //SETTINGS_H
@@ -12,6 +12,9 @@ String readFromFS(const char* path);
 // => Write a String to file from FS
 bool writeToFS(const char* path, const String &data);
 
+// => Append bytes to a file from FS, creates the file if missing
+bool appendToFS(const char* path, const uint8_t* data, const size_t len);
+
 // => Remove file from FS
 bool removeFromFS(const char* path);
 
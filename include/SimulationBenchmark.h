@@ -0,0 +1,18 @@
+#ifndef SIMULATIONBENCHMARK_H
+#define SIMULATIONBENCHMARK_H
+
+#include <Arduino.h>
+
+
+// Simulation Benchmark
+// ********************
+// Runs randomized auto-rotations against the simulated rotor (SIMULATE_ROTOR) and
+// reports time-to-target, overshoot, final error, aborted runs and control tick time.
+// Scenarios run in real time through the regular command queue and control task.
+namespace SimulationBenchmark {
+
+    // => Start benchmark task running given number of scenarios, pinned to core 0
+    void start(const uint32_t n_scenarios);
+}
+
+#endif //SIMULATIONBENCHMARK_H
@@ -0,0 +1,99 @@
+#ifndef SOCKETMESSAGES_H
+#define SOCKETMESSAGES_H
+
+#include <Arduino.h>
+
+
+// Socket Messages
+// ***************
+// Inbound websocket messages, parsed in place from the frame buffer.
+// Each message has a bit per field telling wether it was present.
+namespace SocketMessages {
+
+    // ROTOR|{"rotation":-1|0|1, "speed":0-100, "target":°, "useOverlap":b, "useSmoothSpeed":b, "seq":n}
+    // Commands with a sequence number are acknowledged once applied.
+    #define ROTOR_MSG_ROTATION 0x01
+    #define ROTOR_MSG_SPEED 0x02
+    #define ROTOR_MSG_TARGET 0x04
+    #define ROTOR_MSG_OVERLAP 0x08
+    #define ROTOR_MSG_SMOOTH_SPEED 0x10
+    #define ROTOR_MSG_SEQ 0x20
+    struct RotorMsg {
+        uint8_t fields = 0;
+        int rotation = 0;
+        int speed = 0;
+        float target = 0.0f;
+        bool use_overlap = false;
+        bool use_smooth_speed = false;
+        uint32_t seq = 0;
+    };
+
+    // CALIBRATION|{"u1":V, "u2":V, "a1":°, "a2":°, "offset":°, "seq":n}
+    #define CALIBRATION_MSG_U1 0x01
+    #define CALIBRATION_MSG_U2 0x02
+    #define CALIBRATION_MSG_A1 0x04
+    #define CALIBRATION_MSG_A2 0x08
+    #define CALIBRATION_MSG_OFFSET 0x10
+    #define CALIBRATION_MSG_SEQ 0x20
+    #define CALIBRATION_MSG_POINTS 0x0F
+    struct CalibrationMsg {
+        uint8_t fields = 0;
+        float u1 = 0.0f;
+        float u2 = 0.0f;
+        float a1 = 0.0f;
+        float a2 = 0.0f;
+        float offset = 0.0f;
+        uint32_t seq = 0;
+    };
+
+    // SETTINGS|{"useScreen":b}
+    #define SETTINGS_MSG_USE_SCREEN 0x01
+    struct SettingsMsg {
+        uint8_t fields = 0;
+        bool use_screen = false;
+    };
+
+    // PROTOCOL|{"binary":b, "bundle":b}
+    #define PROTOCOL_MSG_BINARY 0x01
+    #define PROTOCOL_MSG_BUNDLE 0x02
+    struct ProtocolMsg {
+        uint8_t fields = 0;
+        bool binary = false;
+        bool bundle = false;
+    };
+
+    // SUBSCRIBE|{"rotation":b, "speed":b, "calibration":b, "settings":b, "favorites":b, "maxRate":Hz}
+    // Topics not given keep their subscription, maxRate 0 removes the rate limit.
+    #define SUBSCRIBE_MSG_ROTATION 0x01
+    #define SUBSCRIBE_MSG_SPEED 0x02
+    #define SUBSCRIBE_MSG_CALIBRATION 0x04
+    #define SUBSCRIBE_MSG_SETTINGS 0x08
+    #define SUBSCRIBE_MSG_FAVORITES 0x10
+    #define SUBSCRIBE_MSG_MAX_RATE 0x20
+    struct SubscribeMsg {
+        uint8_t fields = 0;
+        bool rotation = false;
+        bool speed = false;
+        bool calibration = false;
+        bool settings = false;
+        bool favorites = false;
+        float max_rate = 0.0f;
+    };
+
+    // PONG|{"id":n}, answer to PING|{"id":n}
+    #define PONG_MSG_ID 0x01
+    struct PongMsg {
+        uint8_t fields = 0;
+        uint16_t id = 0;
+    };
+
+    // => Parse JSON payloads, return false on a syntax error
+    bool parse(const char* json, const size_t len, RotorMsg &msg);
+    bool parse(const char* json, const size_t len, CalibrationMsg &msg);
+    bool parse(const char* json, const size_t len, SettingsMsg &msg);
+    bool parse(const char* json, const size_t len, ProtocolMsg &msg);
+    bool parse(const char* json, const size_t len, SubscribeMsg &msg);
+    bool parse(const char* json, const size_t len, PongMsg &msg);
+}
+
+#endif //SOCKETMESSAGES_H
@@ -0,0 +1,75 @@
+#ifndef TELEMETRYMULTICAST_H
+#define TELEMETRYMULTICAST_H
+
+#include <Arduino.h>
+
+// Default group, port and rate, a rate of 0 disables the stream
+#ifndef MULTICAST_GROUP
+#define MULTICAST_GROUP "239.255.43.21"
+#endif
+#ifndef MULTICAST_PORT
+#define MULTICAST_PORT 12043
+#endif
+#ifndef MULTICAST_RATE_HZ
+#define MULTICAST_RATE_HZ 10
+#endif
+
+// Size of the group string, a dotted IPv4 address including the terminating null
+#define MULTICAST_GROUP_SIZE 16
+
+// Interval of datagrams while the rotor is at rest, in ms
+#define MULTICAST_IDLE_INTERVAL_MS 1000
+
+#define MULTICAST_FRAME_VERSION 1
+
+namespace Rotor {
+    struct Snapshot;
+}
+
+
+// Telemetry Multicast
+// *******************
+// Sends the rotor state as one UDP datagram per sample to a multicast group, so any number
+// of displays and loggers on the LAN cost a single send. Samples go out at the configured
+// rate during motion and once per second at rest. Receivers count lost and reordered
+// datagrams by the sequence number, see scripts/multicast_receiver.py.
+namespace Multicast {
+
+    // Datagram, little-endian, angles in 1/100 °
+    struct __attribute__((packed)) Frame {
+        char magic[2] = {'R', 'T'};
+        uint8_t version = MULTICAST_FRAME_VERSION;
+        uint8_t state = 0;              // HISTORY_ROTATING, HISTORY_CW, HISTORY_AUTO bits
+        uint32_t seq = 0;               // Increases by one per datagram, restarts at boot
+        uint32_t t = 0;                 // Time of the angle measurement, device millis
+        int32_t angle = 0;
+        int16_t v = 0;                  // Angular speed, in 1/100 °/s
+        int32_t target = 0;
+        uint8_t speed = 0;              // Current speed, 0% to 100%
+    };
+
+    // Stream configuration, stored in Preferences
+    struct Config {
+        char group[MULTICAST_GROUP_SIZE] = MULTICAST_GROUP;
+        uint16_t port = MULTICAST_PORT;
+        uint8_t rate_hz = MULTICAST_RATE_HZ;
+    };
+
+    // => Load config from Preferences, to be called once in station mode
+    void init();
+
+    // => Copy of the config, including one set but not yet applied. Safe to call from any task.
+    Config getConfig();
+
+    // => Check a config and hand it to the loop, which applies and saves it with the next update.
+    // Safe to call from any task. Returns false if the config is invalid or the stream is not set up.
+    bool setConfig(const Config &new_config);
+
+    // => Send a sample if one is due, to be called from the loop
+    void update(const Rotor::Snapshot &state);
+
+    // => Print send counters to Serial
+    void printStats();
+}
+
+#endif //TELEMETRYMULTICAST_H
@@ -0,0 +1,39 @@
+#ifndef UDPROTOR_H
+#define UDPROTOR_H
+
+#include <Arduino.h>
+
+#include <RotorCommands.h>
+
+// Port for N1MM and PstRotator datagrams, N1MM's default
+#ifndef UDP_ROTOR_PORT
+#define UDP_ROTOR_PORT 12040
+#endif
+
+
+// UDP Rotor Listener
+// ******************
+// Takes rotor commands from contest loggers as single UDP datagrams, without a PC relay.
+// Understands the N1MM rotor messages
+//   <N1MMRotor><rotor>name</rotor><goazi>123.4</goazi>...</N1MMRotor>
+//   <N1MMRotor><stop>name</stop></N1MMRotor>
+// and the PstRotator messages
+//   <PST><AZIMUTH>123</AZIMUTH></PST>, <PST><STOP>1</STOP></PST>, <PST>AZ?</PST>
+// Commands are posted to the control task straight from the UDP task. Every datagram is
+// answered to its sender with the position, in the format of the request:
+//   <N1MMRotor><rotor>name</rotor><azimuth>123.4</azimuth></N1MMRotor> or AZ:123
+namespace UdpRotor {
+
+    // => Handle a datagram received at rx_us, writes the position response. Commands are handed
+    // to post. Returns false if the datagram is unknown or malformed, it is not answered then.
+    bool handleDatagram(const char* data, const size_t len, const uint32_t rx_us, Rotor::PostCommand post,
+                        char* response, const size_t size);
+
+    // => Start listening on UDP_ROTOR_PORT
+    void init();
+
+    // => Print datagram counters to Serial
+    void printStats();
+}
+
+#endif //UDPROTOR_H
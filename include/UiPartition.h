@@ -0,0 +1,87 @@
+#ifndef UIPARTITION_H
+#define UIPARTITION_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+
+// Label of the data partition holding the UI archive, see rotor-partitions-ui.csv
+#define UI_PARTITION_LABEL "ui"
+
+// Archive slots, the partition is split into halves. Uploads go into the inactive one.
+#define UI_SLOTS 2
+
+#define UI_ARCHIVE_MAGIC 0x41495552     // "RUIA"
+#define UI_ARCHIVE_VERSION 1
+
+#define UI_PATH_SIZE 40
+#define UI_TYPE_SIZE 28
+#define UI_ETAG_SIZE 20
+#define UI_VERSION_SIZE 16
+
+// Entry flags
+#define UI_ENTRY_GZIP 0x01              // Data is gzip compressed
+#define UI_ENTRY_AUTH 0x02              // Only sent to authenticated clients, the app itself
+
+
+// UI Archive
+// **********
+// Built by scripts/asset_table.py from the same assets as AppAssetTable.h. Little-endian:
+//   header, n_entries entries sorted by path, asset data.
+// Strings are null-terminated within their fields, offsets count from the archive start.
+struct __attribute__((packed)) UiArchiveHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t n_entries;
+    uint32_t size;                      // Whole archive, in bytes
+    uint32_t crc32;                     // Of everything after the header
+    char ui_version[UI_VERSION_SIZE];
+};
+
+struct __attribute__((packed)) UiArchiveEntry {
+    char path[UI_PATH_SIZE];
+    char content_type[UI_TYPE_SIZE];
+    char etag[UI_ETAG_SIZE];            // Quoted content hash
+    uint32_t offset;
+    uint32_t len;
+    uint8_t flags;
+    uint8_t reserved[3];
+};
+
+
+// UI Partition
+// ************
+// Serves the web UI from a data partition instead of arrays in the firmware image.
+// The partition is memory-mapped once, assets are sent straight from the mapping
+// without copies in RAM. The archive is replaced by a streamed upload to /ui-update,
+// independent of firmware updates and without a restart. The upload is written into the
+// inactive slot, the active archive is served until the new one passed its checksum.
+namespace UiPartition {
+
+    // => Find and map the partition and check the archive, to be called once at boot
+    bool init();
+
+    // => Return wether a valid archive is mapped
+    bool isValid();
+
+    // => Find an entry by path, binary search. nullptr if there is none or no valid archive.
+    const UiArchiveEntry* find(const char* path);
+
+    // => Mapped data of an entry in the active archive
+    const uint8_t* getData(const UiArchiveEntry &entry);
+
+    // => Keep the active slot from being erased until the response to request is sent
+    void holdUntilSent(AsyncWebServerRequest *request);
+
+    // => UI version of the archive, empty if there is none
+    const char* getVersion();
+
+    // => Upload handler for the archive via HTTP Post multipart/formdata, md5 as query parameter.
+    // Only one upload runs at a time.
+    void handleUpload(AsyncWebServerRequest *request, String filename,
+                      size_t index, uint8_t *data, size_t len, bool final);
+
+    // => Handler for when the upload finished
+    void handleUploadResponse(AsyncWebServerRequest *request);
+}
+
+#endif //UIPARTITION_H
@@ -0,0 +1,50 @@
+#ifndef VARINT_H
+#define VARINT_H
+
+#include <Arduino.h>
+
+
+// Varint Encoding
+// ***************
+// Unsigned integers in 7 bits per byte, low bits first, high bit set on all but the
+// last byte. Signed values are zigzag mapped first, so small magnitudes stay short.
+namespace Varint {
+
+    // Longest encoding of a 32 bit value
+    const size_t MAX_SIZE = 5;
+
+    // => Write value, returns bytes written
+    inline size_t put(uint8_t *out, uint32_t value) {
+        size_t n = 0;
+        while (value >= 0x80) {
+            out[n++] = (value & 0x7F) | 0x80;
+            value >>= 7;
+        }
+        out[n++] = value;
+        return n;
+    }
+
+    // => Read value at pos, false if it runs past end
+    inline bool get(const uint8_t *data, size_t &pos, const size_t end, uint32_t &value) {
+        value = 0;
+        for (uint8_t shift = 0; pos < end && shift < 35; shift += 7) {
+            const uint8_t byte = data[pos++];
+            value |= (uint32_t) (byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // => Map signed to unsigned and back
+    inline uint32_t zigzag(const int32_t value) {
+        return ((uint32_t) value << 1) ^ (uint32_t) (value >> 31);
+    }
+
+    inline int32_t unzigzag(const uint32_t value) {
+        return (int32_t) (value >> 1) ^ -(int32_t) (value & 1);
+    }
+}
+
+#endif //VARINT_H
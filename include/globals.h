@@ -15,6 +15,12 @@ const uint8_t multi_button_pin = 32;    // Push button
 const uint8_t rot_pins[2] = {33, 25};   // { Mini-DIN pin 2, Mini-DIN pin 1 }
 const uint8_t speed_pin = 26;           // Mini-DIN pin 3
 
+// ADS1115 ALERT/RDY pin, signals a finished conversion
+const uint8_t adc_alert_pin = 27;
+
+// UART2 for GS-232 station software { RX, TX }
+const uint8_t gs232_pins[2] = {16, 17};
+
 // AP mode server config
 const bool use_custom_ip = true;
 const int ip[4] = {192, 168, 4, 1};         // AP mode custom IP
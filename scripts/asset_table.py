@@ -0,0 +1,160 @@
+"""Generate the table of web assets embedded in the firmware and the UI archive.
+
+Runs before every PlatformIO build (extra_scripts in platformio.ini), or standalone
+with `python3 scripts/asset_table.py`. Finds every PROGMEM byte array in AppIndex.h and
+AppAssets.h and writes include/AppAssetTable.h: one entry per asset with its URL path,
+content type and a content hash as ETag, sorted by path for binary search.
+The header is only rewritten if it changed, so unchanged assets don't trigger a rebuild.
+
+The same assets are packed into .pio/ui.bin, the archive for the UI partition of
+builds with -D UI_PARTITION (layout in include/UiPartition.h).
+
+Array names map to paths: index_html_gzip is "/", otherwise the last underscore
+separates the extension and the others become dashes (inter_700_woff2 -> /inter-700.woff2).
+"""
+
+import hashlib
+import os
+import re
+import struct
+import zlib
+
+ASSET_HEADERS = ["lib/App/AppIndex.h", "include/AppAssets.h"]
+TABLE_HEADER = "include/AppAssetTable.h"
+UI_ARCHIVE = ".pio/ui.bin"
+
+# UiArchiveHeader and UiArchiveEntry in include/UiPartition.h
+ARCHIVE_MAGIC = 0x41495552
+ARCHIVE_VERSION = 1
+ARCHIVE_HEADER = struct.Struct("<IHHII16s")
+ARCHIVE_ENTRY = struct.Struct("<40s28s20sIIB3x")
+ENTRY_GZIP = 0x01
+ENTRY_AUTH = 0x02
+
+INDEX_ARRAY = "index_html_gzip"
+
+CONTENT_TYPES = {
+    "html": "text/html",
+    "png": "image/png",
+    "ico": "image/x-icon",
+    "woff2": "font/woff2",
+    "css": "text/css",
+    "js": "text/javascript",
+    "json": "application/json",
+    "webmanifest": "application/manifest+json",
+}
+
+ARRAY = re.compile(r"^const uint8_t (\w+)\[\] PROGMEM = \{([^}]*)\};", re.MULTILINE)
+BYTE = re.compile(r"0x([0-9a-fA-F]{2})")
+UI_VERSION = re.compile(r'^#define UI_VERSION "([^"]*)"', re.MULTILINE)
+
+
+def asset_entry(name, data):
+    if name == INDEX_ARRAY:
+        path, content_type, gzip = "/", "text/html", True
+    else:
+        stem, extension = name.rsplit("_", 1)
+        path = "/" + stem.replace("_", "-") + "." + extension
+        content_type, gzip = CONTENT_TYPES.get(extension, "application/octet-stream"), False
+    etag = hashlib.sha1(data).hexdigest()[:16]
+    return path, name, content_type, etag, gzip, data
+
+
+def read_assets(path):
+    with open(path, encoding="utf-8") as file:
+        source = file.read()
+    for name, body in ARRAY.findall(source):
+        data = bytes(int(byte, 16) for byte in BYTE.findall(body))
+        yield asset_entry(name, data)
+
+
+def read_ui_version(project_dir):
+    with open(os.path.join(project_dir, ASSET_HEADERS[0]), encoding="utf-8") as file:
+        match = UI_VERSION.search(file.read())
+    return match.group(1) if match else ""
+
+
+def header_source(assets):
+    lines = [
+        "// Generated by scripts/asset_table.py, do not edit.",
+        "// Embedded web assets sorted by path, to be included once by the asset router.",
+        "#ifndef APPASSETTABLE_H",
+        "#define APPASSETTABLE_H",
+        "",
+        "#include <AppIndex.h>",
+        "#include <AppAssets.h>",
+        "#include <RotorServer.h>",
+        "",
+        "const RotorServer::Asset app_assets[] = {",
+    ]
+    for path, name, content_type, etag, gzip, _ in assets:
+        # The app itself requires login, static files are public like in AP mode
+        is_index = name == INDEX_ARRAY
+        lines.append(f'  {{"{path}", "{content_type}", {name}, {name}_len, "\\"{etag}\\"", '
+                     f'{"INDEX_CACHE_CONTROL" if is_index else "ASSET_CACHE_CONTROL"}, '
+                     f'{"true" if gzip else "false"}, {"true" if is_index else "false"}}},')
+    lines += [
+        "};",
+        "",
+        "#define app_assets_len (sizeof(app_assets) / sizeof(app_assets[0]))",
+        "",
+        "#endif //APPASSETTABLE_H",
+        "",
+    ]
+    return "\n".join(lines)
+
+
+def archive_bytes(assets, ui_version):
+    index_end = ARCHIVE_HEADER.size + len(assets) * ARCHIVE_ENTRY.size
+    entries = b""
+    data = b""
+    for path, name, content_type, etag, gzip, content in assets:
+        flags = (ENTRY_GZIP if gzip else 0) | (ENTRY_AUTH if name == INDEX_ARRAY else 0)
+        # Fields keep a terminating null byte
+        entries += ARCHIVE_ENTRY.pack(path.encode()[:39], content_type.encode()[:27],
+                                      f'"{etag}"'.encode(), index_end + len(data), len(content), flags)
+        data += content
+    body = entries + data
+    header = ARCHIVE_HEADER.pack(ARCHIVE_MAGIC, ARCHIVE_VERSION, len(assets), ARCHIVE_HEADER.size + len(body),
+                                 zlib.crc32(body), ui_version.encode()[:15])
+    return header + body
+
+
+def write_if_changed(path, content):
+    if os.path.exists(path):
+        with open(path, "rb") as file:
+            if file.read() == content:
+                return False
+    os.makedirs(os.path.dirname(path), exist_ok=True)
+    with open(path, "wb") as file:
+        file.write(content)
+    return True
+
+
+def generate(project_dir):
+    assets = []
+    for header in ASSET_HEADERS:
+        path = os.path.join(project_dir, header)
+        if os.path.exists(path):
+            assets += read_assets(path)
+        else:
+            print(f"[Assets] Warning: {header} not found")
+    # Same order as strcmp, paths are ASCII
+    assets.sort(key=lambda asset: asset[0].encode())
+
+    if write_if_changed(os.path.join(project_dir, TABLE_HEADER), header_source(assets).encode()):
+        print(f"[Assets] {TABLE_HEADER} written with {len(assets)} assets")
+
+    archive = archive_bytes(assets, read_ui_version(project_dir))
+    if write_if_changed(os.path.join(project_dir, UI_ARCHIVE), archive):
+        print(f"[Assets] {UI_ARCHIVE} written ({len(archive)} B)")
+
+
+try:
+    Import("env")  # noqa: F821, provided by PlatformIO
+    project_dir = env.subst("$PROJECT_DIR")  # noqa: F821
+except NameError:
+    # Standalone, __file__ is only defined outside of SCons
+    project_dir = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+generate(project_dir)
@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+"""Receive the rotor's multicast telemetry and count lost and reordered datagrams.
+
+Usage: multicast_receiver.py [--group 239.255.43.21] [--port 12043] [--quiet]
+"""
+
+import argparse
+import socket
+import struct
+import time
+
+# Layout of Multicast::Frame in include/TelemetryMulticast.h, little-endian
+FRAME = struct.Struct("<2sBBIIihiB")
+FRAME_VERSION = 1
+
+ROTATING = 0x01
+CW = 0x02
+AUTO = 0x04
+
+REPORT_INTERVAL_S = 10
+
+
+class SequenceCounter:
+    """Counts lost, reordered and duplicate datagrams by their sequence numbers."""
+
+    def __init__(self):
+        self.highest = None     # Highest sequence number received
+        self.missing = set()    # Skipped sequence numbers, may still arrive late
+        self.received = 0
+        self.lost = 0
+        self.reordered = 0
+        self.duplicates = 0
+
+    def add(self, seq):
+        self.received += 1
+        # Sequence restarts when the controller reboots
+        if self.highest is None or seq + 1000 < self.highest:
+            self.highest = seq
+            self.missing.clear()
+        elif seq > self.highest:
+            self.missing.update(range(self.highest + 1, seq))
+            self.lost += seq - self.highest - 1
+            self.highest = seq
+        elif seq in self.missing:
+            self.missing.discard(seq)
+            self.lost -= 1
+            self.reordered += 1
+        else:
+            self.duplicates += 1
+
+    def __str__(self):
+        return (f"received {self.received} | lost {self.lost} | "
+                f"reordered {self.reordered} | duplicates {self.duplicates}")
+
+
+def open_socket(group, port):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    sock.bind(("", port))
+    membership = struct.pack("4s4s", socket.inet_aton(group), socket.inet_aton("0.0.0.0"))
+    sock.setsockopt(socket.IPPROTO_IP, socket.IP_ADD_MEMBERSHIP, membership)
+    sock.settimeout(1.0)
+    return sock
+
+
+def state_text(state):
+    if not state & ROTATING:
+        return "stop"
+    text = "cw" if state & CW else "ccw"
+    return text + " auto" if state & AUTO else text
+
+
+def receive(sock, counter, quiet):
+    last_report = time.monotonic()
+    while True:
+        now = time.monotonic()
+        if now - last_report >= REPORT_INTERVAL_S:
+            last_report = now
+            print(counter)
+
+        try:
+            data, sender = sock.recvfrom(64)
+        except socket.timeout:
+            continue
+        if len(data) != FRAME.size:
+            continue
+        magic, version, state, seq, t, angle, v, target, speed = FRAME.unpack(data)
+        if magic != b"RT" or version != FRAME_VERSION:
+            continue
+        counter.add(seq)
+
+        if not quiet:
+            print(f"{sender[0]} #{seq} t={t} ms angle={angle / 100:.2f}° v={v / 100:.2f}°/s "
+                  f"target={target / 100:.2f}° speed={speed}% {state_text(state)}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--group", default="239.255.43.21")
+    parser.add_argument("--port", type=int, default=12043)
+    parser.add_argument("--quiet", action="store_true", help="only print the counters")
+    args = parser.parse_args()
+
+    counter = SequenceCounter()
+    try:
+        receive(open_socket(args.group, args.port), counter, args.quiet)
+    except KeyboardInterrupt:
+        print(counter)
+
+
+if __name__ == "__main__":
+    main()
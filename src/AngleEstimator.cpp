@@ -0,0 +1,90 @@
+#include <Arduino.h>
+#include <math.h>
+
+#include <AngleEstimator.h>
+
+// Outlier gate, in standard deviations of the innovation
+#define ESTIMATOR_GATE_SIGMAS 5.0f
+// Smallest outlier gate, in °
+#define ESTIMATOR_MIN_GATE 1.0f
+// Error of the speed estimate, as a fraction of the speed. Widens the gate by the distance
+// this error adds up to since the last accepted measurement.
+#define ESTIMATOR_SPEED_ERROR 0.5f
+// Initial innovation variance, in °²
+#define ESTIMATOR_INITIAL_VAR 0.04f
+// Weight of a new innovation in the running variance
+#define ESTIMATOR_VAR_WEIGHT 0.02f
+// After this many rejects in a row, the jump is assumed to be real
+#define ESTIMATOR_MAX_REJECTS 5
+// Restart the filter after a gap between samples, in µs
+#define ESTIMATOR_MAX_GAP_US 500000UL
+
+
+namespace Rotor {
+
+    // ******************************
+    // Define AngleEstimator members
+    // ******************************
+
+    // => Restart filter at given measurement and speed
+    void AngleEstimator::reset(const float measured_angle, const unsigned long us, const float speed) {
+        angle = measured_angle;
+        angular_speed = speed;
+        innovation_var = ESTIMATOR_INITIAL_VAR;
+        confidence = 0.5f;
+        n_consecutive_rejects = 0;
+        last_us = us;
+        last_accepted_us = us;
+        initialised = true;
+    }
+
+    // => Feed a new angle measurement taken at given time
+    bool AngleEstimator::update(const float measured_angle, const unsigned long us) {
+        n_samples++;
+        const unsigned long dt_us = us - last_us;
+
+        if (!initialised || dt_us > ESTIMATOR_MAX_GAP_US) {
+            reset(measured_angle, us);
+            return true;
+        }
+        if (dt_us == 0) {
+            return true;
+        }
+
+        // Predict
+        const float dt = dt_us / 1000000.0f;
+        const float predicted_angle = angle + angular_speed * dt;
+        const float innovation = measured_angle - predicted_angle;
+        last_us = us;
+
+        // Reject outliers, keep predicting. The prediction gets less certain the faster
+        // the rotor turns and the longer no measurement was accepted.
+        const float predicted_dt = (us - last_accepted_us) / 1000000.0f;
+        const float gate = max(ESTIMATOR_GATE_SIGMAS * sqrt(innovation_var), ESTIMATOR_MIN_GATE)
+                         + ESTIMATOR_SPEED_ERROR * abs(angular_speed) * predicted_dt;
+        if (abs(innovation) > gate) {
+            n_rejected++;
+            confidence *= 0.8f;
+            if (++n_consecutive_rejects >= ESTIMATOR_MAX_REJECTS) {
+                // The jump is real. Keep the speed, a turning rotor isn't restarted at rest.
+                n_resets++;
+                reset(measured_angle, us, angular_speed);
+            } else {
+                angle = predicted_angle;
+            }
+            return false;
+        }
+        n_consecutive_rejects = 0;
+        last_accepted_us = us;
+
+        // Correct
+        angle = predicted_angle + alpha * innovation;
+        angular_speed += beta / dt * innovation;
+
+        // Innovation variance and confidence
+        innovation_var = (1.0f - ESTIMATOR_VAR_WEIGHT) * innovation_var
+                       + ESTIMATOR_VAR_WEIGHT * innovation * innovation;
+        confidence += 0.05f * (1.0f - confidence);
+        return true;
+    }
+}
@@ -0,0 +1,120 @@
+#include <Arduino.h>
+#include <Preferences.h>
+
+#include <globals.h>
+#include <CoastModel.h>
+
+#define COAST_PREFS_KEY "coastPrefs"
+
+// Angular speeds below this are too slow to learn from, in °/s
+#define COAST_MIN_ANGULAR_SPEED 0.5f
+// Upper bound for the coast time constant, in s
+#define COAST_MAX_TAU 2.0f
+// Smallest weight of a new sample, so the model keeps adapting
+#define COAST_MIN_WEIGHT 0.2f
+
+
+namespace Rotor {
+
+    // ******************************
+    // Define CoastModel members
+    // ******************************
+
+    // => Get bucket index for DAC speed
+    uint8_t CoastModel::getBucket(const uint8_t speed) const {
+        return min(speed / 10, COAST_SPEED_BUCKETS - 1);
+    }
+
+    // => Load model from PREFS, create storage if it doesn't already exist
+    void CoastModel::load() {
+        bool prefs_exists = coast_prefs.begin(COAST_PREFS_KEY, true);
+        if (!prefs_exists ||
+            coast_prefs.getBytes("tau", tau, sizeof(tau)) != sizeof(tau) ||
+            coast_prefs.getBytes("n", n, sizeof(n)) != sizeof(n)) {
+            for (uint8_t i = 0; i < COAST_SPEED_BUCKETS; ++i) {
+                tau[i] = 0.0f;
+                n[i] = 0;
+            }
+        }
+        coast_prefs.end();
+        if (!prefs_exists) {
+            save();
+        }
+    }
+
+    // => Save model to PREFS
+    void CoastModel::save() {
+        coast_prefs.begin(COAST_PREFS_KEY, false);
+        coast_prefs.putBytes("tau", tau, sizeof(tau));
+        coast_prefs.putBytes("n", n, sizeof(n));
+        coast_prefs.end();
+    }
+
+    // => Save model to PREFS if it learned since the last save, rate limited.
+    // Learning during saving sets the flag again, so the last state is always saved.
+    void CoastModel::saveChanged() {
+        if (!changed.load(std::memory_order_acquire) ||
+            (last_save_ms && millis() - last_save_ms < COAST_SAVE_INTERVAL)) {
+            return;
+        }
+        changed.store(false, std::memory_order_relaxed);
+        save();
+        last_save_ms = max(millis(), 1UL);
+    }
+
+    // => Reset model and save
+    void CoastModel::reset() {
+        for (uint8_t i = 0; i < COAST_SPEED_BUCKETS; ++i) {
+            tau[i] = 0.0f;
+            n[i] = 0;
+        }
+        save();
+    }
+
+    // => Predicted coast distance for DAC speed and angular speed.
+    // If the bucket is still empty, the nearest learned bucket is used.
+    float CoastModel::predict(const uint8_t speed, const float angular_speed) const {
+        const int bucket = getBucket(speed);
+        for (int d = 0; d < COAST_SPEED_BUCKETS; ++d) {
+            if (bucket - d >= 0 && n[bucket - d]) {
+                return tau[bucket - d] * abs(angular_speed);
+            }
+            if (bucket + d < COAST_SPEED_BUCKETS && n[bucket + d]) {
+                return tau[bucket + d] * abs(angular_speed);
+            }
+        }
+        return 0.0f;
+    }
+
+    // => Learn from a measured coast distance after cutting at given DAC speed and angular speed
+    void CoastModel::learn(const uint8_t speed, const float angular_speed, const float distance) {
+        if (abs(angular_speed) < COAST_MIN_ANGULAR_SPEED || distance < 0.0f) {
+            return;
+        }
+
+        const uint8_t bucket = getBucket(speed);
+        const float new_tau = constrain(distance / abs(angular_speed), 0.0f, COAST_MAX_TAU);
+
+        // Running mean for the first samples, then exponential moving average
+        const float weight = max(1.0f / (n[bucket] + 1), COAST_MIN_WEIGHT);
+        tau[bucket] = (1.0f - weight) * tau[bucket] + weight * new_tau;
+        if (n[bucket] < UINT16_MAX) {
+            n[bucket]++;
+        }
+        changed.store(true, std::memory_order_release);
+
+        if (verbose) {
+            Serial.printf("[Rotor] Learned coast: %.2f° at %.2f°/s, speed %d%% | tau: %.3f s (n = %d)\n\r",
+                          distance, angular_speed, speed, tau[bucket], n[bucket]);
+        }
+    }
+
+    // => Print model to Serial
+    void CoastModel::printToSerial() const {
+        Serial.print("[Rotor] Coast model (tau in s):");
+        for (uint8_t i = 0; i < COAST_SPEED_BUCKETS; ++i) {
+            Serial.printf(" %d%%: %.3f (%d) |", i * 10, tau[i], n[i]);
+        }
+        Serial.println();
+    }
+}
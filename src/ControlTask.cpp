@@ -0,0 +1,82 @@
+#include <Arduino.h>
+
+#include <globals.h>
+#include <ControlTask.h>
+#include <RotorController.h>    // Exposes Global: rotor_ctrl
+#include <Firmware.h>           // Exposes Global: firmware
+
+#define CONTROL_TASK_PRIORITY 4
+#define CONTROL_TASK_CORE 1
+#define CONTROL_TASK_STACK_SIZE 4096
+
+
+namespace ControlTask {
+    struct Stats stats;
+
+    TaskHandle_t control_task = nullptr;
+
+    // => Control task, runs a control cycle at a fixed rate and measures its timing
+    void controlTask(void *param) {
+        const TickType_t period = pdMS_TO_TICKS(CONTROL_PERIOD_MS);
+        TickType_t last_wake = xTaskGetTickCount();
+        unsigned long last_wake_us = micros();
+
+        for (;;) {
+            vTaskDelayUntil(&last_wake, period);
+            unsigned long wake_us = micros();
+
+            // Jitter, deviation of the actual period from the nominal period
+            stats.last_period_us = wake_us - last_wake_us;
+            uint32_t jitter_us = abs((long) stats.last_period_us - (long) stats.period_us);
+            last_wake_us = wake_us;
+            if (stats.n_ticks) {
+                stats.max_jitter_us = max(stats.max_jitter_us, jitter_us);
+                stats.worst_jitter_us = max(stats.worst_jitter_us, jitter_us);
+            }
+
+            // Rotor is not controlled during firmware updates
+            if (!firmware.is_updating) {
+                rotor_ctrl.tick();
+            }
+            stats.n_ticks++;
+
+            // Execution time of this tick
+            uint32_t tick_us = micros() - wake_us;
+            stats.max_tick_us = max(stats.max_tick_us, tick_us);
+            stats.worst_tick_us = max(stats.worst_tick_us, tick_us);
+            stats.sum_tick_us += tick_us;
+        }
+    }
+
+    // => Start the fixed-rate rotor control task, pinned to core 1
+    void start() {
+        if (control_task == nullptr) {
+            xTaskCreatePinnedToCore(controlTask, "rotor_ctrl", CONTROL_TASK_STACK_SIZE, nullptr,
+                                    CONTROL_TASK_PRIORITY, &control_task, CONTROL_TASK_CORE);
+            if (verbose) {
+                Serial.print("[Control] Task started with a period of ");
+                Serial.print(CONTROL_PERIOD_MS);
+                Serial.println(" ms.");
+            }
+        }
+    }
+
+    // => Print timing statistics to Serial and reset maxima since last report
+    void printStats() {
+        Serial.print("[Control] Ticks: ");
+        Serial.print(stats.n_ticks);
+        Serial.print(" | Period: ");
+        Serial.print(stats.last_period_us);
+        Serial.print(" us | Jitter (max/worst): ");
+        Serial.print(stats.max_jitter_us);
+        Serial.print(" / ");
+        Serial.print(stats.worst_jitter_us);
+        Serial.print(" us | Tick time (max/worst): ");
+        Serial.print(stats.max_tick_us);
+        Serial.print(" / ");
+        Serial.print(stats.worst_tick_us);
+        Serial.println(" us");
+        stats.max_jitter_us = 0;
+        stats.max_tick_us = 0;
+    }
+}
@@ -26,15 +26,30 @@ void Favorites::save() const {
 }
 
 // Set, save and send favorites from message
-void Favorites::set(char* msg) {
+void Favorites::set(const char* msg) {
     favs_buffer = (String) msg;
     save();
     send();
 }
 
-// Send favorites to clients
+// Send favorites to clients that subscribed to them
 void Favorites::send() const {
-    websocket.textAll(favs_buffer);
+    RotorSocket::SendPolicy policy;
+    RotorSocket::sendAll(policy, [this](const uint8_t topics, const bool binary, RotorSocket::Frame &frame) {
+        if (!(topics & TOPIC_FAVORITES)) {
+            return false;
+        }
+        frame.text = &favs_buffer;
+        return true;
+    });
+}
+
+// Append favorites message to a connect snapshot
+void Favorites::appendTo(String &buffer) const {
+    if (favs_buffer.length()) {
+        buffer += "\n";
+        buffer += favs_buffer;
+    }
 }
 
 Favorites favorites;
@@ -0,0 +1,183 @@
+#include <Arduino.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include <FlatJson.h>
+
+
+namespace FlatJson {
+
+    // *******************
+    // Define Pair members
+    // *******************
+
+    // => Value as number, booleans are 0 or 1, other types are 0
+    float Pair::toFloat() const {
+        switch (type) {
+            case Type::NUMBER:
+                return strtof(value, nullptr);
+            case Type::BOOL:
+                return value[0] == 't' ? 1.0f : 0.0f;
+            default:
+                return 0.0f;
+        }
+    }
+
+    // => Parse a number as integer, exact for integral numbers. Numbers with a fraction or
+    // exponent are rounded, limited to well beyond the 32 bit range.
+    long long parseInteger(const char* value) {
+        char* end;
+        const long long n = strtoll(value, &end, 10);
+        if (*end != '.' && *end != 'e' && *end != 'E') {
+            return n;
+        }
+        return llround(constrain(strtod(value, nullptr), -1e10, 1e10));
+    }
+
+    // => Value as integer, exact for integral numbers
+    int32_t Pair::toInt() const {
+        switch (type) {
+            case Type::NUMBER:
+                return (int32_t) constrain(parseInteger(value), (long long) INT32_MIN, (long long) INT32_MAX);
+            case Type::BOOL:
+                return value[0] == 't' ? 1 : 0;
+            default:
+                return 0;
+        }
+    }
+
+    uint32_t Pair::toUint() const {
+        switch (type) {
+            case Type::NUMBER:
+                return (uint32_t) constrain(parseInteger(value), 0LL, (long long) UINT32_MAX);
+            case Type::BOOL:
+                return value[0] == 't' ? 1 : 0;
+            default:
+                return 0;
+        }
+    }
+
+    // => Value as boolean, numbers are true if not 0
+    bool Pair::toBool() const {
+        switch (type) {
+            case Type::BOOL:
+                return value[0] == 't';
+            case Type::NUMBER:
+                return strtof(value, nullptr) != 0.0f;
+            default:
+                return false;
+        }
+    }
+
+    // *********************
+    // Define Reader members
+    // *********************
+
+    // => Start reading an object from buffer, must begin with '{'
+    Reader::Reader(const char* json, const size_t len) : pos(json), end(json + len) {
+        if (!skipSpace() || *pos != '{') {
+            error = true;
+            pos = end;
+            return;
+        }
+        ++pos;
+    }
+
+    // => Skip whitespace, return false at end of buffer
+    bool Reader::skipSpace() {
+        while (pos < end && (*pos == ' ' || *pos == '\t' || *pos == '\n' || *pos == '\r')) {
+            ++pos;
+        }
+        return pos < end;
+    }
+
+    // => Read next pair
+    bool Reader::next(Pair &pair) {
+        if (error || !skipSpace()) {
+            error = error || pos >= end;
+            return false;
+        }
+
+        // End of object, or separator before next pair
+        if (*pos == '}') {
+            pos = end;
+            return false;
+        }
+        if (*pos == ',') {
+            ++pos;
+            if (!skipSpace()) {
+                error = true;
+                return false;
+            }
+        }
+
+        // Key
+        if (*pos != '"') {
+            error = true;
+            return false;
+        }
+        pair.key = ++pos;
+        while (pos < end && *pos != '"') {
+            pos += (*pos == '\\') ? 2 : 1;
+        }
+        if (pos >= end) {
+            error = true;
+            return false;
+        }
+        pair.key_len = pos - pair.key;
+        ++pos;
+
+        // Colon
+        if (!skipSpace() || *pos != ':') {
+            error = true;
+            return false;
+        }
+        ++pos;
+        if (!skipSpace()) {
+            error = true;
+            return false;
+        }
+
+        // Value
+        const char c = *pos;
+        if (c == '"') {
+            pair.type = Type::STRING;
+            pair.value = ++pos;
+            while (pos < end && *pos != '"') {
+                pos += (*pos == '\\') ? 2 : 1;
+            }
+            if (pos >= end) {
+                error = true;
+                return false;
+            }
+            pair.value_len = pos - pair.value;
+            ++pos;
+            return true;
+        }
+        if (c == '{' || c == '[') {
+            error = true;
+            return false;
+        }
+
+        // Literals and numbers end at the next separator
+        pair.value = pos;
+        while (pos < end && *pos != ',' && *pos != '}' && *pos != ' ' && *pos != '\n' && *pos != '\r' && *pos != '\t') {
+            ++pos;
+        }
+        pair.value_len = pos - pair.value;
+
+        if (pair.value_len == 4 && strncmp(pair.value, "true", 4) == 0) {
+            pair.type = Type::BOOL;
+        } else if (pair.value_len == 5 && strncmp(pair.value, "false", 5) == 0) {
+            pair.type = Type::BOOL;
+        } else if (pair.value_len == 4 && strncmp(pair.value, "null", 4) == 0) {
+            pair.type = Type::NUL;
+        } else if (c == '-' || (c >= '0' && c <= '9')) {
+            pair.type = Type::NUMBER;
+        } else {
+            error = true;
+            return false;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,211 @@
+#include <Arduino.h>
+#include <AsyncTCP.h>
+#include <math.h>
+
+#include <globals.h>
+#include <RotorController.h>    // Exposes Global: rotor_ctrl
+#include <GS232.h>
+
+#define GS232_RESPONSE_SIZE 32
+#define GS232_MAX_AZ 450
+// Bytes read from UART2 per loop cycle
+#define GS232_SERIAL_CHUNK 64
+// Speed in % for X1 to X4
+#define GS232_SPEED_STEP 25
+
+
+namespace GS232 {
+
+  AsyncServer* server = nullptr;
+
+  // TCP connections
+  struct Connection {
+    AsyncClient* client = nullptr;
+    LineBuffer buffer;
+  };
+  Connection connections[GS232_MAX_CLIENTS];
+  uint8_t clients_connected = 0;
+
+  // UART2 line
+  LineBuffer serial_buffer;
+
+  // Counters since boot
+  struct {
+    uint32_t n_commands = 0;
+    uint32_t n_errors = 0;
+  } stats;
+
+  // => Hand a command on, stamped with the time it was received
+  void post(Rotor::Command cmd, Rotor::PostCommand post_cmd) {
+    cmd.rx_us = micros();
+    post_cmd(cmd);
+  }
+
+  // => Azimuth of the last published rotor state, rounded to 0° to 450°
+  int getAzimuth() {
+    return constrain((int) lround(rotor_ctrl.getSnapshot().angle), 0, GS232_MAX_AZ);
+  }
+
+  // => Parse a three digit angle, -1 if invalid
+  int parseAngle(const char* digits) {
+    if (strlen(digits) < 3 || !isdigit(digits[0]) || !isdigit(digits[1]) || !isdigit(digits[2])) {
+      return -1;
+    }
+    const int angle = (digits[0] - '0') * 100 + (digits[1] - '0') * 10 + (digits[2] - '0');
+    return angle <= GS232_MAX_AZ ? angle : -1;
+  }
+
+  // => Handle one command, response is empty for commands without answer
+  void handleCommand(char* line, Rotor::PostCommand post_cmd, char* response, const size_t size) {
+    response[0] = '\0';
+    stats.n_commands++;
+    const char cmd = toupper(line[0]);
+    const char* arg = line + 1;
+    while (*arg == ' ') { ++arg; }
+
+    switch (cmd) {
+      // Position
+      case 'C':
+        #ifdef GS232_A
+        snprintf(response, size, arg[0] == '2' ? "+0%03d+0000\r\n" : "+0%03d\r\n", getAzimuth());
+        #else
+        snprintf(response, size, arg[0] == '2' ? "AZ=%03d  EL=000\r\n" : "AZ=%03d\r\n", getAzimuth());
+        #endif
+        return;
+
+      // Turn to azimuth, Waaa eee ignores the elevation
+      case 'M':
+      case 'W': {
+        const int azimuth = parseAngle(arg);
+        if (azimuth >= 0) {
+          post(Rotor::Command::rotateTo(azimuth, rotor_ctrl.settings.use_overlap,
+                                        rotor_ctrl.settings.use_smooth_speed), post_cmd);
+          return;
+        }
+        break;
+      }
+
+      // Turn clockwise / counter-clockwise
+      case 'R':
+        post(Rotor::Command::rotate(1), post_cmd);
+        return;
+      case 'L':
+        post(Rotor::Command::rotate(0), post_cmd);
+        return;
+
+      // Stop azimuth / all
+      case 'A':
+      case 'S':
+        post(Rotor::Command::stop(), post_cmd);
+        return;
+
+      // Speed X1 (slowest) to X4 (fastest)
+      case 'X':
+        if (arg[0] >= '1' && arg[0] <= '4') {
+          post(Rotor::Command::setSpeed((arg[0] - '0') * GS232_SPEED_STEP), post_cmd);
+          return;
+        }
+        break;
+    }
+
+    // Unknown command or invalid argument
+    stats.n_errors++;
+    snprintf(response, size, "?>\r\n");
+  }
+
+  // => Collect received bytes and handle complete commands
+  void feed(LineBuffer &buffer, const char* data, const size_t len, Rotor::PostCommand post_cmd,
+            Respond respond, void* ctx) {
+    char response[GS232_RESPONSE_SIZE];
+    for (size_t i = 0; i < len; ++i) {
+      const char c = data[i];
+      if (c == '\r' || c == '\n') {
+        if (buffer.overflow) {
+          stats.n_errors++;
+          respond(ctx, "?>\r\n");
+        } else if (buffer.len) {
+          buffer.line[buffer.len] = '\0';
+          handleCommand(buffer.line, post_cmd, response, sizeof(response));
+          if (response[0]) {
+            respond(ctx, response);
+          }
+        }
+        buffer.len = 0;
+        buffer.overflow = false;
+      } else if (buffer.len < GS232_LINE_SIZE - 1) {
+        buffer.line[buffer.len++] = c;
+      } else {
+        buffer.overflow = true;
+      }
+    }
+  }
+
+  // => Handle input pending on UART2, never waits for input
+  void pollSerial() {
+    char data[GS232_SERIAL_CHUNK];
+    const size_t len = Serial2.read((uint8_t*) data, min((size_t) Serial2.available(), sizeof(data)));
+    if (len) {
+      feed(serial_buffer, data, len, Rotor::postToControl, [](void* ctx, const char* response) {
+        Serial2.print(response);
+      }, nullptr);
+    }
+  }
+
+  // => Accept a new TCP connection if a slot is free
+  void onClient(void* arg, AsyncClient* client) {
+    Connection* conn = nullptr;
+    for (Connection &candidate : connections) {
+      if (candidate.client == nullptr) {
+        conn = &candidate;
+        break;
+      }
+    }
+    if (conn == nullptr) {
+      client->onDisconnect([](void* arg, AsyncClient* client) { delete client; }, nullptr);
+      client->close(true);
+      return;
+    }
+    conn->client = client;
+    conn->buffer = LineBuffer();
+    ++clients_connected;
+
+    client->setNoDelay(true);
+    client->onData([](void* arg, AsyncClient* client, void* data, size_t len) {
+      Connection* conn = (Connection*) arg;
+      feed(conn->buffer, (const char*) data, len, Rotor::postToControl, [](void* ctx, const char* response) {
+        ((AsyncClient*) ctx)->write(response, strlen(response));
+      }, client);
+    }, conn);
+    client->onDisconnect([](void* arg, AsyncClient* client) {
+      ((Connection*) arg)->client = nullptr;
+      --clients_connected;
+      if (verbose) { Serial.println("[GS-232] Client disconnected."); }
+      delete client;
+    }, conn);
+
+    if (verbose) {
+      Serial.print("[GS-232] Client connected with IP: ");
+      Serial.println(client->remoteIP());
+    }
+  }
+
+  // => Start UART2 and the TCP listener
+  void init() {
+    Serial2.begin(GS232_BAUD, SERIAL_8N1, gs232_pins[0], gs232_pins[1]);
+
+    if (server == nullptr) {
+      server = new AsyncServer(GS232_TCP_PORT);
+      server->onClient(onClient, nullptr);
+      server->begin();
+    }
+    if (verbose) {
+      Serial.printf("[GS-232] Listening on UART2 (%u baud) and port %u\n\r", GS232_BAUD, GS232_TCP_PORT);
+    }
+  }
+
+  // => Print command counters to Serial
+  void printStats() {
+    Serial.printf("[GS-232] TCP clients: %u | Commands: %u (errors %u)\n\r",
+                  clients_connected, stats.n_commands, stats.n_errors);
+  }
+}
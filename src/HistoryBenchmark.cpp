@@ -0,0 +1,78 @@
+#include <Arduino.h>
+
+#include <HistoryBenchmark.h>
+#include <RotationHistory.h>
+#include <RotorController.h>
+
+#define HISTORY_BENCHMARK_CHUNK_SIZE 1024
+// Time between simulated samples, as often as the loop records
+#define HISTORY_BENCHMARK_STEP_MS 50
+
+
+namespace HistoryBenchmark {
+
+    // => Read the whole history, return the number of bytes and count lines
+    size_t exportAll(const Rotor::RotationHistory &history, const bool csv, uint8_t *buffer, uint32_t &n_lines) {
+        Rotor::HistoryReader reader(history, 0, csv);
+        size_t n_bytes = 0;
+        size_t n;
+        n_lines = 0;
+        while ((n = reader.read(buffer, HISTORY_BENCHMARK_CHUNK_SIZE)) > 0) {
+            n_bytes += n;
+            for (size_t i = 0; i < n; ++i) {
+                n_lines += buffer[i] == '\n';
+            }
+        }
+        return n_bytes;
+    }
+
+    // => Record N samples of a simulated rotor into a scratch history and print size and timing
+    void run(const uint32_t n_samples) {
+        Rotor::RotationHistory* history = new Rotor::RotationHistory();
+        uint8_t* buffer = new uint8_t[HISTORY_BENCHMARK_CHUNK_SIZE];
+        history->init();
+
+        // Rotor turning for 30 s and resting for 30 s, alternately
+        Rotor::Snapshot state;
+        state.angle = 180.0f;
+        unsigned long record_us = 0;
+        for (uint32_t i = 0; i < n_samples; ++i) {
+            state.ms = i * HISTORY_BENCHMARK_STEP_MS;
+            state.is_rotating = (state.ms / 30000) % 2;
+            state.direction = (state.ms / 60000) % 2;
+            state.current_speed = state.is_rotating ? 75 : 0;
+            if (state.is_rotating) {
+                state.angle += (state.direction ? 1 : -1) * 4.3f * HISTORY_BENCHMARK_STEP_MS / 1000.0f;
+            }
+            const unsigned long start_us = micros();
+            history->record(state);
+            record_us += micros() - start_us;
+        }
+
+        // Export, the CSV has a line per sample held plus the column names
+        uint32_t n_lines;
+        unsigned long start_us = micros();
+        const size_t csv_bytes = exportAll(*history, true, buffer, n_lines);
+        const unsigned long csv_us = micros() - start_us;
+        const uint32_t n_held = n_lines ? n_lines - 1 : 0;
+        start_us = micros();
+        const size_t binary_bytes = exportAll(*history, false, buffer, n_lines);
+        const unsigned long binary_us = micros() - start_us;
+
+        // Encoded size against plain samples
+        const size_t used = history->usedBytes();
+        const float bytes_per_sample = n_held ? (float) used / n_held : 0.0f;
+        const float duration_s = n_samples * HISTORY_BENCHMARK_STEP_MS / 1000.0f;
+        const float span_s = history->n_samples ? duration_s * n_held / history->n_samples : 0.0f;
+        Serial.printf("[Benchmark] History: %u B RAM (%u blocks of %u B) | %u of %u samples recorded, %u held (%.0f s)\n\r",
+                      sizeof(Rotor::RotationHistory), HISTORY_BLOCKS, HISTORY_BLOCK_SIZE,
+                      history->n_samples, n_samples, n_held, span_s);
+        Serial.printf("[Benchmark] Encoded: %u B, %.2f B per sample (plain: %u B) | Record: %.2f us per call\n\r",
+                      used, bytes_per_sample, sizeof(Rotor::HistorySample), (float) record_us / n_samples);
+        Serial.printf("[Benchmark] Export CSV: %u B in %lu us (%.2f us per sample) | Binary: %u B in %lu us\n\r",
+                      csv_bytes, csv_us, n_held ? (float) csv_us / n_held : 0.0f, binary_bytes, binary_us);
+
+        delete[] buffer;
+        delete history;
+    }
+}
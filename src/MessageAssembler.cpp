@@ -0,0 +1,106 @@
+#include <Arduino.h>
+
+#include <MessageAssembler.h>
+
+namespace RotorSocket {
+
+  // => Take a free buffer, false if all are in use
+  bool MessageAssembler::acquire(int8_t &slot) {
+    uint8_t n_used = 1;
+    int8_t free_slot = -1;
+    for (int8_t i = 0; i < SOCKET_REASSEMBLY_SLOTS; ++i) {
+      if (arena[i].in_use) {
+        ++n_used;
+      } else if (free_slot < 0) {
+        free_slot = i;
+      }
+    }
+    if (free_slot < 0) {
+      return false;
+    }
+    Slot &buffer = arena[free_slot];
+    buffer.in_use = true;
+    buffer.len = 0;
+    buffer.too_large = false;
+    buffer.start_us = micros();
+    slot = free_slot;
+    stats.max_slots_used = max(stats.max_slots_used, n_used);
+    return true;
+  }
+
+  // => Return the buffer of a client to the arena
+  void MessageAssembler::release(int8_t &slot) {
+    if (slot >= 0) {
+      arena[slot].in_use = false;
+    }
+    slot = -1;
+  }
+
+  // => Feed the data of a websocket data event
+  char* MessageAssembler::feed(int8_t &slot, const AwsFrameInfo &info, uint8_t* data, const size_t len, size_t &msg_len) {
+    // Continuation frames are single frames too, only the first frame of a message is whole
+    if (info.final && info.num == 0 && info.index == 0 && info.len == len) {
+      if (info.opcode != WS_TEXT) {
+        Serial.println("[Websocket] Binary data received unexpectedly.");
+        return nullptr;
+      }
+      data[len] = 0;
+      msg_len = len;
+      return (char*) data;
+    }
+
+    // Message arrives in several frames or TCP segments
+    return feedPiece(slot, info, data, len, msg_len);
+  }
+
+  // => Collect a piece of a message split into several frames or TCP segments.
+  // Returns the message once its last piece arrived.
+  char* MessageAssembler::feedPiece(int8_t &slot, const AwsFrameInfo &info, uint8_t* data, const size_t len, size_t &msg_len) {
+    if (info.message_opcode != WS_TEXT) {
+      return nullptr;
+    }
+
+    // First piece of a new message
+    if (info.num == 0 && info.index == 0) {
+      release(slot);
+      if (!acquire(slot)) {
+        stats.n_no_slot++;
+        Serial.println("[Websocket] No reassembly buffer free, message dropped.");
+        return nullptr;
+      }
+    }
+    if (slot < 0) {
+      return nullptr;
+    }
+
+    // Append piece, unless message is too large
+    Slot &buffer = arena[slot];
+    if (buffer.len + len > SOCKET_MAX_MESSAGE_SIZE) {
+      buffer.too_large = true;
+    } else {
+      memcpy(buffer.data + buffer.len, data, len);
+      buffer.len += len;
+    }
+
+    // Last piece of the last frame
+    if (!info.final || info.index + len != info.len) {
+      return nullptr;
+    }
+    char* msg = nullptr;
+    if (buffer.too_large) {
+      stats.n_too_large++;
+      Serial.println("[Websocket] Message too large, dropped.");
+    } else {
+      stats.last_us = micros() - buffer.start_us;
+      stats.max_us = max(stats.max_us, stats.last_us);
+      stats.max_size = max(stats.max_size, buffer.len);
+      stats.n_messages++;
+      buffer.data[buffer.len] = '\0';
+      msg_len = buffer.len;
+      msg = buffer.data;
+    }
+    // The buffer is not reused before the next piece is fed
+    release(slot);
+    return msg;
+  }
+}
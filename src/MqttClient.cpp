@@ -0,0 +1,279 @@
+#include <Arduino.h>
+#include <WiFi.h>
+#include <Preferences.h>
+#include <espMqttClientAsync.h>
+#include <math.h>
+#include <atomic>
+
+#include <globals.h>
+#include <Timer.h>
+#include <RotorController.h>    // Exposes Global: rotor_ctrl
+#include <RotorSocket.h>
+#include <MqttClient.h>
+
+#define MQTT_PREFS_KEY "mqttPrefs"
+#define MQTT_TOPIC_SIZE 64
+#define MQTT_CLIENT_ID_SIZE 40
+#define MQTT_PAYLOAD_SIZE 128
+#define MQTT_MAX_COMMAND_SIZE 512
+#define MQTT_RECONNECT_INTERVAL_MS 5000
+#define MQTT_KEEP_ALIVE_S 30
+// Smallest angle change published at rest, filters ADC noise
+#define MQTT_MIN_ANGLE_CHANGE 0.5f
+
+
+namespace Mqtt {
+  // In use by the client, only changed by the loop
+  Config config;
+
+  // Set by the web server, applied by the loop. Both configs are guarded by config_lock.
+  Config pending_config;
+  std::atomic<bool> has_pending_config{false};
+  SemaphoreHandle_t config_lock = nullptr;
+
+  espMqttClientAsync client;
+  Preferences prefs;
+  Timer reconnect{MQTT_RECONNECT_INTERVAL_MS};
+
+  // Topics below the base topic, built when the config is applied
+  char status_topic[MQTT_TOPIC_SIZE];
+  char state_topic[MQTT_TOPIC_SIZE];
+  char telemetry_topic[MQTT_TOPIC_SIZE];
+  char cmd_topic[MQTT_TOPIC_SIZE];
+  char client_id[MQTT_CLIENT_ID_SIZE];
+
+  // Command being handled, written by the async_tcp task only
+  char cmd_buffer[MQTT_MAX_COMMAND_SIZE + 1];
+
+  // Last published state, republished on every (re)connect
+  struct {
+    bool is_valid = false;
+    float angle = 0.0f;
+    float target = 0.0f;
+    int8_t rotation = 0;
+    bool is_auto_rotating = false;
+    uint8_t speed = 0;
+  } published;
+  unsigned long last_telemetry_ms = 0;
+
+  // Counters since boot
+  struct {
+    uint32_t n_connects = 0;
+    uint32_t n_disconnects = 0;
+    uint32_t n_published = 0;
+    uint32_t n_publish_failed = 0;  // Not queued, outbox full or disconnected
+    uint32_t n_commands = 0;
+    uint32_t n_commands_dropped = 0;  // Too large or fragmented
+  } stats;
+
+  // => Publish a message, QoS 0
+  void publish(const char* topic, const char* payload, const bool retain) {
+    if (client.publish(topic, 0, retain, payload)) {
+      stats.n_published++;
+    } else {
+      stats.n_publish_failed++;
+    }
+  }
+
+  // => Rotation of a rotor state, -1: CCW, 0: stop, 1: CW
+  int8_t getRotation(const Rotor::Snapshot &state) {
+    if (!state.is_rotating) {
+      return 0;
+    }
+    return state.direction ? 1 : -1;
+  }
+
+  // => Publish rotor state as retained message
+  void publishState(const Rotor::Snapshot &state) {
+    published.is_valid = true;
+    published.angle = state.angle;
+    published.target = state.target;
+    published.rotation = getRotation(state);
+    published.is_auto_rotating = state.is_auto_rotating;
+    published.speed = state.max_speed;
+
+    // Target is only meaningful during auto-rotation
+    char target[16] = "null";
+    if (published.is_auto_rotating) {
+      snprintf(target, sizeof(target), "%.1f", published.target);
+    }
+    char payload[MQTT_PAYLOAD_SIZE];
+    snprintf(payload, sizeof(payload),
+             "{\"angle\":%.1f,\"target\":%s,\"rotation\":%d,\"auto\":%s,\"speed\":%u}",
+             published.angle, target, published.rotation,
+             published.is_auto_rotating ? "true" : "false", published.speed);
+    publish(state_topic, payload, true);
+  }
+
+  // => Publish angle, angular speed and time of the measurement
+  void publishTelemetry(const Rotor::Snapshot &state) {
+    char payload[MQTT_PAYLOAD_SIZE];
+    snprintf(payload, sizeof(payload), "{\"angle\":%.2f,\"v\":%.2f,\"t\":%lu}",
+             state.angle, state.angular_speed, state.ms);
+    publish(telemetry_topic, payload, false);
+  }
+
+  // => Return wether the state differs from the last published one
+  bool stateChanged(const Rotor::Snapshot &state) {
+    return !published.is_valid
+        || getRotation(state) != published.rotation
+        || state.is_auto_rotating != published.is_auto_rotating
+        || (state.is_auto_rotating && state.target != published.target)
+        || state.max_speed != published.speed
+        || (!state.is_rotating && abs(state.angle - published.angle) >= MQTT_MIN_ANGLE_CHANGE);
+  }
+
+  // => Broker accepted the connection
+  void onConnect(bool session_present) {
+    stats.n_connects++;
+    client.subscribe(cmd_topic, 0);
+    publish(status_topic, "online", true);
+    published.is_valid = false;
+    if (verbose) {
+      Serial.println("[MQTT] Connected to broker.");
+    }
+  }
+
+  void onDisconnect(espMqttClientTypes::DisconnectReason reason) {
+    stats.n_disconnects++;
+    if (verbose) {
+      Serial.printf("[MQTT] Disconnected, reason %u\n\r", (uint8_t) reason);
+    }
+  }
+
+  // => Command received, handled like a websocket rotor message
+  void onMessage(const espMqttClientTypes::MessageProperties &properties, const char* topic,
+                 const uint8_t* payload, size_t len, size_t index, size_t total) {
+    if (index != 0 || len != total || len > MQTT_MAX_COMMAND_SIZE) {
+      stats.n_commands_dropped++;
+      return;
+    }
+    stats.n_commands++;
+    memcpy(cmd_buffer, payload, len);
+    cmd_buffer[len] = '\0';
+    RotorSocket::receiveMessage(cmd_buffer, len);
+  }
+
+  // => Set server, credentials, client id and topics from config
+  void applyConfig() {
+    snprintf(status_topic, sizeof(status_topic), "%s/status", config.base_topic);
+    snprintf(state_topic, sizeof(state_topic), "%s/state", config.base_topic);
+    snprintf(telemetry_topic, sizeof(telemetry_topic), "%s/telemetry", config.base_topic);
+    snprintf(cmd_topic, sizeof(cmd_topic), "%s/cmd", config.base_topic);
+
+    client.setServer(config.host, config.port);
+    client.setCredentials(config.user[0] ? config.user : nullptr,
+                          config.password[0] ? config.password : nullptr);
+    client.setWill(status_topic, 0, true, "offline");
+  }
+
+  // => Load config from Preferences and set up the client
+  void init() {
+    config_lock = xSemaphoreCreateMutex();
+    if (!prefs.begin(MQTT_PREFS_KEY, true) && verbose) {
+      Serial.println("[MQTT] Could not load configuration! Use default configuration instead.");
+    }
+    // Keys not stored keep the default
+    prefs.getString("host", config.host, sizeof(config.host));
+    config.port = prefs.getUShort("port", MQTT_PORT);
+    prefs.getString("user", config.user, sizeof(config.user));
+    prefs.getString("password", config.password, sizeof(config.password));
+    prefs.getString("topic", config.base_topic, sizeof(config.base_topic));
+    prefs.end();
+
+    String id = "RotorControl-" + esp_id;
+    id.replace(":", "");
+    strlcpy(client_id, id.c_str(), sizeof(client_id));
+    client.setClientId(client_id);
+    client.setKeepAlive(MQTT_KEEP_ALIVE_S);
+    client.onConnect(onConnect);
+    client.onDisconnect(onDisconnect);
+    client.onMessage(onMessage);
+    applyConfig();
+  }
+
+  // => Copy of the config, including one set but not yet applied
+  Config getConfig() {
+    if (config_lock == nullptr) {
+      return config;
+    }
+    xSemaphoreTake(config_lock, portMAX_DELAY);
+    const Config copy = has_pending_config ? pending_config : config;
+    xSemaphoreGive(config_lock);
+    return copy;
+  }
+
+  // => Check a config and hand it to the loop
+  bool setConfig(const Config &new_config) {
+    // Port needed to connect, topics without wildcards
+    if (config_lock == nullptr || (new_config.host[0] && !new_config.port)
+        || strchr(new_config.host, ' ') != nullptr
+        || !new_config.base_topic[0] || strpbrk(new_config.base_topic, "+#") != nullptr) {
+      return false;
+    }
+    xSemaphoreTake(config_lock, portMAX_DELAY);
+    pending_config = new_config;
+    has_pending_config = true;
+    xSemaphoreGive(config_lock);
+    return true;
+  }
+
+  // => Take over a config set by the web server, save it in Preferences and reconnect with it
+  void applyPendingConfig() {
+    // Pointers to the config buffers must not be used while they change
+    client.disconnect(true);
+    xSemaphoreTake(config_lock, portMAX_DELAY);
+    config = pending_config;
+    has_pending_config = false;
+    xSemaphoreGive(config_lock);
+    applyConfig();
+
+    if (!prefs.begin(MQTT_PREFS_KEY, false)) {
+      Serial.println("[MQTT] Error: Could not save configuration!");
+    } else {
+      prefs.putString("host", config.host);
+      prefs.putUShort("port", config.port);
+      prefs.putString("user", config.user);
+      prefs.putString("password", config.password);
+      prefs.putString("topic", config.base_topic);
+      prefs.end();
+    }
+
+    // Reconnected by the next update
+    reconnect.start();
+  }
+
+  // => Reconnect if needed and publish state changes
+  void update(const Rotor::Snapshot &state) {
+    if (has_pending_config) {
+      applyPendingConfig();
+    }
+    if (!client.connected()) {
+      // Connecting runs in the background, the result arrives with onConnect / onDisconnect
+      if (config.host[0] && client.disconnected() && WiFi.isConnected() && reconnect.passed()) {
+        client.connect();
+      }
+      return;
+    }
+
+    if (stateChanged(state)) {
+      publishState(state);
+    }
+    if (state.is_rotating && state.ms - last_telemetry_ms >= MQTT_TELEMETRY_INTERVAL_MS) {
+      last_telemetry_ms = state.ms;
+      publishTelemetry(state);
+    }
+  }
+
+  // => Return wether the client is connected to the broker
+  bool isConnected() {
+    return client.connected();
+  }
+
+  // => Print connection and message counters to Serial
+  void printStats() {
+    Serial.printf("[MQTT] %s | Connects: %u (lost %u) | Published: %u (failed %u) | Commands: %u (dropped %u)\n\r",
+                  client.connected() ? "Connected" : "Disconnected", stats.n_connects, stats.n_disconnects,
+                  stats.n_published, stats.n_publish_failed, stats.n_commands, stats.n_commands_dropped);
+  }
+}
@@ -0,0 +1,109 @@
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#include <ParserBenchmark.h>
+#include <SocketMessages.h>
+#include <RotorSocket.h>
+
+#define PARSER_BENCHMARK_BUFFER_SIZE 128
+
+
+namespace ParserBenchmark {
+
+    // Typical messages sent by the UI
+    const char* samples[] = {
+        MSG_ID_ROTOR "|{\"rotation\":-1}",
+        MSG_ID_ROTOR "|{\"speed\":75}",
+        MSG_ID_ROTOR "|{\"target\":231.5,\"useOverlap\":true,\"useSmoothSpeed\":false}",
+        MSG_ID_CALIBRATION "|{\"a1\":0,\"u1\":0.0312,\"a2\":450,\"u2\":4.4923}",
+        MSG_ID_SETTINGS "|{\"useScreen\":true}",
+        MSG_ID_PROTOCOL "|{\"binary\":true}"
+    };
+
+    // Sink, keeps the compiler from removing parsed values
+    volatile float sink = 0.0f;
+
+    // => Previous implementation: String identifier, sequential comparisons, ArduinoJson document
+    void parseWithDocument(char* msg, const size_t len) {
+        int sep_idx;
+        for (sep_idx = 0; sep_idx < len; ++sep_idx) {
+            if (msg[sep_idx] == '|') { break; }
+        }
+        msg[sep_idx] = '\0';
+        String identifier(msg);
+        char* payload = msg + sep_idx + 1;
+
+        if (identifier == MSG_ID_ROTOR) {
+            StaticJsonDocument<50> doc;
+            if (!deserializeJson(doc, payload)) {
+                sink = doc["rotation"].as<int>() + doc["speed"].as<int>() + doc["target"].as<float>()
+                     + doc["useOverlap"].as<bool>() + doc["useSmoothSpeed"].as<bool>();
+            }
+        } else if (identifier == MSG_ID_CALIBRATION) {
+            StaticJsonDocument<100> doc;
+            if (!deserializeJson(doc, payload)) {
+                sink = doc["u1"].as<float>() + doc["u2"].as<float>() + doc["a1"].as<float>()
+                     + doc["a2"].as<float>() + doc["offset"].as<float>();
+            }
+        } else if (identifier == MSG_ID_SETTINGS) {
+            StaticJsonDocument<48> doc;
+            if (!deserializeJson(doc, payload)) {
+                sink = doc["useScreen"].as<bool>();
+            }
+        } else if (identifier == MSG_ID_PROTOCOL) {
+            StaticJsonDocument<32> doc;
+            if (!deserializeJson(doc, payload)) {
+                sink = doc["binary"].as<bool>();
+            }
+        }
+    }
+
+    // => Current implementation: identifier lookup and in-place parsing
+    void parseInPlace(char* msg, const size_t len) {
+        const char* sep = (const char*) memchr(msg, '|', len);
+        const size_t id_len = sep - msg;
+        const char* payload = sep + 1;
+        const size_t payload_len = len - id_len - 1;
+
+        if (id_len == sizeof(MSG_ID_ROTOR) - 1 && memcmp(msg, MSG_ID_ROTOR, id_len) == 0) {
+            SocketMessages::RotorMsg parsed;
+            SocketMessages::parse(payload, payload_len, parsed);
+            sink = parsed.rotation + parsed.speed + parsed.target + parsed.use_overlap + parsed.use_smooth_speed;
+        } else if (id_len == sizeof(MSG_ID_CALIBRATION) - 1 && memcmp(msg, MSG_ID_CALIBRATION, id_len) == 0) {
+            SocketMessages::CalibrationMsg parsed;
+            SocketMessages::parse(payload, payload_len, parsed);
+            sink = parsed.u1 + parsed.u2 + parsed.a1 + parsed.a2 + parsed.offset;
+        } else if (id_len == sizeof(MSG_ID_SETTINGS) - 1 && memcmp(msg, MSG_ID_SETTINGS, id_len) == 0) {
+            SocketMessages::SettingsMsg parsed;
+            SocketMessages::parse(payload, payload_len, parsed);
+            sink = parsed.use_screen;
+        } else if (id_len == sizeof(MSG_ID_PROTOCOL) - 1 && memcmp(msg, MSG_ID_PROTOCOL, id_len) == 0) {
+            SocketMessages::ProtocolMsg parsed;
+            SocketMessages::parse(payload, payload_len, parsed);
+            sink = parsed.binary;
+        }
+    }
+
+    // => Time a parser over all iterations of one sample, in µs per message.
+    // The sample is copied into the frame buffer first, as both parsers may modify it.
+    float timeParser(void (*parser)(char*, const size_t), const char* sample, const uint32_t iterations) {
+        char buffer[PARSER_BENCHMARK_BUFFER_SIZE];
+        const size_t len = strlen(sample);
+        const unsigned long start_us = micros();
+        for (uint32_t i = 0; i < iterations; ++i) {
+            memcpy(buffer, sample, len + 1);
+            parser(buffer, len);
+        }
+        return (float) (micros() - start_us) / iterations;
+    }
+
+    // => Parse every sample message N times with both parsers and print µs per message
+    void run(const uint32_t iterations) {
+        Serial.printf("[Benchmark] Parsing each message %u times (ArduinoJson / in place):\n\r", iterations);
+        for (const char* sample : samples) {
+            const float doc_us = timeParser(parseWithDocument, sample, iterations);
+            const float in_place_us = timeParser(parseInPlace, sample, iterations);
+            Serial.printf("[Benchmark] %6.2f / %6.2f us | %s\n\r", doc_us, in_place_us, sample);
+        }
+    }
+}
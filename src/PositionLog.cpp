@@ -0,0 +1,336 @@
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <math.h>
+#include <time.h>
+
+#include <globals.h>
+#include <SimpleFS.h>
+#include <Varint.h>
+#include <PositionLog.h>
+#include <RotationHistory.h>
+#include <RotorController.h>
+
+// Samples are logged at most this often while moving, unless the state changes
+#define LOG_MIN_INTERVAL_MS 1000
+// A stationary rotor is logged this often
+#define LOG_IDLE_INTERVAL_MS 60000
+// Smallest angle change logged before the idle interval, in 1/100 °
+#define LOG_MIN_ANGLE_CHANGE 10
+// Keyframe: tag, four varints and the speed byte
+#define LOG_MAX_RECORD_SIZE (2 + 4 * Varint::MAX_SIZE)
+// Clocks before this unix time were not set
+#define LOG_MIN_UNIX_TIME 1600000000UL
+// Download stream header: "RL", version, time unit
+#define LOG_STREAM_VERSION 1
+#define LOG_STREAM_HEADER_SIZE 4
+// Index entry: unix time and offset of a batch
+#define LOG_INDEX_ENTRY_SIZE 8
+
+
+namespace Rotor {
+
+    // **************************
+    // Define PositionLog members
+    // **************************
+
+    // => Path of a segment or index file, zero padded so names sort by sequence
+    void PositionLog::path(char *buffer, const size_t len, const uint32_t seq, const bool index) {
+        snprintf(buffer, len, LOG_DIR "/%08u.%s", seq, index ? "idx" : "seg");
+    }
+
+    // => Find segments on the filesystem and log the boot, to be called once after mounting it
+    bool PositionLog::init(const uint32_t boot, const Snapshot &state) {
+        boot_id = boot;
+        lock = xSemaphoreCreateMutex();
+
+        if (!LittleFS.exists(LOG_DIR) && !LittleFS.mkdir(LOG_DIR)) {
+            Serial.println("[Log] Failed to create " LOG_DIR ".");
+            return false;
+        }
+
+        // Oldest and newest segment
+        File dir = LittleFS.open(LOG_DIR);
+        File file = dir.openNextFile();
+        while (file) {
+            const char* name = strrchr(file.name(), '/');
+            name = name != nullptr ? name + 1 : file.name();
+            if (strstr(name, ".seg") != nullptr) {
+                const uint32_t seq = strtoul(name, nullptr, 10);
+                if (seq && (!first_seq || seq < first_seq)) {
+                    first_seq = seq;
+                }
+                if (seq > last_seq) {
+                    last_seq = seq;
+                    segment_size = file.size();
+                }
+            }
+            file = dir.openNextFile();
+        }
+        is_ready = true;
+
+        record(state);
+        event(LOG_EVENT_BOOT, boot_id);
+        if (verbose) { printStats(); }
+        return true;
+    }
+
+    // => Start a batch with an absolute keyframe
+    void PositionLog::writeKeyframe(const uint32_t ms) {
+        const time_t now = time(nullptr);
+        batch_unix = now > LOG_MIN_UNIX_TIME ? now : 0;
+        batch_start_ms = millis();
+        last.ms = ms;
+
+        batch_len = 0;
+        batch[batch_len++] = LOG_TAG_KEYFRAME | (last.state & LOG_TAG_STATE_MASK);
+        batch_len += Varint::put(batch + batch_len, boot_id);
+        batch_len += Varint::put(batch + batch_len, batch_unix);
+        batch_len += Varint::put(batch + batch_len, last.ms);
+        batch_len += Varint::put(batch + batch_len, Varint::zigzag(last.angle));
+        batch[batch_len++] = last.speed;
+    }
+
+    // => Make room for a record, writes the batch if it is full
+    void PositionLog::reserve(const size_t len) {
+        if (batch_len + len > LOG_BATCH_SIZE) {
+            flush(true);
+        }
+    }
+
+    // => Log a sample if the rotor moved, changed state or was idle for long
+    void PositionLog::record(const Snapshot &state) {
+        if (!is_ready) {
+            return;
+        }
+        const int32_t angle = lround(state.angle * 100.0f);
+        const uint8_t tag_state = (state.is_rotating ? HISTORY_ROTATING : 0)
+                                | (state.direction ? HISTORY_CW : 0)
+                                | (state.is_auto_rotating ? HISTORY_AUTO : 0);
+
+        // Events are stamped with millis(), which may be ahead of the snapshot
+        const uint32_t elapsed = (int32_t) (state.ms - last.ms) > 0 ? state.ms - last.ms : 0;
+        if (has_last) {
+            const bool changed = tag_state != last.state || state.current_speed != last.speed;
+            const bool moved = abs(angle - last.angle) >= LOG_MIN_ANGLE_CHANGE;
+            if (!changed && (elapsed < LOG_MIN_INTERVAL_MS || (!moved && elapsed < LOG_IDLE_INTERVAL_MS))) {
+                return;
+            }
+        }
+
+        reserve(LOG_MAX_RECORD_SIZE);
+        const bool speed_changed = state.current_speed != last.speed;
+        const uint32_t units = elapsed / LOG_TIME_UNIT_MS;
+        const int32_t angle_delta = angle - last.angle;
+        last.angle = angle;
+        last.speed = state.current_speed;
+        last.state = tag_state;
+        has_last = true;
+
+        // A new batch starts with this sample as keyframe
+        if (batch_len == 0) {
+            writeKeyframe(state.ms);
+        } else {
+            batch[batch_len++] = tag_state | (speed_changed ? LOG_TAG_SPEED : 0);
+            batch_len += Varint::put(batch + batch_len, units);
+            batch_len += Varint::put(batch + batch_len, Varint::zigzag(angle_delta));
+            if (speed_changed) {
+                batch[batch_len++] = last.speed;
+            }
+            last.ms += units * LOG_TIME_UNIT_MS;
+        }
+        n_records++;
+    }
+
+    // => Log an event
+    void PositionLog::event(const LogEvent code, const uint32_t arg) {
+        if (!is_ready) {
+            return;
+        }
+        reserve(LOG_MAX_RECORD_SIZE + 2 * Varint::MAX_SIZE);
+        const uint32_t ms = millis();
+        if (batch_len == 0) {
+            writeKeyframe(ms);
+        }
+        const uint32_t units = (ms - last.ms) / LOG_TIME_UNIT_MS;
+        batch[batch_len++] = LOG_TAG_EVENT | (last.state & LOG_TAG_STATE_MASK);
+        batch_len += Varint::put(batch + batch_len, units);
+        batch_len += Varint::put(batch + batch_len, code);
+        batch_len += Varint::put(batch + batch_len, arg);
+        last.ms += units * LOG_TIME_UNIT_MS;
+        n_records++;
+    }
+
+    // => Remove oldest segments above LOG_MAX_SEGMENTS, unless a download is running
+    void PositionLog::removeOldSegments() {
+        char file_path[32];
+        while (first_seq && last_seq - first_seq >= LOG_MAX_SEGMENTS && n_readers == 0) {
+            path(file_path, sizeof(file_path), first_seq, false);
+            LittleFS.remove(file_path);
+            path(file_path, sizeof(file_path), first_seq, true);
+            LittleFS.remove(file_path);
+            first_seq++;
+            n_segments_removed++;
+        }
+    }
+
+    // => Write the batch if it is full or old, or always if forced
+    void PositionLog::flush(const bool force) {
+        if (!is_ready || batch_len == 0) {
+            return;
+        }
+        if (!force && batch_len + LOG_MAX_RECORD_SIZE <= LOG_BATCH_SIZE &&
+            millis() - batch_start_ms < LOG_FLUSH_INTERVAL_MS) {
+            return;
+        }
+
+        xSemaphoreTake(lock, portMAX_DELAY);
+
+        // Start a new segment once the current one is full
+        if (!last_seq || segment_size + batch_len > LOG_SEGMENT_SIZE) {
+            last_seq++;
+            first_seq = first_seq ? first_seq : last_seq;
+            segment_size = 0;
+        }
+        removeOldSegments();
+
+        // Index entry first, a batch without entry would be skipped by range queries only
+        char file_path[32];
+        uint8_t entry[LOG_INDEX_ENTRY_SIZE];
+        const uint32_t offset = segment_size;
+        memcpy(entry, &batch_unix, 4);
+        memcpy(entry + 4, &offset, 4);
+        path(file_path, sizeof(file_path), last_seq, true);
+        appendToFS(file_path, entry, sizeof(entry));
+        path(file_path, sizeof(file_path), last_seq, false);
+        if (appendToFS(file_path, batch, batch_len)) {
+            segment_size += batch_len;
+            n_bytes_written += batch_len + sizeof(entry);
+        }
+        n_batches++;
+        xSemaphoreGive(lock);
+
+        // Next record starts a new batch with a keyframe
+        batch_len = 0;
+    }
+
+    // => Total size of all segments, in bytes
+    size_t PositionLog::totalSize() const {
+        size_t n = 0;
+        char file_path[32];
+        for (uint32_t seq = first_seq; seq && seq <= last_seq; ++seq) {
+            path(file_path, sizeof(file_path), seq, false);
+            File file = LittleFS.open(file_path, FILE_READ);
+            if (file) {
+                n += file.size();
+            }
+        }
+        return n;
+    }
+
+    // => Print size and write statistics to Serial
+    void PositionLog::printStats() const {
+        Serial.printf("[Log] Segments %u to %u, %u B | Since boot: %u records, %u batches, %u B written, "
+                      "%u segments removed\n\r",
+                      first_seq, last_seq, totalSize(), n_records, n_batches, n_bytes_written, n_segments_removed);
+    }
+
+
+    // ************************
+    // Define LogReader members
+    // ************************
+
+    LogReader::LogReader(PositionLog &log, const uint32_t from_unix, const uint32_t to_unix)
+        : log(log), from_unix(from_unix), to_unix(to_unix) {
+        log.n_readers++;
+    }
+
+    LogReader::~LogReader() {
+        if (file) {
+            file.close();
+        }
+        log.n_readers--;
+    }
+
+    // => Open the next segment and seek to the first batch in range, false at the end of the log
+    bool LogReader::nextSegment() {
+        if (file) {
+            file.close();
+        }
+        char file_path[32];
+        xSemaphoreTake(log.lock, portMAX_DELAY);
+        seq = max(seq + 1, log.first_seq);
+        const uint32_t last_seq = log.last_seq;
+        xSemaphoreGive(log.lock);
+
+        for (; seq && seq <= last_seq; ++seq) {
+            // A batch covers at most the flush interval after its keyframe
+            const uint32_t from = from_unix > LOG_FLUSH_INTERVAL_MS / 1000 ? from_unix - LOG_FLUSH_INTERVAL_MS / 1000 : 0;
+            bool found = false;
+            size_t start = 0;
+            end = SIZE_MAX;
+            PositionLog::path(file_path, sizeof(file_path), seq, true);
+            File index = LittleFS.open(file_path, FILE_READ);
+            uint8_t entry[LOG_INDEX_ENTRY_SIZE];
+            while (index && index.read(entry, sizeof(entry)) == sizeof(entry)) {
+                uint32_t unix, offset;
+                memcpy(&unix, entry, 4);
+                memcpy(&offset, entry + 4, 4);
+
+                // Batches before the clock was set only belong to complete downloads
+                const bool after_from = !from_unix || (unix && unix >= from);
+                const bool before_to = !to_unix || (unix && unix <= to_unix);
+                if (!found && after_from && before_to) {
+                    start = offset;
+                    found = true;
+                } else if (found && to_unix && unix > to_unix) {
+                    end = offset;
+                    break;
+                }
+            }
+            if (index) {
+                index.close();
+            }
+            if (!found) {
+                continue;
+            }
+
+            PositionLog::path(file_path, sizeof(file_path), seq, false);
+            file = LittleFS.open(file_path, FILE_READ);
+            if (file && file.seek(start)) {
+                end = min(end, file.size());
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // => Write up to max_len bytes to buffer, returns 0 at the end of the range
+    size_t LogReader::read(uint8_t *buffer, const size_t max_len) {
+        size_t n = 0;
+
+        // Stream header
+        const uint8_t header[LOG_STREAM_HEADER_SIZE] = {'R', 'L', LOG_STREAM_VERSION, LOG_TIME_UNIT_MS};
+        while (header_pos < LOG_STREAM_HEADER_SIZE && n < max_len) {
+            buffer[n++] = header[header_pos++];
+        }
+
+        // Segments as stored
+        while (n < max_len) {
+            if (!file || file.position() >= end) {
+                if (!nextSegment()) {
+                    break;
+                }
+                continue;
+            }
+            const size_t k = file.read(buffer + n, min(max_len - n, end - file.position()));
+            if (k == 0) {
+                file.close();
+                continue;
+            }
+            n += k;
+        }
+        return n;
+    }
+}
+
+Rotor::PositionLog position_log;
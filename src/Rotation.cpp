@@ -4,13 +4,58 @@
 #include <Rotation.h>
 #include <Adafruit_ADS1X15.h>
 #include <Timer.h>
+#ifdef SIMULATE_ROTOR
+#include <RotorSimulator.h>     // Exposes Global: rotor_sim
+#endif
 
 #define ADC_ADDRESS 0x48
 #define ADC_CHANNEL 0
 
+// ADC data rate and PGA gain, can be overridden with build flags
+#ifndef ADC_DATA_RATE
+#define ADC_DATA_RATE RATE_ADS1115_475SPS
+#endif
+#ifndef ADC_GAIN
+#define ADC_GAIN GAIN_ONE
+#endif
+
+#define ADC_READER_TASK_PRIORITY 5
+#define ADC_READER_TASK_CORE 1
+#define ADC_READER_STACK_SIZE 2048
+
 
 namespace Rotor {
 
+    // End of last conversion, set by ALERT/RDY interrupt
+    volatile unsigned long adc_ready_us = 0;
+    TaskHandle_t adc_reader_handle = nullptr;
+
+    // => Interrupt for ADS1115 ALERT/RDY, pulses low after each conversion
+    void IRAM_ATTR adcReadyAction() {
+        adc_ready_us = micros();
+        if (adc_reader_handle != nullptr) {
+            BaseType_t task_woken = pdFALSE;
+            vTaskNotifyGiveFromISR(adc_reader_handle, &task_woken);
+            if (task_woken) {
+                portYIELD_FROM_ISR();
+            }
+        }
+    }
+
+    // => Convert ADS1115 data rate config to samples per second
+    uint16_t adcRateToSPS(const uint16_t rate) {
+        switch (rate) {
+            case RATE_ADS1115_8SPS: return 8;
+            case RATE_ADS1115_16SPS: return 16;
+            case RATE_ADS1115_32SPS: return 32;
+            case RATE_ADS1115_64SPS: return 64;
+            case RATE_ADS1115_128SPS: return 128;
+            case RATE_ADS1115_250SPS: return 250;
+            case RATE_ADS1115_475SPS: return 475;
+            default: return 860;
+        }
+    }
+
     // *****************************
     // Define Rotation class members
     // *****************************
@@ -29,18 +74,129 @@ namespace Rotor {
         // 16bit = 32768 values
         // GAIN_ONE: +/- 4.096V
         // -> 0.125 mV per ADC value
-        adc.setGain(GAIN_ONE);
+        adc.setGain(ADC_GAIN);
+        adc.setDataRate(ADC_DATA_RATE);
+        #ifdef SIMULATE_ROTOR
+        Serial.println("[Rotor] Simulating rotor, ADS1115 and relays are not used.");
+        #else
         if (!adc.begin(ADC_ADDRESS)) {
             Serial.println("[Rotor] Failed to initialise ADS1115!");
             ads_failed = true;
         }
+        #endif
 
         // Load calibration factors
         loadCalibration();
 
+        // Start sampling
+        if (!ads_failed) {
+            startContinuousConversion();
+        }
+
         return !ads_failed;
     }
 
+    // Sampling
+    // ========
+
+    // => Start ADS1115 in continuous-conversion mode and launch reader task
+    void Rotation::startContinuousConversion() {
+        sampling.rate = adcRateToSPS(ADC_DATA_RATE);
+
+        #ifdef SIMULATE_ROTOR
+        // Simulated conversions are generated by the reader task
+        xTaskCreatePinnedToCore(readerTask, "adc_reader", ADC_READER_STACK_SIZE, this,
+                                ADC_READER_TASK_PRIORITY, &reader_task, ADC_READER_TASK_CORE);
+        #else
+        // ALERT/RDY is open-drain
+        pinMode(adc_alert_pin, INPUT_PULLUP);
+
+        // Start the reader task before the first conversion triggers the interrupt
+        xTaskCreatePinnedToCore(readerTask, "adc_reader", ADC_READER_STACK_SIZE, this,
+                                ADC_READER_TASK_PRIORITY, &reader_task, ADC_READER_TASK_CORE);
+        adc_reader_handle = reader_task;
+        attachInterrupt(adc_alert_pin, adcReadyAction, FALLING);
+
+        // Also configures ALERT/RDY as conversion-ready pin
+        adc.startADCReading(MUX_BY_CHANNEL[ADC_CHANNEL], true);
+        #endif
+
+        // Wait for first sample, so that last rotor values are valid after init
+        for (int i = 0; i < 50 && samples.empty(); ++i) {
+            delay(1);
+        }
+        update();
+
+        if (verbose) {
+            Serial.print("[Rotor] ADC sampling continuously at ");
+            Serial.print(sampling.rate);
+            Serial.println(" SPS.");
+        }
+    }
+
+    // => Reader task, reads a new conversion result whenever ALERT/RDY signals one.
+    // If no ALERT/RDY pulse arrives, the conversion register is polled instead.
+    void Rotation::readerTask(void *param) {
+        Rotation *rotation = (Rotation*) param;
+        const TickType_t timeout = pdMS_TO_TICKS(4000 / rotation->sampling.rate + 1);
+        bool is_polling = false;
+
+        #ifdef SIMULATE_ROTOR
+        // Simulated ADC, step rotor model at the ADC data rate
+        ADCSample sample;
+        const float volts_per_count = rotation->adc.computeVolts(1);
+        TickType_t last_wake = xTaskGetTickCount();
+        for (;;) {
+            vTaskDelayUntil(&last_wake, max((TickType_t) 1, pdMS_TO_TICKS(1000 / rotation->sampling.rate)));
+            sample.us = micros();
+            rotor_sim.step(sample.us);
+            sample.value = (int16_t) constrain(rotor_sim.readADCVolts() / volts_per_count, -32768.0f, 32767.0f);
+            rotation->pushSample(sample);
+        }
+        #endif
+
+        for (;;) {
+            if (ulTaskNotifyTake(pdTRUE, timeout)) {
+                rotation->readConversion(adc_ready_us);
+            } else {
+                if (!is_polling) {
+                    is_polling = true;
+                    Serial.println("[Rotor] No ADC ALERT/RDY signal, polling ADC instead.");
+                }
+                rotation->readConversion(micros());
+            }
+        }
+    }
+
+    // => Buffer a sample for the control task, counts samples lost to a full buffer
+    void Rotation::pushSample(const ADCSample &sample) {
+        sampling.n_samples++;
+        if (!samples.push(sample)) {
+            sampling.n_overruns++;
+        }
+    }
+
+    // => Read the last conversion result, finished at given time, into the sample buffer
+    void Rotation::readConversion(const unsigned long us) {
+        ADCSample sample;
+        sample.us = us;
+        sample.value = adc.getLastConversionResults();
+        pushSample(sample);
+    }
+
+    // => Compute volts and angle from a raw ADC sample
+    void Rotation::applySample(const ADCSample &sample) {
+        last_adc_value = sample.value;
+        last_us = sample.us;
+        // Sample time on the millis() clock, micros() wraps after 71 minutes
+        last_ms = millis() - (micros() - sample.us) / 1000;
+        last_adc_volts = adc.computeVolts(sample.value);
+
+        // Calculate angle using calibration
+        last_angle = calibration.d_grad * last_adc_volts * calibration.volt_div_factor
+                   + calibration.u_0 + calibration.offset;
+    }
+
     // Calibration
     // ===========
 
@@ -77,7 +233,7 @@ namespace Rotor {
         calibration.u_0 = calibration.a1 - ((calibration.a2 - calibration.a1) / (calibration.u2 - calibration.u1) * calibration.u1);
     }
 
-    // => Set calibration factors and apply and save
+    // => Set calibration factors and apply, saved by the loop
     void Rotation::calibrate(const float u1, const float u2,
                              const float a1, const float a2) {
         calibration.u1 = u1;
@@ -85,28 +241,45 @@ namespace Rotor {
         calibration.a1 = a1;
         calibration.a2 = a2;
         applyCalibration();
-        saveCalibration();
+        calibration_changed.store(true, std::memory_order_release);
+    }
+
+    // => Save calibration to PREFS if it changed.
+    // A change during saving sets the flag again, so the last calibration is always saved.
+    void Rotation::saveChangedCalibration() {
+        if (calibration_changed.exchange(false, std::memory_order_acquire)) {
+            saveCalibration();
+            if (verbose) { Serial.println("[Rotor] Calibration saved."); }
+        }
     }
 
 
     // Values
     // ======
 
-    // => Set constant angle-offset and save calibration
+    // => Set constant angle-offset, saved by the loop
     void Rotation::setAngleOffset(const float offset) {
         calibration.offset = offset;
-        saveCalibration();
+        calibration_changed.store(true, std::memory_order_release);
     }
 
     // => Start rotation in given direction
     void Rotation::startRotation(const uint8_t dir) const {
         digitalWrite(rot_pins[dir], LOW);
+        relay_us = micros();
+        #ifdef SIMULATE_ROTOR
+        rotor_sim.relay = dir ? 1 : -1;
+        #endif
     }
 
     // => Stop rotor
     void Rotation::stopRotor() const {
         digitalWrite(rot_pins[0], HIGH);
         digitalWrite(rot_pins[1], HIGH);
+        relay_us = micros();
+        #ifdef SIMULATE_ROTOR
+        rotor_sim.relay = 0;
+        #endif
     }
 
     // => Set DAC voltage on speed pin
@@ -116,37 +289,38 @@ namespace Rotor {
         } else {
             dacWrite(speed_pin, (uint8_t) std::round(speed * 2.55f));
         }
+        #ifdef SIMULATE_ROTOR
+        rotor_sim.dac_speed = speed;
+        #endif
     }
 
-    // => Get current raw ADC value
+    // => Get current raw ADC value, from last update()
     uint16_t Rotation::getADCValue() {
-        update();
         return last_adc_value;
     }
 
-    // => Get current ADC voltage
+    // => Get current ADC voltage, from last update()
     float Rotation::getADCVolts() {
-        update();
         return last_adc_volts;
     }
 
-    // => Get rotor's current azimuth angle, a new value is pulled from ADC
+    // => Get rotor's current azimuth angle, from last update()
     float Rotation::getAngle() {
-        update();
         return last_angle;
     }
 
-    // => Read ADC and update last rotor position values
-    void Rotation::update() {
-        if (!ads_failed) {
-            // Read ADC and compute volts
-            last_adc_value = adc.readADC_SingleEnded(ADC_CHANNEL);
-            last_ms = millis();
-            last_adc_volts = adc.computeVolts(last_adc_value);
-
-            // Calculate angle using calibration
-            last_angle = calibration.d_grad * last_adc_volts * calibration.volt_div_factor
-                       + calibration.u_0 + calibration.offset;
+    // => Consume the oldest buffered ADC sample and update last rotor position values
+    bool Rotation::nextSample() {
+        ADCSample sample;
+        if (ads_failed || !samples.pop(sample)) {
+            return false;
         }
+        applySample(sample);
+        return true;
+    }
+
+    // => Consume all buffered ADC samples, last rotor position values are from the newest
+    void Rotation::update() {
+        while (nextSample()) {}
     }
 }
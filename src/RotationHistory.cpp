@@ -0,0 +1,250 @@
+#include <Arduino.h>
+#include <math.h>
+
+#include <RotationHistory.h>
+#include <Varint.h>
+#include <RotorController.h>
+
+// Samples are recorded at most this often, unless the state changes
+#define HISTORY_MIN_INTERVAL_MS 200
+// A stationary rotor is recorded this often
+#define HISTORY_IDLE_INTERVAL_MS 10000
+// Smallest angle change recorded before the idle interval, in 1/100 °
+#define HISTORY_MIN_ANGLE_CHANGE 5
+// State byte, two varints and the speed byte
+#define HISTORY_MAX_RECORD_SIZE (2 + 2 * Varint::MAX_SIZE)
+// Binary stream header: "RH", version, time unit, device millis
+#define HISTORY_STREAM_VERSION 1
+
+
+namespace Rotor {
+
+    // ******************************
+    // Define RotationHistory members
+    // ******************************
+
+    // => Create lock, to be called once before recording
+    void RotationHistory::init() {
+        lock = xSemaphoreCreateMutex();
+    }
+
+    // => Record a sample if the rotor moved, changed state or was idle for long
+    void RotationHistory::record(const Snapshot &state) {
+        HistorySample sample;
+        sample.ms = state.ms;
+        sample.angle = lround(state.angle * 100.0f);
+        sample.speed = state.current_speed;
+        sample.state = (state.is_rotating ? HISTORY_ROTATING : 0)
+                     | (state.direction ? HISTORY_CW : 0)
+                     | (state.is_auto_rotating ? HISTORY_AUTO : 0);
+
+        if (has_last) {
+            const uint32_t elapsed = sample.ms - last.ms;
+            const bool changed = sample.state != last.state || sample.speed != last.speed;
+            const bool moved = abs(sample.angle - last.angle) >= HISTORY_MIN_ANGLE_CHANGE;
+            if (elapsed < HISTORY_TIME_UNIT_MS) {
+                return;
+            }
+            if (!changed && (elapsed < HISTORY_MIN_INTERVAL_MS || (!moved && elapsed < HISTORY_IDLE_INTERVAL_MS))) {
+                return;
+            }
+        }
+        append(sample);
+    }
+
+    // => Start a new block with an absolute sample, overwrites the oldest block
+    void RotationHistory::startBlock(const HistorySample &sample) {
+        if (has_last) {
+            head = (head + 1) % HISTORY_BLOCKS;
+        }
+        HistoryBlock &block = blocks[head];
+        block.seq = next_seq++;
+        block.header.len = 0;
+        block.header.ms = sample.ms;
+        block.header.angle = sample.angle;
+        block.header.speed = sample.speed;
+        block.header.state = sample.state;
+        last = sample;
+        has_last = true;
+        n_blocks++;
+    }
+
+    // => Append a sample, delta encoded
+    void RotationHistory::append(const HistorySample &sample) {
+        xSemaphoreTake(lock, portMAX_DELAY);
+        if (!has_last || blocks[head].header.len + HISTORY_MAX_RECORD_SIZE > HISTORY_BLOCK_SIZE) {
+            startBlock(sample);
+        } else {
+            HistoryBlock &block = blocks[head];
+            uint8_t *out = block.data + block.header.len;
+            const uint32_t units = (sample.ms - last.ms) / HISTORY_TIME_UNIT_MS;
+            const bool speed_changed = sample.speed != last.speed;
+
+            size_t n = 0;
+            out[n++] = (sample.state & HISTORY_STATE_MASK) | (speed_changed ? HISTORY_SPEED_CHANGED : 0);
+            n += Varint::put(out + n, units);
+            n += Varint::put(out + n, Varint::zigzag(sample.angle - last.angle));
+            if (speed_changed) {
+                out[n++] = sample.speed;
+            }
+            block.header.len += n;
+
+            // Base of the next delta, with the time as the decoder sees it
+            last.ms += units * HISTORY_TIME_UNIT_MS;
+            last.angle = sample.angle;
+            last.speed = sample.speed;
+            last.state = sample.state;
+        }
+        blocks[head].last_ms = last.ms;
+        n_samples++;
+        xSemaphoreGive(lock);
+    }
+
+    // => Copy the oldest block with a sequence number above seq that ends at or after since_ms
+    bool RotationHistory::copyBlock(const uint32_t seq, const uint32_t since_ms, HistoryBlock &block) const {
+        xSemaphoreTake(lock, portMAX_DELAY);
+        const HistoryBlock *found = nullptr;
+        for (const HistoryBlock &candidate : blocks) {
+            if (candidate.seq > seq && (int32_t) (candidate.last_ms - since_ms) >= 0 &&
+                (found == nullptr || candidate.seq < found->seq)) {
+                found = &candidate;
+            }
+        }
+        if (found != nullptr) {
+            block.seq = found->seq;
+            block.last_ms = found->last_ms;
+            block.header = found->header;
+            memcpy(block.data, found->data, found->header.len);
+        }
+        xSemaphoreGive(lock);
+        return found != nullptr;
+    }
+
+    // => Decode the next sample of a block at pos, starting from the block header
+    bool RotationHistory::decode(const HistoryBlock &block, size_t &pos, HistorySample &sample) {
+        const size_t end = block.header.len;
+        if (pos >= end) {
+            return false;
+        }
+        const uint8_t state = block.data[pos++];
+        uint32_t units, angle_delta;
+        if (!Varint::get(block.data, pos, end, units) || !Varint::get(block.data, pos, end, angle_delta)) {
+            pos = end;
+            return false;
+        }
+        sample.ms += units * HISTORY_TIME_UNIT_MS;
+        sample.angle += Varint::unzigzag(angle_delta);
+        sample.state = state & HISTORY_STATE_MASK;
+        if (state & HISTORY_SPEED_CHANGED) {
+            if (pos >= end) {
+                return false;
+            }
+            sample.speed = block.data[pos++];
+        }
+        return true;
+    }
+
+    // => Bytes in use by encoded samples
+    size_t RotationHistory::usedBytes() const {
+        size_t n = 0;
+        for (const HistoryBlock &block : blocks) {
+            if (block.seq) {
+                n += sizeof(HistoryBlockHeader) + block.header.len;
+            }
+        }
+        return n;
+    }
+
+
+    // ****************************
+    // Define HistoryReader members
+    // ****************************
+
+    HistoryReader::HistoryReader(const RotationHistory &history, const uint32_t since_ms, const bool csv)
+        : history(history), since_ms(since_ms), csv(csv) {
+        if (csv) {
+            line_len = snprintf(line, sizeof(line), "ms,angle,speed,rotating,cw,auto\n");
+        } else {
+            const uint32_t now_ms = millis();
+            line[0] = 'R';
+            line[1] = 'H';
+            line[2] = HISTORY_STREAM_VERSION;
+            line[3] = HISTORY_TIME_UNIT_MS;
+            memcpy(line + 4, &now_ms, sizeof(now_ms));
+            line_len = 8;
+        }
+    }
+
+    // => Copy the next block, false at the end of the history
+    bool HistoryReader::nextBlock() {
+        if (!history.copyBlock(has_block ? block.seq : 0, since_ms, block)) {
+            return false;
+        }
+        has_block = true;
+        pos = 0;
+        return true;
+    }
+
+    // => Fill the pending line, false at the end of the history
+    bool HistoryReader::nextLine() {
+        for (;;) {
+            // First sample of a block is its header
+            if (!has_block || !RotationHistory::decode(block, pos, sample)) {
+                if (!nextBlock()) {
+                    return false;
+                }
+                sample.ms = block.header.ms;
+                sample.angle = block.header.angle;
+                sample.speed = block.header.speed;
+                sample.state = block.header.state;
+            }
+            if ((int32_t) (sample.ms - since_ms) < 0) {
+                continue;
+            }
+            line_len = snprintf(line, sizeof(line), "%u,%.2f,%u,%u,%u,%u\n",
+                                sample.ms, sample.angle / 100.0f, sample.speed,
+                                (sample.state & HISTORY_ROTATING) != 0,
+                                (sample.state & HISTORY_CW) != 0,
+                                (sample.state & HISTORY_AUTO) != 0);
+            line_pos = 0;
+            return true;
+        }
+    }
+
+    // => Write up to max_len bytes to buffer, returns 0 at the end of the history
+    size_t HistoryReader::read(uint8_t *buffer, const size_t max_len) {
+        size_t n = 0;
+        while (n < max_len) {
+            // Pending stream header or CSV line
+            if (line_pos < line_len) {
+                const size_t k = min(line_len - line_pos, max_len - n);
+                memcpy(buffer + n, line + line_pos, k);
+                line_pos += k;
+                n += k;
+                continue;
+            }
+            if (csv) {
+                if (!nextLine()) {
+                    break;
+                }
+                continue;
+            }
+
+            // Binary blocks are sent as stored, header followed by delta records
+            const size_t block_len = sizeof(HistoryBlockHeader) + block.header.len;
+            if (!has_block || pos >= block_len) {
+                if (!nextBlock()) {
+                    break;
+                }
+                continue;
+            }
+            const size_t k = min(block_len - pos, max_len - n);
+            memcpy(buffer + n, (const uint8_t*) &block.header + pos, k);
+            pos += k;
+            n += k;
+        }
+        return n;
+    }
+}
+
+Rotor::RotationHistory rotation_history;
@@ -0,0 +1,233 @@
+#include <Arduino.h>
+#include <AsyncTCP.h>
+#include <math.h>
+
+#include <globals.h>
+#include <RotorController.h>    // Exposes Global: rotor_ctrl
+#include <Rotctld.h>
+
+#define ROTCTLD_RESPONSE_SIZE 192
+#define ROTCTLD_MIN_AZ 0.0f
+#define ROTCTLD_MAX_AZ 360.0f
+
+// Hamlib error codes
+#define RIG_OK 0
+#define RIG_EINVAL -1
+#define RIG_ENIMPL -4
+#define RIG_ERJCTED -9
+
+// Hamlib move directions
+#define ROT_MOVE_UP 2
+#define ROT_MOVE_DOWN 4
+#define ROT_MOVE_LEFT 8
+#define ROT_MOVE_RIGHT 16
+
+
+namespace Rotctld {
+  uint8_t clients_connected = 0;
+
+  AsyncServer* server = nullptr;
+
+  // Connection with its partly received line
+  struct Connection {
+    AsyncClient* client = nullptr;
+    LineBuffer buffer;
+  };
+  Connection connections[ROTCTLD_MAX_CLIENTS];
+
+  // Counters since boot
+  struct {
+    uint32_t n_connections = 0;
+    uint32_t n_rejected = 0;        // Connections refused, all slots in use
+    uint32_t n_commands = 0;
+    uint32_t n_errors = 0;          // Commands answered with an error
+  } stats;
+
+  // => Write a report line with a Hamlib error code
+  void report(char* response, const size_t size, const int code) {
+    snprintf(response, size, "RPRT %d\n", code);
+    if (code != RIG_OK) {
+      stats.n_errors++;
+    }
+  }
+
+  // => Hand a command on and report the result
+  void post(Rotor::Command cmd, Rotor::PostCommand post_cmd, char* response, const size_t size) {
+    cmd.rx_us = micros();
+    report(response, size, post_cmd(cmd) ? RIG_OK : RIG_ERJCTED);
+  }
+
+  // => Azimuth of the last published rotor state, in 0° to 360°
+  float getAzimuth() {
+    float azimuth = fmod(rotor_ctrl.getSnapshot().angle, 360.0f);
+    return azimuth < 0.0f ? azimuth + 360.0f : azimuth;
+  }
+
+  // => Handle one command line, writes the response. Returns false if the client asked to quit.
+  bool handleLine(char* line, Rotor::PostCommand post_cmd, char* response, const size_t size) {
+    response[0] = '\0';
+    char* save;
+    const char* cmd = strtok_r(line, " \t", &save);
+    if (cmd == nullptr) {
+      return true;
+    }
+    const char* arg1 = strtok_r(nullptr, " \t", &save);
+    const char* arg2 = strtok_r(nullptr, " \t", &save);
+    stats.n_commands++;
+
+    // Get position, answered from the last published state
+    if (!strcmp(cmd, "p") || !strcmp(cmd, "\\get_pos")) {
+      snprintf(response, size, "%.6f\n%.6f\n", getAzimuth(), 0.0f);
+
+    // Set position, elevation is ignored
+    } else if (!strcmp(cmd, "P") || !strcmp(cmd, "\\set_pos")) {
+      char* end;
+      float azimuth = arg1 != nullptr ? strtof(arg1, &end) : NAN;
+      if (arg1 == nullptr || end == arg1 || arg2 == nullptr || azimuth < -180.0f || azimuth > ROTCTLD_MAX_AZ) {
+        report(response, size, RIG_EINVAL);
+        return true;
+      }
+      azimuth = azimuth < 0.0f ? azimuth + 360.0f : azimuth;
+      post(Rotor::Command::rotateTo(azimuth, rotor_ctrl.settings.use_overlap,
+                                    rotor_ctrl.settings.use_smooth_speed), post_cmd, response, size);
+
+    // Stop
+    } else if (!strcmp(cmd, "S") || !strcmp(cmd, "\\stop")) {
+      post(Rotor::Command::stop(), post_cmd, response, size);
+
+    // Move in a direction, with optional speed in %
+    } else if (!strcmp(cmd, "M") || !strcmp(cmd, "\\move")) {
+      const int direction = arg1 != nullptr ? atoi(arg1) : 0;
+      const int speed = arg2 != nullptr ? atoi(arg2) : -1;
+      if (direction == ROT_MOVE_UP || direction == ROT_MOVE_DOWN) {
+        report(response, size, RIG_ENIMPL);
+        return true;
+      }
+      if (direction != ROT_MOVE_LEFT && direction != ROT_MOVE_RIGHT) {
+        report(response, size, RIG_EINVAL);
+        return true;
+      }
+      if (speed > 0 && speed <= 100 && !post_cmd(Rotor::Command::setSpeed(speed))) {
+        report(response, size, RIG_ERJCTED);
+        return true;
+      }
+      post(Rotor::Command::rotate(direction == ROT_MOVE_RIGHT ? 1 : 0), post_cmd, response, size);
+
+    // Info
+    } else if (!strcmp(cmd, "_") || !strcmp(cmd, "\\get_info")) {
+      snprintf(response, size, "RotorControl\n");
+
+    // Capabilities, read by rotctl -m 2 when connecting
+    } else if (!strcmp(cmd, "\\dump_state")) {
+      snprintf(response, size,
+               "1\n2\nmin_az=%.6f\nmax_az=%.6f\nmin_el=0.000000\nmax_el=0.000000\nsouth_zero=0\nrot_type=Az\ndone\n",
+               ROTCTLD_MIN_AZ, ROTCTLD_MAX_AZ);
+
+    // Quit
+    } else if (!strcmp(cmd, "q") || !strcmp(cmd, "Q") || !strcmp(cmd, "\\quit")) {
+      return false;
+
+    } else {
+      report(response, size, RIG_ENIMPL);
+    }
+    return true;
+  }
+
+  // => Collect received bytes and handle complete lines
+  bool feed(LineBuffer &buffer, const char* data, const size_t len, Rotor::PostCommand post_cmd,
+            Respond respond, void* ctx) {
+    char response[ROTCTLD_RESPONSE_SIZE];
+    for (size_t i = 0; i < len; ++i) {
+      const char c = data[i];
+      if (c == '\n' || c == '\r') {
+        bool keep_open = true;
+        response[0] = '\0';
+        if (buffer.overflow) {
+          report(response, sizeof(response), RIG_EINVAL);
+        } else if (buffer.len) {
+          buffer.line[buffer.len] = '\0';
+          keep_open = handleLine(buffer.line, post_cmd, response, sizeof(response));
+        }
+        buffer.len = 0;
+        buffer.overflow = false;
+        if (response[0]) {
+          respond(ctx, response);
+        }
+        if (!keep_open) {
+          return false;
+        }
+      } else if (buffer.len < ROTCTLD_LINE_SIZE - 1) {
+        buffer.line[buffer.len++] = c;
+      } else {
+        buffer.overflow = true;
+      }
+    }
+    return true;
+  }
+
+  // => Accept a new connection if a slot is free
+  void onClient(void* arg, AsyncClient* client) {
+    Connection* conn = nullptr;
+    for (Connection &candidate : connections) {
+      if (candidate.client == nullptr) {
+        conn = &candidate;
+        break;
+      }
+    }
+    if (conn == nullptr) {
+      stats.n_rejected++;
+      client->onDisconnect([](void* arg, AsyncClient* client) { delete client; }, nullptr);
+      client->close(true);
+      return;
+    }
+    conn->client = client;
+    conn->buffer = LineBuffer();
+    ++clients_connected;
+    stats.n_connections++;
+
+    // Small responses go out without waiting for more data
+    client->setNoDelay(true);
+    client->onData([](void* arg, AsyncClient* client, void* data, size_t len) {
+      Connection* conn = (Connection*) arg;
+      const bool keep_open = feed(conn->buffer, (const char*) data, len, Rotor::postToControl,
+                                  [](void* ctx, const char* response) {
+        ((AsyncClient*) ctx)->write(response, strlen(response));
+      }, client);
+      if (!keep_open) {
+        client->close();
+      }
+    }, conn);
+    client->onDisconnect([](void* arg, AsyncClient* client) {
+      Connection* conn = (Connection*) arg;
+      conn->client = nullptr;
+      --clients_connected;
+      if (verbose) { Serial.println("[Rotctld] Client disconnected."); }
+      delete client;
+    }, conn);
+
+    if (verbose) {
+      Serial.print("[Rotctld] Client connected with IP: ");
+      Serial.println(client->remoteIP());
+    }
+  }
+
+  // => Start listening on ROTCTLD_PORT
+  void initServer() {
+    if (server != nullptr) {
+      return;
+    }
+    server = new AsyncServer(ROTCTLD_PORT);
+    server->onClient(onClient, nullptr);
+    server->begin();
+    if (verbose) {
+      Serial.print("[Rotctld] Listening on port ");
+      Serial.println(ROTCTLD_PORT);
+    }
+  }
+
+  // => Print connection and command counters to Serial
+  void printStats() {
+    Serial.printf("[Rotctld] Clients: %u | Connections: %u (rejected %u) | Commands: %u (errors %u)\n\r",
+                  clients_connected, stats.n_connections, stats.n_rejected, stats.n_commands, stats.n_errors);
+  }
+}
@@ -5,7 +5,9 @@
 #include <Rotation.h>
 #include <RotorMessenger.h>
 #include <RotorController.h>
-#include <RotorSocket.h>        // Exposes Global: websocket
+
+// Angular speeds below are treated as stationary, in °/s
+#define ANGULAR_SPEED_DEADBAND 0.3f
 
 
 namespace Rotor {
@@ -18,15 +20,21 @@ namespace Rotor {
     // => Initialisation, called from setup()
     bool RotorController::init() {
         bool rotorInitSuccess = rotor.init();
-        rotor.update();
 
-        // Init variables for calculating angular speed
-        previous.last_angle = rotor.last_angle;
-        previous.last_ms = rotor.last_ms;
+        // Start estimator from first sample
+        angle = rotor.last_angle;
+        estimator.update(rotor.last_angle, rotor.last_us);
+
         auto_rot.timer.changeInterval(auto_rot.timeout);
         auto_rot.counterTimer.changeInterval(auto_rot.counter_interval);
 
+        // Load learned coast distances
+        coast_model.load();
+        if (verbose) { coast_model.printToSerial(); }
+
         messenger.rotor_ptr = this;     // Messenger gets pointer to this instance
+        messenger.init();
+        publishSnapshot();
         return rotorInitSuccess;
     }
 
@@ -34,11 +42,68 @@ namespace Rotor {
     // Commands
     // --------
 
+    // => Post a command to the control task, safe to be called from any task
+    bool RotorController::post(const Command &cmd) {
+        if (!commands.push(cmd)) {
+            Serial.println("[Rotor] Command queue full, command dropped.");
+            return false;
+        }
+        return true;
+    }
+
+    // => Apply all posted commands, to be called from the control task at the start of each tick
+    void RotorController::applyCommands() {
+        Command cmd;
+        while (commands.pop(cmd)) {
+            const bool was_rotating = is_rotating;
+            applyCommand(cmd);
+            const unsigned long applied_us = micros();
+
+            // Latency of commands from clients, to the relay change if they switched the relays
+            if (cmd.rx_us) {
+                command_latency.add((is_rotating != was_rotating ? rotor.relay_us : applied_us) - cmd.rx_us);
+            }
+
+            // Acknowledge to the client once applied
+            if (cmd.client_id) {
+                CommandAck ack;
+                ack.client_id = cmd.client_id;
+                ack.seq = cmd.seq;
+                ack.rx_us = cmd.rx_us;
+                ack.applied_us = applied_us;
+                if (!acks.push(ack)) {
+                    Serial.println("[Rotor] Ack queue full, ack dropped.");
+                }
+            }
+        }
+    }
+
+    // => Apply a single command
+    void RotorController::applyCommand(const Command &cmd) {
+        switch (cmd.type) {
+            case CommandType::STOP:
+                stop(); break;
+            case CommandType::ROTATE:
+                startRotation(cmd.direction); break;
+            case CommandType::ROTATE_TO:
+                rotateTo(cmd.values[0], cmd.use_overlap, cmd.use_smooth_speed); break;
+            case CommandType::SET_SPEED:
+                setMaxSpeed(cmd.speed); break;
+            case CommandType::SET_CALIBRATION:
+                setCalibration(cmd.values[0], cmd.values[1], cmd.values[2], cmd.values[3]); break;
+            case CommandType::SET_OFFSET:
+                setAngleOffset(cmd.values[0]); break;
+            default:
+                break;
+        }
+    }
+
     // => Start rotating in given direction, distribute new state to clients
     void RotorController::startRotation(const uint8_t dir) {
         if (!is_rotating) {
             direction = dir;
             is_rotating = true;
+            settling.active = false;
             rotor.startRotation(direction);
             messenger.sendLastRotation(false);
             if (verbose) {
@@ -102,6 +167,7 @@ namespace Rotor {
     void RotorController::setCalibration(const float u1, const float u2,
                                          const float a1, const float a2) {
         rotor.calibrate(u1, u2, a1, a2);
+        estimator.invalidate();
         messenger.sendCalibration();
         if (verbose) {
             Serial.print("[Rotor] Set calibration: ");
@@ -115,6 +181,7 @@ namespace Rotor {
     // => Set angle-offset, distribute new state to clients
     void RotorController::setAngleOffset(const int offset) {
         rotor.setAngleOffset(offset);
+        estimator.invalidate();
         messenger.sendCalibration();
         if (verbose) {
             Serial.print("[Rotor] Set angle offset: ");
@@ -135,7 +202,7 @@ namespace Rotor {
 
         // Determine shortest direction to target
         int overlap_border = auto_rot.max_angle - 360;
-        float current_angle = rotor.getAngle();
+        float current_angle = angle;
         float distance = target_angle - current_angle;
         
         // Target angle is in overlap region (from 0° to overlapBorder)
@@ -201,6 +268,7 @@ namespace Rotor {
 
         // Start auto rotation
         auto_rotation_target = current_angle + distance;
+        settling.start_ms = millis();
         auto_rot.timer.reset();
         auto_rot.timer.start();
         auto_rot.timeout_counter = 0;
@@ -213,15 +281,36 @@ namespace Rotor {
     // If angular-speed is zero 3s into auto-rotation, start 3s timeout.
     // *****************************************************************
     void RotorController::watchAutoRotation() {
-        // Target reached
-        if ((direction == 0 && rotor.last_angle <= auto_rotation_target + auto_rot.tolerance) ||
-            (direction == 1 && rotor.last_angle >= auto_rotation_target - auto_rot.tolerance)) {
+        // Remaining distance to target in rotation direction
+        float remaining = (direction == 1) ? auto_rotation_target - angle
+                                           : angle - auto_rotation_target;
+
+        // Predicted coast distance, if relays were cut now
+        uint8_t dac_speed = smooth_speed_active ? current_speed : max_speed;
+        float predicted_coast = 0.0f;
+        if (settings.use_coast_prediction) {
+            predicted_coast = coast_model.predict(dac_speed, angular_speed);
+        }
+
+        // Target will be reached while coasting. Without coast prediction, stop within the tolerance.
+        const float stop_distance = settings.use_coast_prediction ? predicted_coast : auto_rot.tolerance;
+        if (remaining <= stop_distance) {
+            // Remember state when cutting relays, to learn coast distance when settled
+            settling.cut_ms = millis();
+            settling.cut_angle = angle;
+            settling.cut_angular_speed = angular_speed;
+            settling.cut_speed = dac_speed;
+            settling.predicted_coast = predicted_coast;
+
             stop();
+            settling.active = true;
             if (verbose) {
                 Serial.print("[Rotor] Auto-rotation target (");
                 Serial.print(auto_rotation_target);
                 Serial.print("°) reached with: ");
-                Serial.print(rotor.getAngle());
+                Serial.print(angle);
+                Serial.print("° | Predicted coast: ");
+                Serial.print(predicted_coast);
                 Serial.println("°.");
             }
 
@@ -232,6 +321,7 @@ namespace Rotor {
             // Stop rotation if rotor was checked to be stationary 4-times in a row
             if (auto_rot.timeout_counter >= 4) {
                 stop();
+                auto_rot_stats.n_aborted++;
                 if (verbose) {
                     Serial.println("[Rotor] Auto-rotation aborted. Rotor stopped before reaching target.");
                 }
@@ -243,6 +333,76 @@ namespace Rotor {
         }
     }
 
+    // => Finish auto-rotation once the rotor came to rest after the relays were cut.
+    // Learns the coast distance and updates auto-rotation statistics.
+    // ***********************************************************************
+    void RotorController::watchSettling() {
+        unsigned long now = millis();
+        bool timed_out = now - settling.cut_ms >= settling.timeout;
+
+        // Wait for the rotor to come to rest
+        if (angular_speed && !timed_out) {
+            return;
+        }
+        settling.active = false;
+
+        // Coast distance in direction of rotation
+        float coast = (direction == 1) ? angle - settling.cut_angle
+                                       : settling.cut_angle - angle;
+        if (!timed_out) {
+            coast_model.learn(settling.cut_speed, settling.cut_angular_speed, coast);
+        }
+
+        // Statistics
+        float error = angle - auto_rotation_target;
+        unsigned long time_to_target = now - settling.start_ms;
+        auto_rot_stats.n_completed++;
+        auto_rot_stats.last_error = error;
+        if (abs(error) > auto_rot.tolerance) {
+            auto_rot_stats.n_outside_tolerance++;
+        }
+        auto_rot_stats.max_abs_error = max(auto_rot_stats.max_abs_error, abs(error));
+        auto_rot_stats.sum_abs_error += abs(error);
+        auto_rot_stats.last_time_ms = time_to_target;
+        auto_rot_stats.sum_time_ms += time_to_target;
+
+        if (verbose) {
+            Serial.print("[Rotor] Auto-rotation settled at ");
+            Serial.print(angle);
+            Serial.print("° | Error: ");
+            Serial.print(error);
+            Serial.print("° | Coast: ");
+            Serial.print(coast);
+            Serial.print("° (predicted: ");
+            Serial.print(settling.predicted_coast);
+            Serial.print("°) | Time: ");
+            Serial.print(time_to_target);
+            Serial.println(" ms.");
+            printAutoRotationStats();
+        }
+    }
+
+    // => Print auto-rotation statistics to Serial
+    void RotorController::printAutoRotationStats() const {
+        Serial.print("[Rotor] Auto-rotations: ");
+        Serial.print(auto_rot_stats.n_completed);
+        Serial.print(" completed, ");
+        Serial.print(auto_rot_stats.n_aborted);
+        Serial.print(" aborted");
+        if (auto_rot_stats.n_completed) {
+            Serial.print(" | Outside tolerance: ");
+            Serial.print(auto_rot_stats.n_outside_tolerance);
+            Serial.print(" | Mean abs. error: ");
+            Serial.print(auto_rot_stats.sum_abs_error / auto_rot_stats.n_completed, 2);
+            Serial.print("° | Max abs. error: ");
+            Serial.print(auto_rot_stats.max_abs_error, 2);
+            Serial.print("° | Mean time to target: ");
+            Serial.print(auto_rot_stats.sum_time_ms / auto_rot_stats.n_completed);
+            Serial.print(" ms");
+        }
+        Serial.println(".");
+    }
+
     // => Set smooth speed to DAC.
     // To be called continously from main loop if speed ramp is active
     // ***************************************************************
@@ -257,9 +417,9 @@ namespace Rotor {
                 Serial.print("[Rotor] Speed (");
                 Serial.printf("%3d", new_speed);
                 Serial.print("%) | Distances: ");
-                Serial.printf("%5.1f", abs(rotor.last_angle - speed_ramp.start_angle));
+                Serial.printf("%5.1f", abs(angle - speed_ramp.start_angle));
                 Serial.print(" <-+-> ");
-                Serial.printf("%5.1f\n\r", abs(rotor.last_angle - auto_rotation_target));
+                Serial.printf("%5.1f\n\r", abs(angle - auto_rotation_target));
             }
         }    
     }
@@ -271,8 +431,8 @@ namespace Rotor {
         if (max_speed == 0) { return max_speed; }
 
         // Distances
-        float distance_to_start = abs(rotor.last_angle - speed_ramp.start_angle);
-        float distance_to_target = abs(rotor.last_angle - auto_rotation_target);
+        float distance_to_start = abs(angle - speed_ramp.start_angle);
+        float distance_to_target = abs(angle - auto_rotation_target);
 
         // Set speed multiplication factor
         float speed_ramp_factor;
@@ -300,29 +460,80 @@ namespace Rotor {
         return (0.5f * (1.0f + std::tanh(((2 * x - 1.0f) * gradient) / (std::sqrt((1.0f - x) * x)))));
     }
 
-    // => Update rotor values from ADC and calculate angular speed
-    // ***********************************************************
-    void RotorController::update(bool with_angular_speed) {
-        rotor.update();
-
-        // Calculate angular speed
-        if (with_angular_speed && rotor.getADCStatus()) {
-            float new_angular_speed = (rotor.last_angle - previous.last_angle) 
-                                    / (rotor.last_ms - previous.last_ms) * 1000.0f;
-            
-            // Exponential moving average
-            new_angular_speed = (0.5f * new_angular_speed) + (0.5f * angular_speed);
+    // => Feed all new ADC samples to the estimator and update filtered angle and angular speed
+    // ****************************************************************************************
+    void RotorController::update() {
+        while (rotor.nextSample()) {
+            estimator.update(rotor.last_angle, rotor.last_us);
+        }
 
-            if (abs(new_angular_speed) <= 0.1f) {
+        if (rotor.getADCStatus()) {
+            angle = estimator.angle;
+            if (abs(estimator.angular_speed) <= ANGULAR_SPEED_DEADBAND) {
                 angular_speed = 0.0f;
             } else {
-                angular_speed = new_angular_speed;
+                angular_speed = estimator.angular_speed;
             }
+        }
+    }
+
+    // => A single control cycle: apply commands, update rotor, watch auto-rotation and speed ramp
+    // *********************************************************************************************
+    void RotorController::tick() {
+        // Apply commands posted by network handlers and loop()
+        applyCommands();
 
-            // Set previous values for next calculation
-            previous.last_angle = rotor.last_angle;
-            previous.last_ms = rotor.last_ms;
+        update();
+
+        // Watch active auto rotation
+        if (is_auto_rotating) {
+            watchAutoRotation();
+        }
+
+        // Watch rotor coming to rest after auto rotation
+        if (settling.active) {
+            watchSettling();
         }
+
+        // Watch active speed ramp
+        if (smooth_speed_active) {
+            watchSmoothSpeedRamp();
+        }
+
+        // Distribute rotor state to other tasks
+        publishSnapshot();
+    }
+
+    // => Save calibration and learned coast distances changed by the control task to PREFS
+    // ************************************************************************************
+    void RotorController::savePending() {
+        rotor.saveChangedCalibration();
+        coast_model.saveChanged();
+    }
+
+    // => Create a snapshot from the current rotor state
+    // *************************************************
+    Snapshot RotorController::makeSnapshot() const {
+        Snapshot state;
+        state.ms = rotor.last_ms;
+        state.adc_volts = rotor.last_adc_volts;
+        state.angle = angle;
+        state.angular_speed = angular_speed;
+        state.confidence = estimator.confidence;
+        state.target = auto_rotation_target;
+        state.is_rotating = is_rotating;
+        state.is_auto_rotating = is_auto_rotating;
+        state.smooth_speed_active = smooth_speed_active;
+        state.direction = direction;
+        state.max_speed = max_speed;
+        state.current_speed = current_speed;
+        return state;
+    }
+
+    // => Publish current rotor state and release messages marked during this tick
+    void RotorController::publishSnapshot() {
+        snapshot.write(makeSnapshot());
+        messenger.releasePending();
     }
 }
 
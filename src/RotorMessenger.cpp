@@ -5,8 +5,11 @@
 #include <RotorController.h>
 #include <RotorMessenger.h>
 #include <RotorSocket.h>        // Exposes Global: websocket
+#include <Settings.h>
 
 #define ROTORSOCKET_BUFFER_SIZE 100
+#define SETTINGS_MSG_SIZE 64
+#define CALIBRATION_MSG_SIZE 120
 
 namespace Rotor {
 
@@ -16,87 +19,277 @@ namespace Rotor {
 
     Messenger::Messenger() {
         // Set message buffer size on the heap
-        msg_buffer.reserve(ROTORSOCKET_BUFFER_SIZE);
+        msg_buffer.reserve(ROTORSOCKET_BUFFER_SIZE + SETTINGS_MSG_SIZE + CALIBRATION_MSG_SIZE);
+        settings_buffer.reserve(SETTINGS_MSG_SIZE);
+        calibration_buffer.reserve(CALIBRATION_MSG_SIZE);
+        calibration_msg.reserve(CALIBRATION_MSG_SIZE);
     }
 
-    // => Create JSON message from last rotor values and save in msg_buffer
-    void Messenger::setLastRotationMsg(const bool with_angle) {
-        if (rotor_ptr != NULL) {
-            // Buffers
-            msg_buffer = MSG_ID_ROTOR;
-            msg_buffer += "|";
-            StaticJsonDocument<100> doc;
+    // => Initialisation, to be called once rotor_ptr is set
+    void Messenger::init() {
+        calibration_lock = xSemaphoreCreateMutex();
+        sendCalibration();
+    }
+
+    // => Mark fields of the published snapshot dirty, safe to be called from any task
+    void Messenger::markDirty(const uint8_t fields) {
+        dirty.fetch_or(fields);
+        n_requests++;
+    }
+
+    // => Mark fields dirty once the next snapshot is published, control task only
+    void Messenger::markPending(const uint8_t fields) {
+        pending |= fields | MSG_STATE_CHANGE;
+        n_requests++;
+    }
+
+    // => Release fields marked by the control task, called after publishing a snapshot
+    void Messenger::releasePending() {
+        if (pending) {
+            dirty.fetch_or(pending);
+            pending = 0;
+        }
+    }
 
-            // Rotation & direction | always included in msg
-            if (!rotor_ptr->is_rotating) {
+    // => Append rotor JSON message with given fields to buffer
+    void Messenger::appendRotorMsg(String &buffer, const Snapshot &state, const uint8_t fields) const {
+        buffer += MSG_ID_ROTOR;
+        buffer += "|";
+        StaticJsonDocument<160> doc;
+
+        // Rotation & direction
+        if (fields & MSG_FIELD_ROTATION) {
+            if (!state.is_rotating) {
                 doc["rotation"] = 0;
-            } else if (rotor_ptr->direction) {
+            } else if (state.direction) {
                 doc["rotation"] = 1;
             } else {
                 doc["rotation"] = -1;
             }
+        }
 
-            // Target | only included in msg if angle is not included and rotor is on auto-rotating
-            if (!with_angle && rotor_ptr->is_auto_rotating) {
-                doc["target"] = round(rotor_ptr->auto_rotation_target * 100.0) / 100.0;
-            }
+        // Max speed
+        if (fields & MSG_FIELD_SPEED) {
+            doc["speed"] = state.max_speed;
+        }
 
-            // Angle | only included in msg if specified
-            if (with_angle) {
-                doc["adc_v"] = round(rotor_ptr->rotor.last_adc_volts
-                                     * rotor_ptr->rotor.calibration.volt_div_factor
-                                     * 1000.0) / 1000.0;
-                doc["angle"] = round(rotor_ptr->rotor.last_angle * 100.0) / 100.0;
-            }
+        // Target | only while auto-rotating
+        if ((fields & MSG_FIELD_TARGET) && state.is_auto_rotating) {
+            doc["target"] = round(state.target * 100.0) / 100.0;
+        }
+
+        // Angle
+        if (fields & MSG_FIELD_ANGLE) {
+            doc["adc_v"] = round(state.adc_volts
+                                 * rotor_ptr->rotor.calibration.volt_div_factor
+                                 * 1000.0) / 1000.0;
+            doc["angle"] = round(state.angle * 100.0) / 100.0;
+            doc["t"] = state.ms;
+            doc["v"] = round(state.angular_speed * 100.0) / 100.0;
+        }
+
+        serializeJson(doc, buffer);
+    }
+
+    // => Create binary rotation frame with given fields from rotor state, same content as the JSON message
+    void Messenger::setRotationFrame(RotationFrame &frame, const Snapshot &state, const uint8_t fields) const {
+        if (!state.is_rotating) {
+            frame.rotation = 0;
+        } else if (state.direction) {
+            frame.rotation = 1;
+        } else {
+            frame.rotation = -1;
+        }
+
+        if (fields & MSG_FIELD_SPEED) {
+            frame.flags |= FRAME_HAS_SPEED;
+            frame.speed = state.max_speed;
+        }
 
-            // Set msg into buffer
-            serializeJson(doc, msg_buffer);
+        if ((fields & MSG_FIELD_TARGET) && state.is_auto_rotating) {
+            frame.flags |= FRAME_HAS_TARGET;
+            frame.target = (int32_t) round(state.target * 100.0f);
+        }
+
+        if (fields & MSG_FIELD_ANGLE) {
+            frame.flags |= FRAME_HAS_ANGLE;
+            frame.adc_mv = (uint16_t) round(state.adc_volts
+                                            * rotor_ptr->rotor.calibration.volt_div_factor
+                                            * 1000.0f);
+            frame.angle = (int32_t) round(state.angle * 100.0f);
+            frame.t = state.ms;
+            frame.v = (int16_t) constrain(round(state.angular_speed * 100.0f), -32768.0f, 32767.0f);
         }
     }
 
-    // => Send last rotation values
+    // => Send last rotation values. Target is included while auto-rotating, if angle is not
     void Messenger::sendLastRotation(const bool with_angle) {
-        setLastRotationMsg(with_angle);
-        websocket.textAll(msg_buffer);
+        markPending(MSG_FIELD_ROTATION | (with_angle ? MSG_FIELD_ANGLE : MSG_FIELD_TARGET));
     }
 
-    // => Send new rotation values from ADC, always includes angle
+    // => Send newest published rotation values, always includes angle
     void Messenger::sendNewRotation() {
-        rotor_ptr->rotor.update();
-        sendLastRotation(true);
+        markDirty(MSG_FIELD_ROTATION | MSG_FIELD_ANGLE);
     }
 
     // => Send max speed
     void Messenger::sendSpeed() {
-        msg_buffer = MSG_ID_ROTOR;
-        msg_buffer += "|";
-        StaticJsonDocument<16> doc;
-        doc["speed"] = rotor_ptr->max_speed;
-        serializeJson(doc, msg_buffer);
-        websocket.textAll(msg_buffer);
+        markPending(MSG_FIELD_SPEED);
+    }
+
+    // => Send auto rotation target
+    void Messenger::sendTarget() {
+        markPending(MSG_FIELD_TARGET);
     }
 
     // => Send current calibration parameters
     void Messenger::sendCalibration() {
-        msg_buffer = MSG_ID_CALIBRATION;
-        msg_buffer += "|";
         StaticJsonDocument<96> doc;
         doc["a1"] = round(rotor_ptr->rotor.calibration.a1 * 10000.0) / 10000.0;
         doc["u1"] = round(rotor_ptr->rotor.calibration.u1 * 10000.0) / 10000.0;
         doc["a2"] = round(rotor_ptr->rotor.calibration.a2 * 10000.0) / 10000.0;
         doc["u2"] = round(rotor_ptr->rotor.calibration.u2 * 10000.0) / 10000.0;
         doc["offset"] = rotor_ptr->rotor.calibration.offset;
-        serializeJson(doc, msg_buffer);
-        websocket.textAll(msg_buffer);
+
+        // Keep message for flush and connect snapshots, only this task writes it
+        xSemaphoreTake(calibration_lock, portMAX_DELAY);
+        calibration_msg = MSG_ID_CALIBRATION;
+        calibration_msg += "|";
+        serializeJson(doc, calibration_msg);
+        xSemaphoreGive(calibration_lock);
+
+        markPending(MSG_FIELD_CALIBRATION);
     }
 
-    // => Send auto rotation target
-    void Messenger::sendTarget() {
-        msg_buffer = MSG_ID_ROTOR;
-        msg_buffer += "|";
-        StaticJsonDocument<32> doc;
-        doc["target"] = round(rotor_ptr->auto_rotation_target * 100.0) / 100.0;
-        serializeJson(doc, msg_buffer);
-        websocket.textAll(msg_buffer);
+    // => Rotor fields included in given topics
+    uint8_t topicFields(const uint8_t topics) {
+        uint8_t fields = 0;
+        if (topics & TOPIC_ROTATION) {
+            fields |= MSG_FIELD_ROTATION | MSG_FIELD_ANGLE | MSG_FIELD_TARGET;
+        }
+        if (topics & TOPIC_SPEED) {
+            fields |= MSG_FIELD_SPEED;
+        }
+        return fields;
+    }
+
+    // => Send all dirty fields and settings as one frame per client, filtered by its subscription
+    void Messenger::flush() {
+        uint8_t fields = dirty.exchange(0);
+        uint32_t requests = n_requests.exchange(0);
+
+        // Messages other than rotor telemetry
+        calibration_buffer = "";
+        if (fields & MSG_FIELD_CALIBRATION) {
+            appendCalibration(calibration_buffer);
+        }
+        settings_buffer = "";
+        requests += Settings::appendChanges(settings_buffer);
+        const bool has_other = calibration_buffer.length() || settings_buffer.length();
+
+        // Catch up clients whose telemetry was held back, once their queue drained
+        RotorSocket::SendPolicy policy;
+        if (!(fields & MSG_FIELDS_ROTOR) && RotorSocket::hasStaleClients()) {
+            fields |= MSG_FIELD_ROTATION | MSG_FIELD_ANGLE;
+            policy.only_stale = !has_other;
+        }
+
+        if (!(fields & MSG_FIELDS_ROTOR) && !has_other) {
+            return;
+        }
+
+        // Pure telemetry may be held back for slow clients, state changes always get through
+        policy.is_telemetry = !(fields & MSG_STATE_CHANGE) && !has_other;
+        policy.has_rotor_state = (fields & MSG_FIELD_ANGLE);
+
+        // Frames are built on demand and reused for clients with the same subscription and format
+        const Snapshot state = rotor_ptr->getSnapshot();
+        RotationFrame frame;
+        uint16_t text_key = 0xFFFF;
+        uint8_t frame_fields = 0;
+        auto build = [&](const uint8_t topics, const bool binary, RotorSocket::Frame &out) -> bool {
+            const uint8_t rotor_fields = fields & topicFields(topics);
+            const bool with_calibration = calibration_buffer.length() && (topics & TOPIC_CALIBRATION);
+            const bool with_settings = settings_buffer.length() && (topics & TOPIC_SETTINGS);
+            unsigned long start_us;
+
+            // Binary clients get rotor fields as binary frame
+            if (binary && rotor_fields) {
+                if (rotor_fields != frame_fields) {
+                    start_us = micros();
+                    frame = RotationFrame();
+                    setRotationFrame(frame, state, rotor_fields);
+                    binary_stats.serialize_us += micros() - start_us;
+                    binary_stats.n_frames++;
+                    frame_fields = rotor_fields;
+                }
+                binary_stats.n_bytes += sizeof(frame);
+                out.data = (const uint8_t*) &frame;
+                out.len = sizeof(frame);
+            }
+
+            // Text frame, one message per line
+            const uint8_t text_rotor_fields = binary ? 0 : rotor_fields;
+            const uint16_t key = text_rotor_fields | (with_calibration << 8) | (with_settings << 9);
+            if (key != text_key) {
+                msg_buffer = "";
+                if (text_rotor_fields) {
+                    start_us = micros();
+                    appendRotorMsg(msg_buffer, state, text_rotor_fields);
+                    json_stats.serialize_us += micros() - start_us;
+                    json_stats.n_frames++;
+                }
+                if (with_calibration) {
+                    if (msg_buffer.length()) { msg_buffer += "\n"; }
+                    msg_buffer += calibration_buffer;
+                }
+                if (with_settings) {
+                    if (msg_buffer.length()) { msg_buffer += "\n"; }
+                    msg_buffer += settings_buffer;
+                }
+                text_key = key;
+            }
+            if (msg_buffer.length()) {
+                json_stats.n_bytes += binary ? 0 : msg_buffer.length();
+                out.text = &msg_buffer;
+            }
+            return out.text != nullptr || out.data != nullptr;
+        };
+
+        uint16_t n_frames = 0;
+        const uint8_t n_clients = RotorSocket::sendAll(policy, build, &n_frames);
+
+        // Without merging, each request would have been a frame to every client
+        if (requests * n_clients > n_frames) {
+            n_frames_saved += requests * n_clients - n_frames;
+        }
+    }
+
+    // => Append last calibration message to a connect snapshot, safe to be called from any task
+    void Messenger::appendCalibration(String &buffer) {
+        xSemaphoreTake(calibration_lock, portMAX_DELAY);
+        buffer += calibration_msg;
+        xSemaphoreGive(calibration_lock);
+    }
+
+    // => Append rotor state, speed and target from the last published snapshot to a connect snapshot
+    void Messenger::appendRotorState(String &buffer) {
+        appendRotorMsg(buffer, rotor_ptr->getSnapshot(), MSG_FIELDS_ROTOR);
+    }
+
+    // => Print bytes per second and serialization time per frame of both formats, reset statistics
+    void Messenger::printTelemetryStats() {
+        const float seconds = max(millis() - stats_start_ms, 1UL) / 1000.0f;
+        const TelemetryStats* formats[] = {&json_stats, &binary_stats};
+        const char* names[] = {"JSON", "Binary"};
+        for (uint8_t i = 0; i < 2; ++i) {
+            Serial.printf("[Websocket] %s telemetry: %u frames | %.0f B/s | %.1f us/frame\n\r",
+                          names[i], formats[i]->n_frames, formats[i]->n_bytes / seconds,
+                          formats[i]->n_frames ? (float) formats[i]->serialize_us / formats[i]->n_frames : 0.0f);
+        }
+        Serial.printf("[Websocket] Frames saved by merging: %u\n\r", n_frames_saved);
+        json_stats = TelemetryStats();
+        binary_stats = TelemetryStats();
+        stats_start_ms = millis();
     }
 }
@@ -1,6 +1,8 @@
 #include <Arduino.h>
 #include <ESPAsyncWebServer.h>
 #include <LittleFS.h>
+#include <ArduinoJson.h>
+#include <memory>
 
 #include <globals.h>
 #include <RotorController.h>  // Exposes Global: rotor_ctrl
@@ -8,9 +10,16 @@
 #include <RotorServer.h>
 #include <RotorSocket.h>      // Exposes Global: websocket
 #include <Firmware.h>         // Exposes Global: firmware
+#include <RotationHistory.h>  // Exposes Global: rotation_history
+#include <PositionLog.h>      // Exposes Global: position_log
+#include <MqttClient.h>
+#include <TelemetryMulticast.h>
 
-#include <AppIndex.h>
-#include <AppAssets.h>
+#ifdef UI_PARTITION
+#include <UiPartition.h>
+#else
+#include <AppAssetTable.h>
+#endif
 
 #define CONFIG_PREFS_KEY "serverPrefs"
 
@@ -30,6 +39,140 @@ namespace RotorServer {
     return true;
   }
 
+  AssetStats asset_stats;
+
+  // => Return wether an If-None-Match header lists the ETag
+  bool etagMatches(AsyncWebServerRequest *request, const char* etag) {
+    if (!request->hasHeader("If-None-Match")) {
+      return false;
+    }
+    const String &value = request->getHeader("If-None-Match")->value();
+    return value == "*" || value.indexOf(etag) >= 0;
+  }
+
+  // => Find a web asset by path, binary search in the sorted asset table or UI archive
+  bool findAsset(const char* path, Asset &asset) {
+    #ifdef UI_PARTITION
+    const UiArchiveEntry* entry = UiPartition::find(path);
+    if (entry == nullptr) {
+      return false;
+    }
+    const bool needs_auth = entry->flags & UI_ENTRY_AUTH;
+    asset = {entry->path, entry->content_type, UiPartition::getData(*entry), entry->len, entry->etag,
+             needs_auth ? INDEX_CACHE_CONTROL : ASSET_CACHE_CONTROL, (entry->flags & UI_ENTRY_GZIP) != 0, needs_auth};
+    return true;
+    #else
+    size_t low = 0;
+    size_t high = app_assets_len;
+    while (low < high) {
+      const size_t mid = (low + high) / 2;
+      const int cmp = strcmp(path, app_assets[mid].path);
+      if (cmp == 0) {
+        asset = app_assets[mid];
+        return true;
+      }
+      if (cmp < 0) {
+        high = mid;
+      } else {
+        low = mid + 1;
+      }
+    }
+    return false;
+    #endif
+  }
+
+  // => Send an embedded asset with its ETag, or 304 Not Modified if If-None-Match matches it
+  void sendAsset(AsyncWebServerRequest *request, const Asset &asset) {
+    asset_stats.n_requests++;
+    AsyncWebServerResponse *response;
+    if (etagMatches(request, asset.etag)) {
+      asset_stats.n_not_modified++;
+      asset_stats.n_bytes_saved += asset.len;
+      response = request->beginResponse(304);
+    } else {
+      asset_stats.n_bytes_sent += asset.len;
+      response = request->beginResponse_P(200, asset.content_type, asset.data, asset.len);
+      if (asset.gzip) {
+        response->addHeader("Content-Encoding", "gzip");
+      }
+      #ifdef UI_PARTITION
+      // Sent straight from the mapped archive
+      UiPartition::holdUntilSent(request);
+      #endif
+    }
+    response->addHeader("ETag", asset.etag);
+    response->addHeader("cache-control", asset.cache_control);
+    request->send(response);
+  }
+
+  // => Return wether the last segment of a path has an extension, i.e. names a file
+  bool isFilePath(const char* path) {
+    const char* name = strrchr(path, '/');
+    return strchr(name != nullptr ? name : path, '.') != nullptr;
+  }
+
+  // => Send the embedded asset at the request's path or 404, without the app index
+  void serveStaticAsset(AsyncWebServerRequest *request) {
+    Asset asset;
+    if (!findAsset(request->url().c_str(), asset) || asset.needs_auth) {
+      asset_stats.n_not_found++;
+      request->send(404);
+      return;
+    }
+    sendAsset(request, asset);
+  }
+
+  // => Route requests no other handler took: embedded assets by path, 404 for other
+  // file paths and the Vue-App index for app routes, which the app resolves itself
+  void routeRequest(AsyncWebServerRequest *request) {
+    if (request->method() == HTTP_OPTIONS) {
+      // CORS preflight
+      request->send(200);
+      return;
+    }
+    if (request->method() != HTTP_GET) {
+      request->send(404);
+      return;
+    }
+    const char* path = request->url().c_str();
+    Asset asset;
+    if (!findAsset(path, asset)) {
+      if (isFilePath(path)) {
+        asset_stats.n_not_found++;
+        request->send(404);
+        return;
+      }
+      // Necessary for page reloads in the Vue-App, redirects won't work
+      if (!findAsset("/", asset)) {
+        request->send(503, "text/plain", "No UI installed, upload the UI archive to /ui-update.");
+        return;
+      }
+    }
+    if (asset.needs_auth && !authenticateRequest(request)) { return; }
+    sendAsset(request, asset);
+  }
+
+  // => Copy a form parameter of a POST body into a fixed buffer. False if it doesn't fit,
+  // the buffer is kept if the parameter is missing.
+  bool copyParam(AsyncWebServerRequest *request, const char* name, char* buffer, const size_t size) {
+    if (!request->hasParam(name, true)) {
+      return true;
+    }
+    const String &value = request->getParam(name, true)->value();
+    if (value.length() >= size) {
+      return false;
+    }
+    strlcpy(buffer, value.c_str(), size);
+    return true;
+  }
+
+  // => Print asset statistics to Serial
+  void printAssetStats() {
+    Serial.printf("[Server] Assets: %u requests | %u not modified | %u not found | %u B sent | %u B saved\n\r",
+                  asset_stats.n_requests, asset_stats.n_not_modified, asset_stats.n_not_found,
+                  asset_stats.n_bytes_sent, asset_stats.n_bytes_saved);
+  }
+
 
   // ==============================
   // Server Config
@@ -107,65 +250,8 @@ namespace RotorServer {
     DefaultHeaders::Instance().addHeader("Access-Control-Expose-Headers", "Token");
     */
     
-  // Catch all route
-    server->onNotFound([](AsyncWebServerRequest *request) {
-      if (request->method() == HTTP_OPTIONS) {
-          // CORS preflight
-        request->send(200);
-      } else {
-        // Send root, necessary for page reloads in Vue-App (redirect won't work)
-        if (!authenticateRequest(request)) { return; }
-        AsyncWebServerResponse *response = request->beginResponse_P(200, "text/html", index_html_gzip, index_html_gzip_len);
-        response->addHeader("Content-Encoding", "gzip");
-        response->addHeader("cache-control", "private, max-age=86400");
-        request->send(response);
-      }
-    });
-
-
-    // Root route, Vue-App index file
-    server->on("/", HTTP_GET, [](AsyncWebServerRequest* request) {
-      if (!authenticateRequest(request)) { return; }
-      AsyncWebServerResponse *response = request->beginResponse_P(200, "text/html", index_html_gzip, index_html_gzip_len);
-      response->addHeader("Content-Encoding", "gzip");
-      response->addHeader("cache-control", "private, max-age=86400");
-      request->send(response);
-    });
-
-
-    // Fonts
-    // -----
-    server->on("/inter-regular.woff2", HTTP_GET, [](AsyncWebServerRequest* request) {
-      AsyncWebServerResponse *response = request->beginResponse_P(200, "font/woff2", inter_regular_woff2, inter_regular_woff2_len);
-      response->addHeader("cache-control", ASSET_CACHE_CONTROL);
-      request->send(response);
-    });
-
-    server->on("/inter-700.woff2", HTTP_GET, [](AsyncWebServerRequest* request) {
-      AsyncWebServerResponse *response = request->beginResponse_P(200, "font/woff2", inter_700_woff2, inter_700_woff2_len);
-      response->addHeader("cache-control", ASSET_CACHE_CONTROL);
-      request->send(response);
-    });
-
-    // Favicons
-    // --------
-    server->on("/favicon-16x16.png", HTTP_GET, [](AsyncWebServerRequest* request) {
-      AsyncWebServerResponse *response = request->beginResponse_P(200, "image/png", favicon_16x16_png, favicon_16x16_png_len);
-      response->addHeader("cache-control", ASSET_CACHE_CONTROL);
-      request->send(response);
-    });
-
-    server->on("/favicon-32x32.png", HTTP_GET, [](AsyncWebServerRequest* request) {
-      AsyncWebServerResponse *response = request->beginResponse_P(200, "image/png", favicon_32x32_png, favicon_32x32_png_len);
-      response->addHeader("cache-control", ASSET_CACHE_CONTROL);
-      request->send(response);
-    });
-
-    server->on("/apple-touch-icon.png", HTTP_GET, [](AsyncWebServerRequest* request) {
-      AsyncWebServerResponse *response = request->beginResponse_P(200, "image/png", apple_touch_icon_png, apple_touch_icon_png_len);
-      response->addHeader("cache-control", ASSET_CACHE_CONTROL);
-      request->send(response);
-    });
+  // Embedded assets and Vue-App routes, looked up in the generated asset table
+    server->onNotFound(routeRequest);
 
 
     // Reboot ESP
@@ -192,6 +278,49 @@ namespace RotorServer {
     });
 
 
+    // Rotation history, streamed as binary blocks or as CSV with format=csv.
+    // since: device millis of the first sample, negative values are relative to now.
+    server->on("/history", HTTP_GET, [](AsyncWebServerRequest* request) {
+      if (!authenticateRequest(request)) { return; }
+      uint32_t since_ms = millis() - INT32_MAX;
+      if (request->hasParam("since")) {
+        const long since = request->getParam("since")->value().toInt();
+        since_ms = since < 0 ? millis() + since : since;
+      }
+      const bool csv = request->hasParam("format") && request->getParam("format")->value() == "csv";
+
+      // Reader lives as long as the response
+      auto reader = std::make_shared<Rotor::HistoryReader>(rotation_history, since_ms, csv);
+      AsyncWebServerResponse *response = request->beginChunkedResponse(
+        csv ? "text/csv" : "application/octet-stream",
+        [reader](uint8_t *buffer, size_t max_len, size_t index) -> size_t {
+          return reader->read(buffer, max_len);
+        });
+      response->addHeader("cache-control", "no-store");
+      request->send(response);
+    });
+
+
+    // Position log, streamed from the segment files.
+    // from, to: unix time in s, batches written before the clock was set are only in complete downloads.
+    server->on("/log", HTTP_GET, [](AsyncWebServerRequest* request) {
+      if (!authenticateRequest(request)) { return; }
+      const uint32_t from = request->hasParam("from") ? request->getParam("from")->value().toInt() : 0;
+      const uint32_t to = request->hasParam("to") ? request->getParam("to")->value().toInt() : 0;
+
+      // Reader lives as long as the response
+      auto reader = std::make_shared<Rotor::LogReader>(position_log, from, to);
+      AsyncWebServerResponse *response = request->beginChunkedResponse(
+        "application/octet-stream",
+        [reader](uint8_t *buffer, size_t max_len, size_t index) -> size_t {
+          return reader->read(buffer, max_len);
+        });
+      response->addHeader("Content-Disposition", "attachment; filename=\"rotor.log\"");
+      response->addHeader("cache-control", "no-store");
+      request->send(response);
+    });
+
+
     // URLS not available in demo mode
     #ifndef DEMO_MODE
     // Disconnect ESP from network
@@ -208,6 +337,72 @@ namespace RotorServer {
 
     // Update firmware
     server->on("/update", HTTP_POST, Firmware::handleFirmwareResponse, Firmware::handleFirmwareUpload);   
+
+    #ifdef UI_PARTITION
+    // Update the UI archive, ?md5=<md5 of the archive>
+    server->on("/ui-update", HTTP_POST, UiPartition::handleUploadResponse, UiPartition::handleUpload);
+    #endif
+
+    // MQTT broker config. GET answers with the config in use, POST sets the given form parameters
+    // (host, port, user, pw, topic) and reconnects. An empty host disables MQTT.
+    server->on("/mqtt", HTTP_GET | HTTP_POST, [](AsyncWebServerRequest* request) {
+      if (!authenticateRequest(request)) { return; }
+      Mqtt::Config config = Mqtt::getConfig();
+      if (request->method() == HTTP_POST) {
+        // Checked on a copy, the client takes it over in the loop
+        bool is_valid = copyParam(request, "host", config.host, sizeof(config.host))
+                     && copyParam(request, "user", config.user, sizeof(config.user))
+                     && copyParam(request, "pw", config.password, sizeof(config.password))
+                     && copyParam(request, "topic", config.base_topic, sizeof(config.base_topic));
+        if (request->hasParam("port", true)) {
+          const long port = request->getParam("port", true)->value().toInt();
+          is_valid &= port > 0 && port <= 65535;
+          config.port = (uint16_t) port;
+        }
+        if (!is_valid || !Mqtt::setConfig(config)) {
+          request->send(400, "text/plain", "Invalid MQTT configuration");
+          return;
+        }
+      }
+      StaticJsonDocument<256> doc;
+      doc["host"] = config.host;
+      doc["port"] = config.port;
+      doc["user"] = config.user;
+      doc["topic"] = config.base_topic;
+      doc["connected"] = Mqtt::isConnected();
+      String buffer;
+      serializeJson(doc, buffer);
+      request->send(200, "application/json", buffer);
+    });
+
+    // Multicast telemetry config. GET answers with the config in use, POST sets the given form
+    // parameters (group, port, rate in Hz). A rate of 0 disables the stream.
+    server->on("/multicast", HTTP_GET | HTTP_POST, [](AsyncWebServerRequest* request) {
+      if (!authenticateRequest(request)) { return; }
+      Multicast::Config config = Multicast::getConfig();
+      if (request->method() == HTTP_POST) {
+        // Checked on a copy, the stream takes it over in the loop
+        bool is_valid = copyParam(request, "group", config.group, sizeof(config.group));
+        if (request->hasParam("port", true)) {
+          const long port = request->getParam("port", true)->value().toInt();
+          is_valid &= port > 0 && port <= 65535;
+          config.port = (uint16_t) port;
+        }
+        if (request->hasParam("rate", true)) {
+          const long rate = request->getParam("rate", true)->value().toInt();
+          is_valid &= rate >= 0 && rate <= UINT8_MAX;
+          config.rate_hz = (uint8_t) rate;
+        }
+        if (!is_valid || !Multicast::setConfig(config)) {
+          request->send(400, "text/plain", "Invalid multicast configuration");
+          return;
+        }
+      }
+      char buffer[96];
+      snprintf(buffer, sizeof(buffer), "{\"group\":\"%s\",\"port\":%u,\"rate\":%u}",
+               config.group, config.port, config.rate_hz);
+      request->send(200, "application/json", buffer);
+    });
     #endif
   }
 }
@@ -0,0 +1,70 @@
+#include <Arduino.h>
+#include <math.h>
+
+#include <RotorSimulator.h>
+
+#define VOLT_DIV_FACTOR 1.5f
+
+
+namespace Rotor {
+
+    // ************************
+    // Define Simulator members
+    // ************************
+
+    // => Gaussian random number with standard deviation 1, Box-Muller
+    float Simulator::randomGauss() const {
+        float u1 = (esp_random() + 1.0f) / 4294967297.0f;
+        float u2 = esp_random() / 4294967296.0f;
+        return sqrt(-2.0f * log(u1)) * cos(2.0f * PI * u2);
+    }
+
+    // => Integrate the model up to given time
+    void Simulator::step(const unsigned long us) {
+        if (last_us == 0) {
+            last_us = us;
+            return;
+        }
+        const float dt = (us - last_us) / 1000000.0f;
+        last_us = us;
+
+        // Steady-state speed the motor is driven towards, the control unit turns at
+        // its lowest speed with the DAC disabled
+        float target_speed = 0.0f;
+        float tau = model.coast_tau;
+        if (relay != 0) {
+            float speed = model.min_speed
+                        + (model.full_speed * model.dac_max_fraction - model.min_speed) * dac_speed / 100.0f;
+            target_speed = relay * speed;
+            tau = model.accel_tau;
+        }
+
+        // First order response, inertia and coasting
+        angular_speed += (target_speed - angular_speed) * (1.0f - exp(-dt / tau));
+        if (relay == 0 && abs(angular_speed) < 0.05f) {
+            angular_speed = 0.0f;
+        }
+        angle += angular_speed * dt;
+
+        // End stops
+        if (angle <= model.end_stop_low) {
+            angle = model.end_stop_low;
+            angular_speed = max(angular_speed, 0.0f);
+        } else if (angle >= model.end_stop_high) {
+            angle = model.end_stop_high;
+            angular_speed = min(angular_speed, 0.0f);
+        }
+    }
+
+    // => Voltage at the ADC input for the current angle, including noise
+    float Simulator::readADCVolts() const {
+        float volts = (model.volts_offset + angle * model.volts_per_degree) / VOLT_DIV_FACTOR;
+        volts += model.noise_volts * randomGauss();
+        if (esp_random() < model.spike_probability * 4294967295.0f) {
+            volts += 0.2f * randomGauss();
+        }
+        return volts;
+    }
+}
+
+Rotor::Simulator rotor_sim;
@@ -1,6 +1,6 @@
 #include <Arduino.h>
 #include <ESPAsyncWebServer.h>
-#include <ArduinoJson.h>
+#include <atomic>
 
 #include <globals.h>
 #include <RotorController.h>    // Exposes Global: rotor_ctrl
@@ -8,8 +8,12 @@
 #include <Favorites.h>
 #include <Screen.h>             // Exposes Global: screen
 #include <RotorSocket.h>
+#include <SocketMessages.h>
 
 #define SOCKET_URL "/ws"
+#define INITIAL_STATE_BUFFER_SIZE 1536
+#define DIAG_BUFFER_SIZE 384
+#define COMMANDS_PER_MSG 3
 
 
 extern Favorites favorites;
@@ -21,15 +25,349 @@ namespace RotorSocket {
   // Number of connected socket clients
   uint8_t clients_connected;
 
+  // Registered clients, changed by the async_tcp task and walked by the loop
+  ClientState clients[SOCKET_MAX_CLIENTS];
+  SemaphoreHandle_t registry_lock = nullptr;
+
+  // Holds the registry lock for its scope. Not recursive, sendAll must not be called while held.
+  struct RegistryLock {
+    RegistryLock() { xSemaphoreTake(registry_lock, portMAX_DELAY); }
+    ~RegistryLock() { xSemaphoreGive(registry_lock); }
+  };
+
+  // State messages received by the async_tcp task, applied by the loop. Latest wins, guarded by pending_lock.
+  struct {
+    String favorites;
+    String lock;
+    bool has_favorites = false;
+    bool has_lock = false;
+    bool has_screen = false;
+    bool use_screen = false;
+  } pending;
+  std::atomic<bool> has_pending{false};
+  SemaphoreHandle_t pending_lock = nullptr;
+
+  // Holds the pending lock for its scope
+  struct PendingLock {
+    PendingLock() { xSemaphoreTake(pending_lock, portMAX_DELAY); }
+    ~PendingLock() { xSemaphoreGive(pending_lock); }
+  };
+
+  // Clients connected since the loop last sent the connect snapshot
+  std::atomic<bool> has_new_clients{false};
+
+  // Connect snapshot, reused for every new client
+  String initial_state_buffer;
+
+  // Diagnostics message, built on request
+  String diag_buffer;
+
+  // Time the message being handled was received, in µs
+  uint32_t rx_us = 0;
+
+  // Joins messages split into several frames or TCP segments
+  MessageAssembler assembler;
+
   // Forward-declare functions
-  void socketReceive(char* msg, const size_t len);
+  void socketReceive(AsyncWebSocketClient* client, char* msg, const size_t len);
   void onSocketEvent(AsyncWebSocket* server, AsyncWebSocketClient* client, AwsEventType type, void* arg, uint8_t* data, size_t len);
 
   // => Add event handler to socket
   void initWebsocket() {
+    registry_lock = xSemaphoreCreateMutex();
+    pending_lock = xSemaphoreCreateMutex();
+    initial_state_buffer.reserve(INITIAL_STATE_BUFFER_SIZE);
+    diag_buffer.reserve(DIAG_BUFFER_SIZE);
     websocket.onEvent(onSocketEvent);
   }
 
+  // => Send text to a client, as a single frame if it negotiated bundling, else one frame per line.
+  // Returns the number of frames sent.
+  uint16_t sendText(AsyncWebSocketClient* client, const String &text, const bool bundle) {
+    if (bundle) {
+      client->text(text);
+      return 1;
+    }
+    uint16_t n_frames = 0;
+    const char* line = text.c_str();
+    const char* end = line + text.length();
+    while (line < end) {
+      const char* newline = (const char*) memchr(line, '\n', end - line);
+      const char* line_end = newline != nullptr ? newline : end;
+      if (line_end > line) {
+        client->text(line, line_end - line);
+        ++n_frames;
+      }
+      line = line_end + 1;
+    }
+    return n_frames;
+  }
+
+  // => Build the complete state for newly connected clients.
+  // Messages are formatted as 'ID|json', sent one per frame, new clients did not negotiate bundling yet.
+  void buildInitialState() {
+    initial_state_buffer = lock_msg;
+    initial_state_buffer += "\n";
+    Settings::appendSettings(initial_state_buffer);
+    initial_state_buffer += "\n";
+    rotor_ctrl.messenger.appendCalibration(initial_state_buffer);
+    initial_state_buffer += "\n";
+    rotor_ctrl.messenger.appendRotorState(initial_state_buffer);
+    favorites.appendTo(initial_state_buffer);
+  }
+
+  // ***************
+  // Client registry
+  // ***************
+
+  // => Get registered client by id, nullptr if unknown. To be used with the registry locked.
+  ClientState* getClient(const uint32_t id) {
+    for (uint8_t i = 0; i < SOCKET_MAX_CLIENTS; ++i) {
+      if (clients[i].id == id) {
+        return &clients[i];
+      }
+    }
+    return nullptr;
+  }
+
+  // => Register a new client, new clients start with JSON telemetry
+  void registerClient(const uint32_t id) {
+    RegistryLock lock;
+    ClientState* client = getClient(0);
+    if (client == nullptr) {
+      Serial.println("[Websocket] Client registry full.");
+      return;
+    }
+    *client = ClientState();
+    client->id = id;
+    client->greeting_due = true;
+    has_new_clients = true;
+  }
+
+  // => Free registry slot and reassembly buffer of a client
+  void unregisterClient(const uint32_t id) {
+    RegistryLock lock;
+    ClientState* client = getClient(id);
+    if (client != nullptr) {
+      assembler.release(client->slot);
+      client->id = 0;
+    }
+  }
+
+  // => Return wether a client may get telemetry according to its rate limit
+  bool rateAllows(const ClientState &state) {
+    return !state.min_interval_ms || millis() - state.last_telemetry_ms >= state.min_interval_ms;
+  }
+
+  // => Send a frame built per subscription to all registered clients
+  uint8_t sendAll(const SendPolicy &policy, const FrameBuilder &build, uint16_t *n_frames) {
+    RegistryLock lock;
+    uint8_t n_clients = 0;
+    for (uint8_t i = 0; i < SOCKET_MAX_CLIENTS; ++i) {
+      ClientState &state = clients[i];
+      // New clients get the complete state first
+      if (!state.id || state.greeting_due || (policy.only_stale && !state.telemetry_stale)) {
+        continue;
+      }
+      AsyncWebSocketClient* client = websocket.client(state.id);
+      if (client == nullptr) {
+        continue;
+      }
+
+      // Queue depth
+      const size_t queue_len = client->queueLen();
+      state.max_queue_len = max(state.max_queue_len, queue_len);
+
+      // Nothing subscribed in this frame
+      Frame frame;
+      if (!build(state.topics, state.binary, frame)) {
+        continue;
+      }
+
+      // Latest wins, newer telemetry replaces the one held back
+      if (policy.is_telemetry && queue_len >= TELEMETRY_MAX_QUEUED) {
+        if (state.telemetry_stale) {
+          state.n_replaced++;
+        }
+        state.telemetry_stale = true;
+        continue;
+      }
+      if (policy.is_telemetry && !rateAllows(state)) {
+        state.n_rate_limited++;
+        state.telemetry_stale = true;
+        continue;
+      }
+
+      // Frames may only be lost if the queue is full
+      if (client->queueIsFull()) {
+        state.n_dropped++;
+        continue;
+      }
+
+      if (frame.data != nullptr) {
+        client->binary(frame.data, frame.len);
+        if (n_frames != nullptr) { ++*n_frames; }
+      }
+      if (frame.text != nullptr) {
+        const uint16_t n_text_frames = sendText(client, *frame.text, state.bundle);
+        if (n_frames != nullptr) { *n_frames += n_text_frames; }
+      }
+      ++n_clients;
+      if (policy.has_rotor_state && (state.topics & TOPIC_ROTATION)) {
+        state.telemetry_stale = false;
+        state.last_telemetry_ms = millis();
+      }
+    }
+    return n_clients;
+  }
+
+  // => Return wether a client with stale telemetry can take the latest state again
+  bool hasStaleClients() {
+    RegistryLock lock;
+    for (uint8_t i = 0; i < SOCKET_MAX_CLIENTS; ++i) {
+      if (clients[i].id && clients[i].telemetry_stale && rateAllows(clients[i])) {
+        AsyncWebSocketClient* client = websocket.client(clients[i].id);
+        if (client != nullptr && client->queueLen() < TELEMETRY_MAX_QUEUED) {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  // => Send the complete state to clients that connected since the last call
+  void greetNewClients() {
+    if (!has_new_clients.exchange(false)) {
+      return;
+    }
+    buildInitialState();
+    RegistryLock lock;
+    for (uint8_t i = 0; i < SOCKET_MAX_CLIENTS; ++i) {
+      ClientState &state = clients[i];
+      if (!state.id || !state.greeting_due) {
+        continue;
+      }
+      state.greeting_due = false;
+      AsyncWebSocketClient* client = websocket.client(state.id);
+      if (client != nullptr) {
+        sendText(client, initial_state_buffer, false);
+      }
+    }
+  }
+
+  // => Apply favorites, lock and settings messages received since the last call
+  void applyPending() {
+    if (!has_pending.exchange(false)) {
+      return;
+    }
+    String favorites_msg;
+    String new_lock_msg;
+    bool has_favorites, has_lock, has_screen, new_use_screen;
+    {
+      PendingLock lock;
+      has_favorites = pending.has_favorites;
+      has_lock = pending.has_lock;
+      has_screen = pending.has_screen;
+      new_use_screen = pending.use_screen;
+      if (has_favorites) { favorites_msg = pending.favorites; }
+      if (has_lock) { new_lock_msg = pending.lock; }
+      pending.has_favorites = pending.has_lock = pending.has_screen = false;
+    }
+
+    // Screen
+    if (has_screen) {
+      use_screen = new_use_screen;
+      if (use_screen) {
+        screen.enable();
+      } else {
+        screen.disable();
+      }
+      // Distribute to clients
+      Settings::sendScreen();
+    }
+
+    // Favorites are saved and sent as a whole
+    if (has_favorites) {
+      favorites.set(favorites_msg.c_str());
+    }
+
+    // Lock is distributed to all clients
+    if (has_lock) {
+      lock_msg = new_lock_msg;
+      websocket.textAll(lock_msg);
+    }
+  }
+
+  // => Send acknowledgements of commands applied by the control task
+  void sendAcks() {
+    Rotor::CommandAck ack;
+    while (rotor_ctrl.acks.pop(ack)) {
+      AsyncWebSocketClient* client = websocket.client(ack.client_id);
+      if (client == nullptr) {
+        continue;
+      }
+      char buffer[96];
+      snprintf(buffer, sizeof(buffer), MSG_ID_ACK "|{\"seq\":%u,\"ok\":true,\"rx\":%u,\"applied\":%u}",
+               ack.seq, ack.rx_us, ack.applied_us);
+      client->text(buffer);
+    }
+  }
+
+  // => Ping all clients to measure round trip times
+  void pingClients() {
+    RegistryLock lock;
+    char buffer[32];
+    for (uint8_t i = 0; i < SOCKET_MAX_CLIENTS; ++i) {
+      ClientState &state = clients[i];
+      if (!state.id) {
+        continue;
+      }
+      AsyncWebSocketClient* client = websocket.client(state.id);
+      if (client == nullptr || client->queueIsFull()) {
+        continue;
+      }
+      state.ping_id++;
+      state.n_pings++;
+      snprintf(buffer, sizeof(buffer), MSG_ID_PING "|{\"id\":%u}", state.ping_id);
+      state.ping_us = micros();
+      client->text(buffer);
+    }
+  }
+
+  // => Print send queue and drop/replace counters of all clients to Serial
+  void printClientStats() {
+    RegistryLock lock;
+    for (uint8_t i = 0; i < SOCKET_MAX_CLIENTS; ++i) {
+      if (!clients[i].id) {
+        continue;
+      }
+      AsyncWebSocketClient* client = websocket.client(clients[i].id);
+      Serial.printf("[Websocket] Client %u (%s, topics 0x%02X) | Queue: %u (max %u) | "
+                    "Replaced: %u | Rate limited: %u | Dropped: %u | "
+                    "RTT (last/min/max): %u / %u / %u us, %u of %u pings answered\n\r",
+                    clients[i].id, clients[i].binary ? "binary" : "JSON", clients[i].topics,
+                    client != nullptr ? client->queueLen() : 0, clients[i].max_queue_len,
+                    clients[i].n_replaced, clients[i].n_rate_limited, clients[i].n_dropped,
+                    clients[i].rtt_us, clients[i].min_rtt_us, clients[i].max_rtt_us,
+                    clients[i].n_pongs, clients[i].n_pings);
+    }
+    Serial.printf("[Websocket] Reassembly: %u B arena, %u slots (max %u used) | Messages: %u (max %u B) | "
+                  "Time (last/max): %u / %u us | Too large: %u | No slot: %u\n\r",
+                  assembler.arenaSize(), SOCKET_REASSEMBLY_SLOTS, assembler.stats.max_slots_used,
+                  assembler.stats.n_messages, assembler.stats.max_size,
+                  assembler.stats.last_us, assembler.stats.max_us,
+                  assembler.stats.n_too_large, assembler.stats.n_no_slot);
+
+    // Command latency, frame received to command applied or relay change
+    const Rotor::LatencyHistogram &latency = rotor_ctrl.command_latency;
+    Serial.printf("[Websocket] Command latency: %u commands | Mean: %u us | Max: %u us | Bins:",
+                  latency.n, latency.n ? (uint32_t) (latency.sum_us / latency.n) : 0, latency.max_us);
+    for (uint8_t i = 0; i < LATENCY_BINS - 1; ++i) {
+      Serial.printf(" <%dms: %u", Rotor::LatencyHistogram::binLimitMs(i), latency.bins[i]);
+    }
+    Serial.printf(" >=%dms: %u\n\r", Rotor::LatencyHistogram::binLimitMs(LATENCY_BINS - 2), latency.bins[LATENCY_BINS - 1]);
+  }
+
   // ********************
   // Socket event handler
   // ********************
@@ -38,18 +376,7 @@ namespace RotorSocket {
     switch (type) {
       case WS_EVT_CONNECT:
         ++clients_connected;
-
-        // -----
-
-        websocket.textAll(lock_msg);
-        Settings::sendSettings();
-        rotor_ctrl.messenger.sendSpeed();
-        rotor_ctrl.messenger.sendCalibration();
-        rotor_ctrl.messenger.sendLastRotation(false);
-        favorites.send();
-
-        // -----
-
+        registerClient(client->id());
         Serial.print("[Websocket] Client ");
         Serial.print(client->id());
         Serial.print(" connected with IP: ");
@@ -58,6 +385,7 @@ namespace RotorSocket {
 
     case WS_EVT_DISCONNECT:
         --clients_connected;
+        unregisterClient(client->id());
         Serial.print("[Websocket] Client ");
         Serial.print(client->id());
         Serial.println(" disconnected.");
@@ -72,190 +400,364 @@ namespace RotorSocket {
         break;     
 
       case WS_EVT_DATA:
+        rx_us = micros();
         AwsFrameInfo * info = (AwsFrameInfo*) arg;
-        if(info->final && info->index == 0 && info->len == len){
-          // The whole message is a single frame and was fully received
-          if(info->opcode == WS_TEXT) {
-            data[len] = 0;
-
-            // Print message
-            if (verbose) {
-              Serial.print("[Websocket] Data, client ");
-              Serial.print(client->id());
-              Serial.print(": ");
-              Serial.println((char*) data);
-            }
-
-            // Receive
-            socketReceive((char*) data, len);
-
-          } else {
-            Serial.println("[Websocket] Binary data received unexpectedly.");
+        size_t msg_len = 0;
+        char* msg = nullptr;
+        {
+          RegistryLock lock;
+          ClientState* state = getClient(client->id());
+          if (state != nullptr) {
+            msg = assembler.feed(state->slot, *info, data, len, msg_len);
           }
-        } else {
-          Serial.println("[Websocket] Data recieved in multiple frames.");
         }
+        if (msg == nullptr) {
+          break;
+        }
+
+        // Print message
+        if (verbose) {
+          Serial.print("[Websocket] Data, client ");
+          Serial.print(client->id());
+          Serial.print(": ");
+          Serial.println(msg);
+        }
+
+        // Receive
+        socketReceive(client, msg, msg_len);
         break;
     }
   }    
 
 
-  // ***********************
-  // Socket receive function
-  // ***********************
+  // ****************
+  // Message handlers
+  // ****************
+  // Each handler gets the whole message and its JSON payload, both null-terminated
 
-  void socketReceive(char* msg, const size_t len) {
-    // Separate message from identifier, separated by '|'
-    int sep_idx;  // Index of separator
-    for(sep_idx = 0; sep_idx < len; ++sep_idx) {
-      if (msg[sep_idx] == '|') { break; }
+  // => Log a payload that failed to parse
+  void parseError(const char* id) {
+    Serial.print("[Websocket] Error: JSON parse failed: ");
+    Serial.println(id);
+  }
+
+  // => Send a negative acknowledgement, command was not applied
+  void sendNack(AsyncWebSocketClient* client, const uint32_t seq) {
+    char buffer[48];
+    snprintf(buffer, sizeof(buffer), MSG_ID_ACK "|{\"seq\":%u,\"ok\":false}", seq);
+    client->text(buffer);
+  }
+
+  // => Post commands of a message to the control task.
+  // With a sequence number, the last command is acknowledged once applied.
+  // Messages of other transports (client is nullptr) are not acknowledged.
+  void postCommands(AsyncWebSocketClient* client, Rotor::Command* cmds, const uint8_t n_cmds,
+                    bool has_seq, const uint32_t seq) {
+    has_seq &= client != nullptr;
+    bool posted = n_cmds > 0;
+    for (uint8_t i = 0; i < n_cmds; ++i) {
+      cmds[i].rx_us = rx_us;
+      if (has_seq && i == n_cmds - 1) {
+        cmds[i].client_id = client->id();
+        cmds[i].seq = seq;
+      }
+      posted &= rotor_ctrl.post(cmds[i]);
+    }
+    if (has_seq && !posted) {
+      sendNack(client, seq);
     }
+  }
 
-    // Split message by inserting null-terminator
-    if (sep_idx != 0 && sep_idx != len) {
-      msg[sep_idx] = '\0';
-    } else {
-      Serial.println("[Websocket] Error: Could not parse message.");
+  // ----- ROTOR -----
+  void receiveRotor(AsyncWebSocketClient* client, char* msg, char* payload, const size_t len) {
+    SocketMessages::RotorMsg rotor_msg;
+    if (!SocketMessages::parse(payload, len, rotor_msg)) {
+      parseError(MSG_ID_ROTOR);
       return;
     }
 
-    String identifier(msg);
+    // Commands are posted to the control task and applied there
+    Rotor::Command cmds[COMMANDS_PER_MSG];
+    uint8_t n_cmds = 0;
+
+    // Rotation
+    if (rotor_msg.fields & ROTOR_MSG_ROTATION) {
+      switch (rotor_msg.rotation) {
+        case 0:
+          cmds[n_cmds++] = Rotor::Command::stop(); break;
+        case -1:
+          cmds[n_cmds++] = Rotor::Command::rotate(0); break;
+        case 1:
+          cmds[n_cmds++] = Rotor::Command::rotate(1); break;
+      }
+    }
 
-    // ----- ROTOR -----
-    // -----------------
-    if (identifier == MSG_ID_ROTOR) {
-      // Deserialize JSON
-      StaticJsonDocument<50> doc;
-      DeserializationError err = deserializeJson(doc, msg + sep_idx + 1);
+    // Speed
+    if (rotor_msg.fields & ROTOR_MSG_SPEED) {
+      cmds[n_cmds++] = Rotor::Command::setSpeed(constrain(rotor_msg.speed, 0, 100));
+    }
 
-      // Test wether deserialization succeeded
-      if (err) {
-        Serial.print("[Websocket] Error: JSON parse failed: ");
-        Serial.println(err.f_str());
-        return;
-      }
+    // Auto-rotation request
+    const uint8_t auto_rotation = ROTOR_MSG_TARGET | ROTOR_MSG_OVERLAP | ROTOR_MSG_SMOOTH_SPEED;
+    if ((rotor_msg.fields & auto_rotation) == auto_rotation) {
+      cmds[n_cmds++] = Rotor::Command::rotateTo(rotor_msg.target,
+                                                rotor_msg.use_overlap,
+                                                rotor_msg.use_smooth_speed);
+    }
 
-      // \/\/ Unpack message \/\/
-      // Rotation
-      JsonVariant val;
-      val = doc["rotation"];
-      if (!val.isNull()) {
-        switch (val.as<const int>()) {
-          case 0: 
-            rotor_ctrl.stop(); break;
-          case -1:
-            rotor_ctrl.startRotation(0); break;
-          case 1:
-            rotor_ctrl.startRotation(1); break;
-        }
-      }
+    postCommands(client, cmds, n_cmds, rotor_msg.fields & ROTOR_MSG_SEQ, rotor_msg.seq);
+  }
 
-      // Speed
-      val = doc["speed"];
-      if (!val.isNull()) {
-        if (val < 0) {
-          rotor_ctrl.setMaxSpeed(0);
-        } else if (val > 100) {
-          rotor_ctrl.setMaxSpeed(100);
-        } else {
-          rotor_ctrl.setMaxSpeed(val.as<const uint8_t>());
-        }
-      }
+  // ----- CALIBRATION -----
+  void receiveCalibration(AsyncWebSocketClient* client, char* msg, char* payload, const size_t len) {
+    SocketMessages::CalibrationMsg cal_msg;
+    if (!SocketMessages::parse(payload, len, cal_msg)) {
+      parseError(MSG_ID_CALIBRATION);
+      return;
+    }
 
-      // Auto-rotation request
-      val = doc["target"];
-      if (!val.isNull()) {
-        JsonVariant use_overlap = doc["useOverlap"];
-        JsonVariant use_smooth_speed = doc["useSmoothSpeed"];
+    Rotor::Command cmds[COMMANDS_PER_MSG];
+    uint8_t n_cmds = 0;
 
-        if (!use_overlap.isNull() && !use_smooth_speed.isNull()) {
-          rotor_ctrl.rotateTo(val.as<const float>(),
-                              use_overlap.as<const bool>(),
-                              use_smooth_speed.as<const bool>());
-        }
-      }
+    // Calibration
+    if ((cal_msg.fields & CALIBRATION_MSG_POINTS) == CALIBRATION_MSG_POINTS) {
+      cmds[n_cmds++] = Rotor::Command::setCalibration(cal_msg.u1, cal_msg.u2, cal_msg.a1, cal_msg.a2);
     }
 
-    // ----- CALIBRATION -----
-    // -----------------------
-    if (identifier == MSG_ID_CALIBRATION) {
-      // Deserialize JSON
-      StaticJsonDocument<100> doc;
-      DeserializationError err = deserializeJson(doc, msg + sep_idx + 1);
+    // Angle offset
+    if (cal_msg.fields & CALIBRATION_MSG_OFFSET) {
+      cmds[n_cmds++] = Rotor::Command::setOffset(cal_msg.offset);
+    }
 
-      // Test wether deserialization succeeded
-      if (err) {
-        Serial.print("[Websocket] Error: JSON parse failed: ");
-        Serial.println(err.f_str());
-        return;
-      }
+    postCommands(client, cmds, n_cmds, cal_msg.fields & CALIBRATION_MSG_SEQ, cal_msg.seq);
+  }
 
-      // \/\/ Unpack message \/\/
-      // Calibration
-      JsonVariant cal_u1 = doc["u1"];
-      JsonVariant cal_u2 = doc["u2"];
-      JsonVariant cal_a1 = doc["a1"];
-      JsonVariant cal_a2 = doc["a2"];
-      if (!cal_u1.isNull() && !cal_u2.isNull()
-          && !cal_a1.isNull() && !cal_a2.isNull()) {
-        rotor_ctrl.setCalibration(cal_u1.as<const float>(), cal_u2.as<const float>(),
-                                  cal_a1.as<const float>(), cal_a2.as<const float>());
-      }
+  // ----- SETTINGS -----
+  void receiveSettings(AsyncWebSocketClient* client, char* msg, char* payload, const size_t len) {
+    SocketMessages::SettingsMsg settings_msg;
+    if (!SocketMessages::parse(payload, len, settings_msg)) {
+      parseError(MSG_ID_SETTINGS);
+      return;
+    }
 
-      // Angle offset
-      JsonVariant offset = doc["offset"];
-      if (!offset.isNull()) {
-        rotor_ctrl.setAngleOffset(offset.as<float>());
-      }
+    // Screen, switched by the loop
+    if (settings_msg.fields & SETTINGS_MSG_USE_SCREEN) {
+      PendingLock lock;
+      pending.has_screen = true;
+      pending.use_screen = settings_msg.use_screen;
+      has_pending = true;
     }
+  }
 
-    // ----- SETTINGS -----
-    // --------------------
-    if (identifier == MSG_ID_SETTINGS) {
-      // Deserialize JSON
-      StaticJsonDocument<48> doc;
-      DeserializationError err = deserializeJson(doc, msg + sep_idx + 1);
+  // ----- FAVORITES -----
+  void receiveFavorites(AsyncWebSocketClient* client, char* msg, char* payload, const size_t len) {
+    // For favorites, just keep the whole message including the identifier. Saved and sent by the loop.
+    PendingLock lock;
+    pending.favorites = msg;
+    pending.has_favorites = true;
+    has_pending = true;
+  }
 
-      // Test wether deserialization succeeded
-      if (err) {
-        Serial.print("[Websocket] Error: JSON parse failed: ");
-        Serial.println(err.f_str());
-        return;
-      }
+  // ----- LOCK -----
+  void receiveLock(AsyncWebSocketClient* client, char* msg, char* payload, const size_t len) {
+    // For lock, just keep the message. Distributed to all clients by the loop.
+    PendingLock lock;
+    pending.lock = msg;
+    pending.has_lock = true;
+    has_pending = true;
+  }
 
-      // \/\/ Unpack message \/\/
-      // Screen
-      JsonVariant val;
-      val = doc["useScreen"];
-      if (!val.isNull()) {
-        if (!val.as<const bool>()) {
-          use_screen = false;
-          screen.disable();
-        } else {
-          use_screen = true;
-          screen.enable();
-        }
-        // Distribute to clients
-        Settings::sendScreen();
-      }
+  // ----- PROTOCOL -----
+  void receiveProtocol(AsyncWebSocketClient* client, char* msg, char* payload, const size_t len) {
+    SocketMessages::ProtocolMsg protocol_msg;
+    if (!SocketMessages::parse(payload, len, protocol_msg)) {
+      parseError(MSG_ID_PROTOCOL);
+      return;
+    }
+
+    // Telemetry format of this client
+    RegistryLock lock;
+    ClientState* registered = getClient(client->id());
+    if (registered != nullptr && (protocol_msg.fields & PROTOCOL_MSG_BINARY)) {
+      registered->binary = protocol_msg.binary;
+    }
+    if (registered != nullptr && (protocol_msg.fields & PROTOCOL_MSG_BUNDLE)) {
+      registered->bundle = protocol_msg.bundle;
+    }
+
+    // Confirm format, client keeps parsing JSON until confirmed
+    char buffer[48];
+    snprintf(buffer, sizeof(buffer), MSG_ID_PROTOCOL "|{\"binary\":%s,\"bundle\":%s}",
+             registered != nullptr && registered->binary ? "true" : "false",
+             registered != nullptr && registered->bundle ? "true" : "false");
+    client->text(buffer);
+    rotor_ctrl.messenger.sendNewRotation();
+  }
+
+  // => Set topic bit of a subscription if given in message
+  void setTopic(uint8_t &topics, const uint8_t fields, const uint8_t field, const bool value, const uint8_t topic) {
+    if (fields & field) {
+      topics = value ? (topics | topic) : (topics & ~topic);
+    }
+  }
+
+  void receiveSubscribe(AsyncWebSocketClient* client, char* msg, char* payload, const size_t len) {
+    SocketMessages::SubscribeMsg subscribe_msg;
+    if (!SocketMessages::parse(payload, len, subscribe_msg)) {
+      parseError(MSG_ID_SUBSCRIBE);
+      return;
+    }
+    RegistryLock lock;
+    ClientState* registered = getClient(client->id());
+    if (registered == nullptr) {
+      return;
+    }
+
+    // Topics
+    const uint8_t fields = subscribe_msg.fields;
+    uint8_t &topics = registered->topics;
+    setTopic(topics, fields, SUBSCRIBE_MSG_ROTATION, subscribe_msg.rotation, TOPIC_ROTATION);
+    setTopic(topics, fields, SUBSCRIBE_MSG_SPEED, subscribe_msg.speed, TOPIC_SPEED);
+    setTopic(topics, fields, SUBSCRIBE_MSG_CALIBRATION, subscribe_msg.calibration, TOPIC_CALIBRATION);
+    setTopic(topics, fields, SUBSCRIBE_MSG_SETTINGS, subscribe_msg.settings, TOPIC_SETTINGS);
+    setTopic(topics, fields, SUBSCRIBE_MSG_FAVORITES, subscribe_msg.favorites, TOPIC_FAVORITES);
+
+    // Rate limit
+    if (fields & SUBSCRIBE_MSG_MAX_RATE) {
+      registered->min_interval_ms = subscribe_msg.max_rate > 0.0f
+                                  ? min(1000.0f / subscribe_msg.max_rate, 65535.0f) : 0;
     }
 
-    // ----- FAVORITES -----
-    // ---------------------
-    if(identifier == MSG_ID_FAVORITES) {
-      // For favorites, just save the JSON message with
-      // the identifier rejoined by inserting back '|' into msg
-      msg[sep_idx] = '|';
-      favorites.set(msg);
+    // Confirm subscription
+    char buffer[160];
+    snprintf(buffer, sizeof(buffer),
+             MSG_ID_SUBSCRIBE "|{\"rotation\":%s,\"speed\":%s,\"calibration\":%s,"
+             "\"settings\":%s,\"favorites\":%s,\"maxRate\":%.1f}",
+             topics & TOPIC_ROTATION ? "true" : "false",
+             topics & TOPIC_SPEED ? "true" : "false",
+             topics & TOPIC_CALIBRATION ? "true" : "false",
+             topics & TOPIC_SETTINGS ? "true" : "false",
+             topics & TOPIC_FAVORITES ? "true" : "false",
+             registered->min_interval_ms ? 1000.0f / registered->min_interval_ms : 0.0f);
+    client->text(buffer);
+    if (verbose) {
+      Serial.printf("[Websocket] Client %u subscribed to topics 0x%02X, min. interval %u ms.\n\r",
+                    registered->id, topics, registered->min_interval_ms);
     }
+  }
 
-    // ----- LOCK -----
-    // ----------------
-    if (identifier == MSG_ID_LOCK) {
-      // For lock, just distribute message to all clients
-      msg[sep_idx] = '|';
-      lock_msg = (String) msg;
-      websocket.textAll(msg);
+  // ----- PONG -----
+  void receivePong(AsyncWebSocketClient* client, char* msg, char* payload, const size_t len) {
+    SocketMessages::PongMsg pong_msg;
+    if (!SocketMessages::parse(payload, len, pong_msg)) {
+      parseError(MSG_ID_PONG);
+      return;
     }
+
+    // Only the answer to the last ping counts
+    RegistryLock lock;
+    ClientState* registered = getClient(client->id());
+    if (registered == nullptr || !registered->ping_us || pong_msg.id != registered->ping_id) {
+      return;
+    }
+    registered->rtt_us = rx_us - registered->ping_us;
+    registered->ping_us = 0;
+    if (!registered->n_pongs++ || registered->rtt_us < registered->min_rtt_us) {
+      registered->min_rtt_us = registered->rtt_us;
+    }
+    registered->max_rtt_us = max(registered->max_rtt_us, registered->rtt_us);
+  }
+
+  // ----- DIAG -----
+  void receiveDiag(AsyncWebSocketClient* client, char* msg, char* payload, const size_t len) {
+    RegistryLock lock;
+    ClientState* registered = getClient(client->id());
+    if (registered == nullptr) {
+      return;
+    }
+    char buffer[64];
+
+    // Command latency histogram
+    const Rotor::LatencyHistogram &latency = rotor_ctrl.command_latency;
+    // Upper bin limits, the last bin has none and is marked with -1
+    diag_buffer = MSG_ID_DIAG "|{\"latency\":{\"binsMs\":[";
+    for (uint8_t i = 0; i < LATENCY_BINS; ++i) {
+      diag_buffer += i ? "," : "";
+      diag_buffer += Rotor::LatencyHistogram::binLimitMs(i);
+    }
+    diag_buffer += "],\"counts\":[";
+    for (uint8_t i = 0; i < LATENCY_BINS; ++i) {
+      diag_buffer += i ? "," : "";
+      diag_buffer += latency.bins[i];
+    }
+    snprintf(buffer, sizeof(buffer), "],\"n\":%u,\"meanUs\":%u,\"maxUs\":%u},",
+             latency.n, latency.n ? (uint32_t) (latency.sum_us / latency.n) : 0, latency.max_us);
+    diag_buffer += buffer;
+
+    // Round trip time of this client
+    snprintf(buffer, sizeof(buffer), "\"rtt\":{\"lastUs\":%u,\"minUs\":%u,\"maxUs\":%u,",
+             registered->rtt_us, registered->min_rtt_us, registered->max_rtt_us);
+    diag_buffer += buffer;
+    snprintf(buffer, sizeof(buffer), "\"pings\":%u,\"pongs\":%u}}",
+             registered->n_pings, registered->n_pongs);
+    diag_buffer += buffer;
+    client->text(diag_buffer);
+  }
+
+  // Dispatch table, message identifier -> handler
+  typedef void (*Handler)(AsyncWebSocketClient* client, char* msg, char* payload, const size_t len);
+  struct Route {
+    const char* id;
+    size_t id_len;
+    Handler handler;
+    bool is_rotor_command;          // Handler only posts rotor commands, accepted from other transports too
+  };
+  #define ROUTE(ID, HANDLER) { ID, sizeof(ID) - 1, HANDLER, false }
+  #define COMMAND_ROUTE(ID, HANDLER) { ID, sizeof(ID) - 1, HANDLER, true }
+  const Route routes[] = {
+    COMMAND_ROUTE(MSG_ID_ROTOR, receiveRotor),
+    ROUTE(MSG_ID_CALIBRATION, receiveCalibration),
+    ROUTE(MSG_ID_SETTINGS, receiveSettings),
+    ROUTE(MSG_ID_FAVORITES, receiveFavorites),
+    ROUTE(MSG_ID_LOCK, receiveLock),
+    ROUTE(MSG_ID_PROTOCOL, receiveProtocol),
+    ROUTE(MSG_ID_SUBSCRIBE, receiveSubscribe),
+    ROUTE(MSG_ID_PONG, receivePong),
+    ROUTE(MSG_ID_DIAG, receiveDiag)
+  };
+
+
+  // ***********************
+  // Socket receive function
+  // ***********************
+
+  void socketReceive(AsyncWebSocketClient* client, char* msg, const size_t len) {
+    // Identifier and payload are separated by '|'
+    const char* sep = (const char*) memchr(msg, '|', len);
+    if (sep == nullptr || sep == msg) {
+      Serial.println("[Websocket] Error: Could not parse message.");
+      return;
+    }
+    const size_t id_len = sep - msg;
+    char* payload = msg + id_len + 1;
+
+    for (const Route &route : routes) {
+      if (route.id_len == id_len && memcmp(route.id, msg, id_len) == 0) {
+        // Other transports may only move the rotor, not change shared state
+        if (!route.is_rotor_command && client == nullptr) {
+          Serial.println("[Websocket] Error: Message identifier not accepted from this transport.");
+          return;
+        }
+        route.handler(client, msg, payload, len - id_len - 1);
+        return;
+      }
+    }
+    Serial.println("[Websocket] Error: Unknown message identifier.");
+  }
+
+  // => Handle a message received by another transport, only rotor commands are accepted
+  void receiveMessage(char* msg, const size_t len) {
+    rx_us = micros();
+    socketReceive(nullptr, msg, len);
   }
 }
@@ -12,12 +12,21 @@
 #include <Firmware.h>           // Exposes Global: firmware
 #include <RotorServer.h>        // Exposes Global: server
 #include <RotorSocket.h>        // Expose Global: websocket
+#ifdef UI_PARTITION
+#include <UiPartition.h>
+#else
 #include <AppIndex.h>
+#endif
 
 #define SCREEN_ADDRESS 0x3C
 #define SPLASHSCREEN_TIMEOUT 2000
 #define ALERT_TIMEOUT 4000
 
+#define UI_TASK_PERIOD_MS 40
+#define UI_TASK_PRIORITY 1
+#define UI_TASK_CORE 0
+#define UI_TASK_STACK_SIZE 4096
+
 extern bool just_booted;
 
 namespace Screen {
@@ -61,10 +70,29 @@ namespace Screen {
         // Setup alert messages
         alert_txt.reserve(96);
         alert_timer.changeInterval(ALERT_TIMEOUT);
+        alert_lock = xSemaphoreCreateMutex();
 
         return true;
     }
 
+    // => UI task, calls update() at a fixed rate
+    void Screen::uiTask(void *param) {
+        Screen *self = (Screen*) param;
+        TickType_t last_wake = xTaskGetTickCount();
+        for (;;) {
+            self->update();
+            vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(UI_TASK_PERIOD_MS));
+        }
+    }
+
+    // => Start UI task, which redraws the screen every 40 ms
+    void Screen::startTask() {
+        if (ui_task == nullptr) {
+            xTaskCreatePinnedToCore(uiTask, "ui", UI_TASK_STACK_SIZE, this,
+                                    UI_TASK_PRIORITY, &ui_task, UI_TASK_CORE);
+        }
+    }
+
     // => Clear screen and reset text configurations and cursor
     void Screen::clearScreen() {
         screen->clearDisplay();
@@ -136,15 +164,17 @@ namespace Screen {
 
     // => Set an alert message to be shown full screen for a few seconds
     void Screen::setAlert(const String &txt) {
+        xSemaphoreTake(alert_lock, portMAX_DELAY);
         alert_txt = txt;
         alert_timer.start();
+        xSemaphoreGive(alert_lock);
     }
 
-    // => Set an alert message and show it on  the screen immediatly
+    // => Set an alert message and show it on  the screen immediatly.
+    // Once the UI task runs, only it draws to the framebuffer and shows the alert with its next redraw.
     void Screen::setAlertImmediatly(const String &txt) {
-        if (!disabled) {
-            alert_txt = txt;
-            alert_timer.start();
+        setAlert(txt);
+        if (!disabled && ui_task == nullptr) {
             clearScreen();
             showFullscreenAlert();
             screen->display();
@@ -190,8 +220,8 @@ namespace Screen {
         }
 
         // Draw compass needle
-        compass.needle_sin = sin(rotor_ctrl.rotor.last_angle * DEG_TO_RAD);
-        compass.needle_cos = cos(rotor_ctrl.rotor.last_angle * DEG_TO_RAD);
+        compass.needle_sin = sin(rotor_state.angle * DEG_TO_RAD);
+        compass.needle_cos = cos(rotor_state.angle * DEG_TO_RAD);
         compass.needle_x1 = round(cx + compass.needle_sin * (r - 5));
         compass.needle_y1 = round(cy - compass.needle_cos * (r - 5));
         compass.needle_x2 = round(cx - compass.needle_sin * (r * 0.4f));
@@ -200,9 +230,9 @@ namespace Screen {
                          compass.needle_x1, compass.needle_y1, color);
 
         // Draw compass target indicator
-        if (rotor_ctrl.is_auto_rotating) {
-            compass.target_sin = sin(rotor_ctrl.auto_rotation_target * DEG_TO_RAD);
-            compass.target_cos = cos(rotor_ctrl.auto_rotation_target * DEG_TO_RAD);
+        if (rotor_state.is_auto_rotating) {
+            compass.target_sin = sin(rotor_state.target * DEG_TO_RAD);
+            compass.target_cos = cos(rotor_state.target * DEG_TO_RAD);
             compass.target_x1 = round(cx + compass.target_sin * (r - 4));
             compass.target_y1 = round(cy - compass.target_cos * (r - 4));
             compass.target_x2 = round(cx + compass.target_sin * (r * 0.5f));
@@ -217,7 +247,7 @@ namespace Screen {
         screen->fillCircle(cx, cy, 2, color);
 
         // Overlap Indicator
-        if (rotor_ctrl.rotor.last_angle > 360.0f) {
+        if (rotor_state.angle > 360.0f) {
             screen->fillCircle(cx + r - 3, cy - r + 3, 2, color);
         }
 
@@ -235,8 +265,8 @@ namespace Screen {
         screen->setTextColor(BLACK);
         
         // Rotation indicators
-        if (rotor_ctrl.is_rotating) {
-            if (rotor_ctrl.direction) {
+        if (rotor_state.is_rotating) {
+            if (rotor_state.direction) {
                 screen->drawBitmap(110, 2, rotate_right_icon, 16, 16, BLACK);
             } else {
                 screen->drawBitmap(110, 2, rotate_left_icon, 16, 16, BLACK);
@@ -246,13 +276,13 @@ namespace Screen {
         }
 
         // Overlap indicator
-        if (rotor_ctrl.rotor.last_angle > 360.0f) {
+        if (rotor_state.angle > 360.0f) {
             screen->setCursor(113, 27);
             screen->print("OL");
         }
 
         // Auto rotation indicator
-        if (rotor_ctrl.is_auto_rotating) {
+        if (rotor_state.is_auto_rotating) {
             screen->setCursor(113, 40);
             screen->print("AR");
         }
@@ -365,7 +395,11 @@ namespace Screen {
         screen->printf("Firmware: %s\n", version.c_str());
 
         moveCursor(0, gap);
+        #ifdef UI_PARTITION
+        screen->printf("UI Version: %s\n", UiPartition::getVersion());
+        #else
         screen->printf("UI Version: %s\n", UI_VERSION);
+        #endif
     }
 
     // => Set screen showing angle only
@@ -377,14 +411,14 @@ namespace Screen {
 
         // Angle
         screen->setCursor(16, SCREEN_HEIGHT / 4 - (CHAR_H * 3 / 2));
-        screen->printf("%3.0f", round(rotor_ctrl.rotor.last_angle));
+        screen->printf("%3.0f", round(rotor_state.angle));
         moveCursor(1, 0);
         printDegree();
 
         // Target
         screen->setCursor(16, SCREEN_HEIGHT / 4 * 3 - (CHAR_H * 3 / 2));
-        if (rotor_ctrl.is_auto_rotating) {
-            screen->printf("%3.0f", round(rotor_ctrl.auto_rotation_target));
+        if (rotor_state.is_auto_rotating) {
+            screen->printf("%3.0f", round(rotor_state.target));
             moveCursor(1, 0);
             printDegree();
         } else {
@@ -407,7 +441,7 @@ namespace Screen {
         // Angle
         ly += gap;
         screen->setCursor(0, ly);
-        screen->printf("%3.0f", round(rotor_ctrl.rotor.last_angle));
+        screen->printf("%3.0f", round(rotor_state.angle));
         moveCursor(1, 0);
         printDegree();
         
@@ -418,7 +452,7 @@ namespace Screen {
         // Volts
         ly += 1 + gap;
         screen->setCursor(0, ly);
-        screen->printf("%4.2f V", rotor_ctrl.rotor.last_adc_volts * rotor_ctrl.rotor.calibration.volt_div_factor);
+        screen->printf("%4.2f V", rotor_state.adc_volts * rotor_ctrl.rotor.calibration.volt_div_factor);
 
         // ---
         ly += CHAR_H + gap;
@@ -427,8 +461,8 @@ namespace Screen {
         // Target
         ly += 1 + gap;
         screen->setCursor(0, ly);
-        if (rotor_ctrl.is_auto_rotating) {
-            screen->printf("T %3.0f", round(rotor_ctrl.auto_rotation_target));
+        if (rotor_state.is_auto_rotating) {
+            screen->printf("T %3.0f", round(rotor_state.target));
             printDegree();
         } else {
             screen->print("T ---");
@@ -442,11 +476,11 @@ namespace Screen {
         ly += 1 + gap;
         screen->setCursor(0, ly);
         if (true) {
-            uint8_t display_speed = rotor_ctrl.smooth_speed_active ? rotor_ctrl.current_speed : rotor_ctrl.max_speed;
+            uint8_t display_speed = rotor_state.smooth_speed_active ? rotor_state.current_speed : rotor_state.max_speed;
             screen->printf("S %3d%%", display_speed ? display_speed : 1);
         } else {
             // Angular Speed
-            screen->printf("R %5.2f/s", rotor_ctrl.angular_speed);
+            screen->printf("R %5.2f/s", rotor_state.angular_speed);
         }
     }
 
@@ -502,15 +536,21 @@ namespace Screen {
         clearScreen();
 
         // Alert message, full screen, until timed out
+        xSemaphoreTake(alert_lock, portMAX_DELAY);
         if (alert_txt != "" && !firmware.is_updating) {
             if (alert_timer.passed()) {
                 alert_txt = "";
             } else {
                 showFullscreenAlert();
                 screen->display();
+                xSemaphoreGive(alert_lock);
                 return;
             }
         }
+        xSemaphoreGive(alert_lock);
+
+        // Read rotor state once for this redraw
+        rotor_state = rotor_ctrl.getSnapshot();
 
         // ----------
 
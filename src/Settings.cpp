@@ -1,61 +1,79 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
+#include <atomic>
 
 #include <Settings.h>
 #include <globals.h>
 #include <WiFiFunctions.h>
 #include <RotorSocket.h>
 
-#define SETTINGS_BUFFER_SIZE 256
-
 namespace Settings {
-    String settings_buffer;
+    // Dirty fields and send requests since last flush
+    std::atomic<uint8_t> dirty{0};
+    std::atomic<uint32_t> n_requests{0};
 
-    // => Reserve message buffer
-    void initBuffer() {
-        settings_buffer.reserve(SETTINGS_BUFFER_SIZE);
-    }
+    // => Append general settings to a connect snapshot, one line per message
+    void appendSettings(String &buffer) {
+        // Settings that don't change while running, serialized on first connect
+        static String fixed_settings;
+        if (!fixed_settings.length()) {
+            fixed_settings = MSG_ID_SETTINGS;
+            fixed_settings += "|";
 
-    // => Send general settings to clients
-    void sendSettings() {
-        settings_buffer = MSG_ID_SETTINGS;
-        settings_buffer += "|"; 
+            StaticJsonDocument<224> doc;
+            doc["version"] = version;
+            doc["espID"] = esp_id;
+            doc["ssid"] = WiFiFunctions::wifi_config.ssid;
+            doc["hasScreen"] = has_screen;
+            doc["md5"] = ESP.getSketchMD5();
+            serializeJson(doc, fixed_settings);
+        }
+        buffer += fixed_settings;
+        buffer += "\n";
 
-        StaticJsonDocument<256> doc;
-        doc["version"] = version;
-        doc["espID"] = esp_id;
-        doc["ssid"] = WiFiFunctions::wifi_config.ssid;
+        // Changing settings
+        buffer += MSG_ID_SETTINGS;
+        buffer += "|";
+        StaticJsonDocument<64> doc;
         doc["rssi"] = (String)WiFi.RSSI();
-        doc["hasScreen"] = has_screen;
         doc["useScreen"] = use_screen;
-        doc["md5"] = ESP.getSketchMD5();
         doc["bootMinutes"] = floor(millis() / 60000);
-
-        serializeJson(doc, settings_buffer);
-        websocket.textAll(settings_buffer);
+        serializeJson(doc, buffer);
     }
 
-    // => Send screen setting to clients
+    // => Send screen setting to clients with the next flush
     void sendScreen() {
-        settings_buffer = MSG_ID_SETTINGS;
-        settings_buffer += "|"; 
-
-        StaticJsonDocument<16> doc;
-        doc["useScreen"] = use_screen;
-
-        serializeJson(doc, settings_buffer);
-        websocket.textAll(settings_buffer); 
+        dirty.fetch_or(SETTINGS_FIELD_SCREEN);
+        n_requests++;
     }
 
-    // => Send on-time to clients
+    // => Send on-time to clients with the next flush
     void sendBootTime() {
-        settings_buffer = MSG_ID_SETTINGS;
-        settings_buffer += "|"; 
+        dirty.fetch_or(SETTINGS_FIELD_BOOT_TIME);
+        n_requests++;
+    }
 
-        StaticJsonDocument<48> doc;
-        doc["bootMinutes"] = floor(millis() / 60000);
+    // => Append changed settings as one message to buffer
+    uint32_t appendChanges(String &buffer) {
+        const uint8_t fields = dirty.exchange(0);
+        if (!fields) {
+            return 0;
+        }
 
-        serializeJson(doc, settings_buffer);
-        websocket.textAll(settings_buffer); 
+        if (buffer.length()) {
+            buffer += "\n";
+        }
+        buffer += MSG_ID_SETTINGS;
+        buffer += "|";
+
+        StaticJsonDocument<48> doc;
+        if (fields & SETTINGS_FIELD_SCREEN) {
+            doc["useScreen"] = use_screen;
+        }
+        if (fields & SETTINGS_FIELD_BOOT_TIME) {
+            doc["bootMinutes"] = floor(millis() / 60000);
+        }
+        serializeJson(doc, buffer);
+        return n_requests.exchange(0);
     }
 }
@@ -52,6 +52,22 @@ bool writeToFS(const char* path, const String &data) {
   }
 }
 
+// => Append bytes to a file from FS, creates the file if missing
+bool appendToFS(const char* path, const uint8_t* data, const size_t len) {
+  File file = LittleFS.open(path, FILE_APPEND);
+  if (!file || file.isDirectory()) {
+    Serial.println("[FS] Failed to open " + (String)path + " for appending.");
+    return false;
+  }
+
+  const bool success = file.write(data, len) == len;
+  file.close();
+  if (!success) {
+    Serial.println("[FS] Appending to " + (String)path + " failed.");
+  }
+  return success;
+}
+
 // => Remove file from FS
 bool removeFromFS(const char* path) {
   if (LittleFS.remove(path)) {
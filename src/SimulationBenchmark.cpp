@@ -0,0 +1,138 @@
+#include <Arduino.h>
+
+#include <globals.h>
+#include <SimulationBenchmark.h>
+#include <ControlTask.h>
+#include <RotorController.h>    // Exposes Global: rotor_ctrl
+#include <RotorSimulator.h>     // Exposes Global: rotor_sim
+
+#define BENCHMARK_TASK_PRIORITY 1
+#define BENCHMARK_TASK_CORE 0
+#define BENCHMARK_STACK_SIZE 4096
+#define BENCHMARK_POLL_MS 10
+// Give up on a scenario after this time, in ms
+#define BENCHMARK_SCENARIO_TIMEOUT 180000UL
+// Pause between scenarios, in ms
+#define BENCHMARK_PAUSE_MS 300
+
+
+namespace SimulationBenchmark {
+
+    // Results accumulated over all scenarios
+    struct {
+        uint32_t n_scenarios = 0;
+        uint32_t n_completed = 0;
+        uint32_t n_aborted = 0;
+        uint32_t n_timed_out = 0;
+        float sum_abs_error = 0.0f;         // True final angle - target, in °
+        float max_abs_error = 0.0f;
+        float sum_overshoot = 0.0f;         // Travel beyond the target, in °
+        float max_overshoot = 0.0f;
+        unsigned long sum_time_ms = 0;      // Command posted to rotor settled
+        unsigned long max_time_ms = 0;
+    } results;
+
+    TaskHandle_t benchmark_task = nullptr;
+
+    // => Print results to Serial
+    void printResults() {
+        const uint32_t n = max(results.n_completed, (uint32_t) 1);
+        Serial.printf("[Benchmark] Scenarios: %u | Completed: %u | Aborted: %u | Timed out: %u\n\r",
+                      results.n_scenarios, results.n_completed, results.n_aborted, results.n_timed_out);
+        Serial.printf("[Benchmark] Time to target (mean/max): %lu / %lu ms\n\r",
+                      results.sum_time_ms / n, results.max_time_ms);
+        Serial.printf("[Benchmark] Overshoot (mean/max): %.2f / %.2f°\n\r",
+                      results.sum_overshoot / n, results.max_overshoot);
+        Serial.printf("[Benchmark] Final error (mean/max): %.2f / %.2f°\n\r",
+                      results.sum_abs_error / n, results.max_abs_error);
+        const uint32_t n_ticks = max(ControlTask::stats.n_ticks, (uint32_t) 1);
+        Serial.printf("[Benchmark] Control tick time (mean/worst): %llu / %u us\n\r",
+                      ControlTask::stats.sum_tick_us / n_ticks, ControlTask::stats.worst_tick_us);
+    }
+
+    // => Run a single randomized auto-rotation and wait until the rotor settled
+    void runScenario() {
+        // Targets closer than the minimum auto-rotation distance would be denied
+        float target;
+        do {
+            target = random(0, 4490) / 10.0f;
+        } while (abs(target - rotor_sim.angle) < 5.0f);
+        const uint8_t speed = random(20, 101);
+        const bool use_smooth_speed = random(2);
+        const uint32_t completed_prev = rotor_ctrl.auto_rot_stats.n_completed;
+        const uint32_t aborted_prev = rotor_ctrl.auto_rot_stats.n_aborted;
+        const int8_t dir = (target > rotor_sim.angle) ? 1 : -1;
+
+        rotor_ctrl.post(Rotor::Command::setSpeed(speed));
+        rotor_ctrl.post(Rotor::Command::rotateTo(target, false, use_smooth_speed));
+
+        // Track how far the true rotor angle travels beyond the target
+        const unsigned long start_ms = millis();
+        float overshoot = 0.0f;
+        results.n_scenarios++;
+        for (;;) {
+            vTaskDelay(pdMS_TO_TICKS(BENCHMARK_POLL_MS));
+            overshoot = max(overshoot, dir * (rotor_sim.angle - target));
+
+            if (rotor_ctrl.auto_rot_stats.n_completed != completed_prev) {
+                break;
+            }
+            if (rotor_ctrl.auto_rot_stats.n_aborted != aborted_prev) {
+                results.n_aborted++;
+                return;
+            }
+            if (millis() - start_ms > BENCHMARK_SCENARIO_TIMEOUT) {
+                rotor_ctrl.post(Rotor::Command::stop());
+                results.n_timed_out++;
+                return;
+            }
+        }
+
+        const unsigned long time_ms = millis() - start_ms;
+        const float abs_error = abs(rotor_sim.angle - target);
+        results.n_completed++;
+        results.sum_time_ms += time_ms;
+        results.max_time_ms = max(results.max_time_ms, time_ms);
+        results.sum_overshoot += overshoot;
+        results.max_overshoot = max(results.max_overshoot, overshoot);
+        results.sum_abs_error += abs_error;
+        results.max_abs_error = max(results.max_abs_error, abs_error);
+
+        if (verbose) {
+            Serial.printf("[Benchmark] #%u: %.1f° at %d%%%s | %lu ms | Overshoot: %.2f° | Error: %.2f°\n\r",
+                          results.n_scenarios, target, speed, use_smooth_speed ? " smooth" : "",
+                          time_ms, overshoot, abs_error);
+        }
+    }
+
+    // => Benchmark task, runs all scenarios, prints results and deletes itself
+    void benchmarkTask(void *param) {
+        const uint32_t n_scenarios = (uint32_t) param;
+
+        // Let rotor and estimator settle after boot
+        vTaskDelay(pdMS_TO_TICKS(2000));
+        Serial.printf("[Benchmark] Running %u scenarios...\n\r", n_scenarios);
+
+        for (uint32_t i = 0; i < n_scenarios; ++i) {
+            runScenario();
+            vTaskDelay(pdMS_TO_TICKS(BENCHMARK_PAUSE_MS));
+            if ((i + 1) % 50 == 0) {
+                printResults();
+            }
+        }
+
+        Serial.println("[Benchmark] Finished.");
+        printResults();
+        rotor_ctrl.printAutoRotationStats();
+        benchmark_task = nullptr;
+        vTaskDelete(nullptr);
+    }
+
+    // => Start benchmark task running given number of scenarios, pinned to core 0
+    void start(const uint32_t n_scenarios) {
+        if (benchmark_task == nullptr) {
+            xTaskCreatePinnedToCore(benchmarkTask, "sim_bench", BENCHMARK_STACK_SIZE, (void *) n_scenarios,
+                                    BENCHMARK_TASK_PRIORITY, &benchmark_task, BENCHMARK_TASK_CORE);
+        }
+    }
+}
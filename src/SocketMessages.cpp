@@ -0,0 +1,143 @@
+#include <Arduino.h>
+
+#include <FlatJson.h>
+#include <SocketMessages.h>
+
+
+namespace SocketMessages {
+
+    // => Parse rotor message
+    bool parse(const char* json, const size_t len, RotorMsg &msg) {
+        FlatJson::Reader reader(json, len);
+        FlatJson::Pair pair;
+        while (reader.next(pair)) {
+            if (pair.type == FlatJson::Type::NUL) {
+                continue;
+            }
+            if (pair.is("rotation")) {
+                msg.rotation = pair.toInt();
+                msg.fields |= ROTOR_MSG_ROTATION;
+            } else if (pair.is("speed")) {
+                msg.speed = pair.toInt();
+                msg.fields |= ROTOR_MSG_SPEED;
+            } else if (pair.is("target")) {
+                msg.target = pair.toFloat();
+                msg.fields |= ROTOR_MSG_TARGET;
+            } else if (pair.is("useOverlap")) {
+                msg.use_overlap = pair.toBool();
+                msg.fields |= ROTOR_MSG_OVERLAP;
+            } else if (pair.is("useSmoothSpeed")) {
+                msg.use_smooth_speed = pair.toBool();
+                msg.fields |= ROTOR_MSG_SMOOTH_SPEED;
+            } else if (pair.is("seq")) {
+                msg.seq = pair.toUint();
+                msg.fields |= ROTOR_MSG_SEQ;
+            }
+        }
+        return !reader.failed();
+    }
+
+    // => Parse calibration message
+    bool parse(const char* json, const size_t len, CalibrationMsg &msg) {
+        FlatJson::Reader reader(json, len);
+        FlatJson::Pair pair;
+        while (reader.next(pair)) {
+            if (pair.type == FlatJson::Type::NUL) {
+                continue;
+            }
+            if (pair.is("u1")) {
+                msg.u1 = pair.toFloat();
+                msg.fields |= CALIBRATION_MSG_U1;
+            } else if (pair.is("u2")) {
+                msg.u2 = pair.toFloat();
+                msg.fields |= CALIBRATION_MSG_U2;
+            } else if (pair.is("a1")) {
+                msg.a1 = pair.toFloat();
+                msg.fields |= CALIBRATION_MSG_A1;
+            } else if (pair.is("a2")) {
+                msg.a2 = pair.toFloat();
+                msg.fields |= CALIBRATION_MSG_A2;
+            } else if (pair.is("offset")) {
+                msg.offset = pair.toFloat();
+                msg.fields |= CALIBRATION_MSG_OFFSET;
+            } else if (pair.is("seq")) {
+                msg.seq = pair.toUint();
+                msg.fields |= CALIBRATION_MSG_SEQ;
+            }
+        }
+        return !reader.failed();
+    }
+
+    // => Parse settings message
+    bool parse(const char* json, const size_t len, SettingsMsg &msg) {
+        FlatJson::Reader reader(json, len);
+        FlatJson::Pair pair;
+        while (reader.next(pair)) {
+            if (pair.type != FlatJson::Type::NUL && pair.is("useScreen")) {
+                msg.use_screen = pair.toBool();
+                msg.fields |= SETTINGS_MSG_USE_SCREEN;
+            }
+        }
+        return !reader.failed();
+    }
+
+    // => Parse protocol message
+    bool parse(const char* json, const size_t len, ProtocolMsg &msg) {
+        FlatJson::Reader reader(json, len);
+        FlatJson::Pair pair;
+        while (reader.next(pair)) {
+            if (pair.type != FlatJson::Type::NUL && pair.is("binary")) {
+                msg.binary = pair.toBool();
+                msg.fields |= PROTOCOL_MSG_BINARY;
+            } else if (pair.type != FlatJson::Type::NUL && pair.is("bundle")) {
+                msg.bundle = pair.toBool();
+                msg.fields |= PROTOCOL_MSG_BUNDLE;
+            }
+        }
+        return !reader.failed();
+    }
+
+    // => Parse subscribe message
+    bool parse(const char* json, const size_t len, SubscribeMsg &msg) {
+        FlatJson::Reader reader(json, len);
+        FlatJson::Pair pair;
+        while (reader.next(pair)) {
+            if (pair.type == FlatJson::Type::NUL) {
+                continue;
+            }
+            if (pair.is("rotation")) {
+                msg.rotation = pair.toBool();
+                msg.fields |= SUBSCRIBE_MSG_ROTATION;
+            } else if (pair.is("speed")) {
+                msg.speed = pair.toBool();
+                msg.fields |= SUBSCRIBE_MSG_SPEED;
+            } else if (pair.is("calibration")) {
+                msg.calibration = pair.toBool();
+                msg.fields |= SUBSCRIBE_MSG_CALIBRATION;
+            } else if (pair.is("settings")) {
+                msg.settings = pair.toBool();
+                msg.fields |= SUBSCRIBE_MSG_SETTINGS;
+            } else if (pair.is("favorites")) {
+                msg.favorites = pair.toBool();
+                msg.fields |= SUBSCRIBE_MSG_FAVORITES;
+            } else if (pair.is("maxRate")) {
+                msg.max_rate = pair.toFloat();
+                msg.fields |= SUBSCRIBE_MSG_MAX_RATE;
+            }
+        }
+        return !reader.failed();
+    }
+
+    // => Parse pong message
+    bool parse(const char* json, const size_t len, PongMsg &msg) {
+        FlatJson::Reader reader(json, len);
+        FlatJson::Pair pair;
+        while (reader.next(pair)) {
+            if (pair.type != FlatJson::Type::NUL && pair.is("id")) {
+                msg.id = pair.toUint();
+                msg.fields |= PONG_MSG_ID;
+            }
+        }
+        return !reader.failed();
+    }
+}
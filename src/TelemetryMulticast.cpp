@@ -0,0 +1,162 @@
+#include <Arduino.h>
+#include <AsyncUDP.h>
+#include <Preferences.h>
+#include <math.h>
+#include <atomic>
+
+#include <globals.h>
+#include <RotorController.h>
+#include <RotationHistory.h>    // State bits
+#include <TelemetryMulticast.h>
+
+#define MULTICAST_PREFS_KEY "mcastPrefs"
+#define MULTICAST_MAX_RATE_HZ 50
+
+
+namespace Multicast {
+  // In use by the stream, only changed by the loop
+  Config config;
+
+  // Set by the web server, applied by the loop. Both configs are guarded by config_lock.
+  Config pending_config;
+  std::atomic<bool> has_pending_config{false};
+  SemaphoreHandle_t config_lock = nullptr;
+
+  AsyncUDP udp;
+  Preferences prefs;
+  IPAddress group;
+  bool is_valid = false;            // Group is a multicast address and rate isn't 0
+  unsigned long interval_ms = 0;    // Interval during motion
+
+  Frame frame;
+  unsigned long last_send_ms = 0;
+
+  // Counters since boot
+  struct {
+    uint32_t n_sent = 0;
+    uint32_t n_failed = 0;
+  } stats;
+
+  // => Parse the group of a config, false if it is no multicast address
+  bool parseGroup(const Config &config, IPAddress &address) {
+    return address.fromString(config.group) && address[0] >= 224 && address[0] <= 239;
+  }
+
+  // => Check a config, a rate of 0 disables the stream
+  bool isValid(const Config &config) {
+    IPAddress address;
+    return parseGroup(config, address) && config.port > 0 && config.rate_hz <= MULTICAST_MAX_RATE_HZ;
+  }
+
+  // => Check and apply the config
+  bool applyConfig() {
+    IPAddress address;
+    is_valid = parseGroup(config, address) && config.port > 0
+            && config.rate_hz > 0 && config.rate_hz <= MULTICAST_MAX_RATE_HZ;
+    if (is_valid) {
+      group = address;
+      interval_ms = 1000 / config.rate_hz;
+    }
+    return is_valid || config.rate_hz == 0;
+  }
+
+  // => Load config from Preferences
+  void init() {
+    config_lock = xSemaphoreCreateMutex();
+    if (!prefs.begin(MULTICAST_PREFS_KEY, true) && verbose) {
+      Serial.println("[Multicast] Could not load configuration! Use default configuration instead.");
+    }
+    // Keys not stored keep the default
+    prefs.getString("group", config.group, sizeof(config.group));
+    config.port = prefs.getUShort("port", MULTICAST_PORT);
+    config.rate_hz = prefs.getUChar("rate", MULTICAST_RATE_HZ);
+    prefs.end();
+
+    if (!applyConfig()) {
+      Serial.println("[Multicast] Error: Invalid configuration, telemetry stream disabled.");
+    } else if (is_valid && verbose) {
+      Serial.printf("[Multicast] Sending telemetry to %s:%u at %u Hz\n\r",
+                    config.group, config.port, config.rate_hz);
+    }
+  }
+
+  // => Copy of the config, including one set but not yet applied
+  Config getConfig() {
+    if (config_lock == nullptr) {
+      return config;
+    }
+    xSemaphoreTake(config_lock, portMAX_DELAY);
+    const Config copy = has_pending_config ? pending_config : config;
+    xSemaphoreGive(config_lock);
+    return copy;
+  }
+
+  // => Check a config and hand it to the loop
+  bool setConfig(const Config &new_config) {
+    if (config_lock == nullptr || !isValid(new_config)) {
+      return false;
+    }
+    xSemaphoreTake(config_lock, portMAX_DELAY);
+    pending_config = new_config;
+    has_pending_config = true;
+    xSemaphoreGive(config_lock);
+    return true;
+  }
+
+  // => Take over a config set by the web server, apply it and save it in Preferences
+  void applyPendingConfig() {
+    xSemaphoreTake(config_lock, portMAX_DELAY);
+    config = pending_config;
+    has_pending_config = false;
+    xSemaphoreGive(config_lock);
+    applyConfig();
+
+    if (!prefs.begin(MULTICAST_PREFS_KEY, false)) {
+      Serial.println("[Multicast] Error: Could not save configuration!");
+      return;
+    }
+    prefs.putString("group", config.group);
+    prefs.putUShort("port", config.port);
+    prefs.putUChar("rate", config.rate_hz);
+    prefs.end();
+  }
+
+  // => Send a sample if one is due
+  void update(const Rotor::Snapshot &state) {
+    if (has_pending_config) {
+      applyPendingConfig();
+    }
+    if (!is_valid) {
+      return;
+    }
+    const unsigned long now = millis();
+    const bool is_moving = state.is_rotating || state.angular_speed != 0.0f;
+    if (now - last_send_ms < (is_moving ? interval_ms : MULTICAST_IDLE_INTERVAL_MS)) {
+      return;
+    }
+    last_send_ms = now;
+
+    frame.seq++;
+    frame.state = (state.is_rotating ? HISTORY_ROTATING : 0)
+                | (state.direction ? HISTORY_CW : 0)
+                | (state.is_auto_rotating ? HISTORY_AUTO : 0);
+    frame.t = state.ms;
+    frame.angle = (int32_t) round(state.angle * 100.0f);
+    frame.v = (int16_t) constrain(round(state.angular_speed * 100.0f), -32768.0f, 32767.0f);
+    frame.target = (int32_t) round(state.target * 100.0f);
+    frame.speed = state.current_speed;
+
+    // One send, regardless of the number of listeners
+    if (udp.writeTo((const uint8_t*) &frame, sizeof(frame), group, config.port) == sizeof(frame)) {
+      stats.n_sent++;
+    } else {
+      stats.n_failed++;
+    }
+  }
+
+  // => Print send counters to Serial
+  void printStats() {
+    Serial.printf("[Multicast] %s | Sent: %u | Failed: %u\n\r",
+                  is_valid ? "Active" : "Disabled", stats.n_sent, stats.n_failed);
+  }
+}
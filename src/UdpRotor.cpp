@@ -0,0 +1,165 @@
+#include <Arduino.h>
+#include <AsyncUDP.h>
+#include <math.h>
+
+#include <globals.h>
+#include <RotorController.h>    // Exposes Global: rotor_ctrl
+#include <UdpRotor.h>
+
+#define UDP_ROTOR_MAX_DATAGRAM 256
+#define UDP_ROTOR_VALUE_SIZE 32
+#define UDP_ROTOR_RESPONSE_SIZE 96
+
+
+namespace UdpRotor {
+
+  AsyncUDP udp;
+
+  // Counters since boot
+  struct {
+    uint32_t n_datagrams = 0;
+    uint32_t n_commands = 0;
+    uint32_t n_errors = 0;          // Unknown or malformed datagrams
+  } stats;
+
+  // => Copy the text between <tag> and </tag> to value, false if the tag is missing.
+  // Tags are matched case-sensitive, data doesn't have to be null-terminated.
+  bool findTag(const char* data, const size_t len, const char* tag, char* value, const size_t size) {
+    char open[24];
+    char close[24];
+    const int open_len = snprintf(open, sizeof(open), "<%s>", tag);
+    const int close_len = snprintf(close, sizeof(close), "</%s>", tag);
+
+    const char* end = data + len;
+    const char* start = (const char*) memmem(data, len, open, open_len);
+    if (start == nullptr) {
+      return false;
+    }
+    start += open_len;
+    const char* stop = (const char*) memmem(start, end - start, close, close_len);
+    if (stop == nullptr || (size_t) (stop - start) >= size) {
+      return false;
+    }
+    memcpy(value, start, stop - start);
+    value[stop - start] = '\0';
+    return true;
+  }
+
+  // => Parse an azimuth in 0° to 360°, NAN if invalid
+  float parseAzimuth(const char* value) {
+    char* end;
+    const float azimuth = strtof(value, &end);
+    if (end == value || azimuth < 0.0f || azimuth > 360.0f) {
+      return NAN;
+    }
+    return azimuth;
+  }
+
+  // => Hand a command on, stamped with the time it was received
+  void post(Rotor::Command cmd, const uint32_t rx_us, Rotor::PostCommand post_cmd) {
+    cmd.rx_us = rx_us;
+    stats.n_commands++;
+    post_cmd(cmd);
+  }
+
+  // => Hand on a turn to the azimuth, with the overlap and speed settings of the rotor
+  void postRotateTo(const float azimuth, const uint32_t rx_us, Rotor::PostCommand post_cmd) {
+    post(Rotor::Command::rotateTo(azimuth, rotor_ctrl.settings.use_overlap,
+                                  rotor_ctrl.settings.use_smooth_speed), rx_us, post_cmd);
+  }
+
+  // => Azimuth of the last published rotor state, in 0° to 360°
+  float getAzimuth() {
+    float azimuth = fmod(rotor_ctrl.getSnapshot().angle, 360.0f);
+    return azimuth < 0.0f ? azimuth + 360.0f : azimuth;
+  }
+
+  // => Handle an N1MM datagram, writes the position response
+  bool handleN1MM(const char* data, const size_t len, const uint32_t rx_us, Rotor::PostCommand post_cmd,
+                  char* response, const size_t size) {
+    char rotor[UDP_ROTOR_VALUE_SIZE] = "";
+    char value[UDP_ROTOR_VALUE_SIZE];
+
+    if (findTag(data, len, "stop", rotor, sizeof(rotor))) {
+      post(Rotor::Command::stop(), rx_us, post_cmd);
+    } else if (findTag(data, len, "goazi", value, sizeof(value))) {
+      const float azimuth = parseAzimuth(value);
+      if (isnan(azimuth)) {
+        return false;
+      }
+      findTag(data, len, "rotor", rotor, sizeof(rotor));
+      postRotateTo(azimuth, rx_us, post_cmd);
+    } else {
+      return false;
+    }
+    snprintf(response, size, "<N1MMRotor><rotor>%s</rotor><azimuth>%.1f</azimuth></N1MMRotor>",
+             rotor, getAzimuth());
+    return true;
+  }
+
+  // => Handle a PstRotator datagram, writes the position response
+  bool handlePst(const char* data, const size_t len, const uint32_t rx_us, Rotor::PostCommand post_cmd,
+                 char* response, const size_t size) {
+    char value[UDP_ROTOR_VALUE_SIZE];
+
+    if (findTag(data, len, "STOP", value, sizeof(value))) {
+      post(Rotor::Command::stop(), rx_us, post_cmd);
+    } else if (findTag(data, len, "AZIMUTH", value, sizeof(value))) {
+      const float azimuth = parseAzimuth(value);
+      if (isnan(azimuth)) {
+        return false;
+      }
+      postRotateTo(azimuth, rx_us, post_cmd);
+    } else if (memmem(data, len, "AZ?", 3) == nullptr) {
+      return false;
+    }
+    snprintf(response, size, "AZ:%03d\r", (int) lround(getAzimuth()) % 360);
+    return true;
+  }
+
+  // => Handle a datagram, writes the position response
+  bool handleDatagram(const char* data, size_t len, const uint32_t rx_us, Rotor::PostCommand post_cmd,
+                      char* response, const size_t size) {
+    stats.n_datagrams++;
+    len = min(len, (size_t) UDP_ROTOR_MAX_DATAGRAM);
+    bool ok = false;
+    if (memmem(data, len, "<N1MMRotor>", 11) != nullptr) {
+      ok = handleN1MM(data, len, rx_us, post_cmd, response, size);
+    } else if (memmem(data, len, "<PST>", 5) != nullptr) {
+      ok = handlePst(data, len, rx_us, post_cmd, response, size);
+    }
+    if (!ok) {
+      stats.n_errors++;
+    }
+    return ok;
+  }
+
+  // => Handle a datagram, runs on the UDP task
+  void onPacket(AsyncUDPPacket &packet) {
+    const uint32_t rx_us = micros();
+    char response[UDP_ROTOR_RESPONSE_SIZE];
+    if (handleDatagram((const char*) packet.data(), packet.length(), rx_us, Rotor::postToControl,
+                       response, sizeof(response))) {
+      packet.write((const uint8_t*) response, strlen(response));
+    }
+  }
+
+  // => Start listening on UDP_ROTOR_PORT
+  void init() {
+    if (!udp.listen(UDP_ROTOR_PORT)) {
+      Serial.println("[UDP] Error: Could not listen for rotor commands.");
+      return;
+    }
+    udp.onPacket(onPacket);
+    if (verbose) {
+      Serial.print("[UDP] Listening for N1MM / PstRotator commands on port ");
+      Serial.println(UDP_ROTOR_PORT);
+    }
+  }
+
+  // => Print datagram counters to Serial
+  void printStats() {
+    Serial.printf("[UDP] Datagrams: %u | Commands: %u | Errors: %u\n\r",
+                  stats.n_datagrams, stats.n_commands, stats.n_errors);
+  }
+}
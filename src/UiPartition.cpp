@@ -0,0 +1,317 @@
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <MD5Builder.h>
+#include <esp_partition.h>
+#include <esp_rom_crc.h>
+
+#include <globals.h>
+#include <RotorServer.h>        // Exposes Global: rotor_server
+#include <UiPartition.h>
+
+#define UI_SECTOR_SIZE 4096
+
+
+namespace UiPartition {
+
+  const esp_partition_t* partition = nullptr;
+  const uint8_t* mapped = nullptr;          // Whole partition
+  spi_flash_mmap_handle_t mmap_handle;
+  size_t slot_size = 0;                     // Half of the partition, sector aligned
+
+  int8_t active_slot = -1;                  // Slot of the valid archive, -1 if none
+  const UiArchiveHeader* header = nullptr;  // Valid archive, else nullptr
+  const UiArchiveEntry* entries = nullptr;
+
+  // Asset responses still sending from each slot, the slot must not be erased meanwhile
+  uint8_t n_in_flight[UI_SLOTS] = {};
+
+  // Running upload, into the slot that is not active
+  struct {
+    bool is_active = false;
+    AsyncWebServerRequest* request = nullptr; // Request of the running upload, others are refused
+    const char* error = nullptr;            // First error, nullptr if none
+    uint8_t slot = 0;
+    size_t erased_end = 0;                  // Sectors erased so far, from the slot start
+    size_t written = 0;
+    UiArchiveHeader header;                 // Written last, so an incomplete archive is never valid
+    MD5Builder md5;
+    String expected_md5;
+  } upload;
+
+  // => Mapped start of a slot
+  const uint8_t* slotData(const uint8_t slot) {
+    return mapped + slot * slot_size;
+  }
+
+  // => Check the archive in a slot, returns its header if it is valid, else nullptr
+  const UiArchiveHeader* validate(const uint8_t slot) {
+    if (mapped == nullptr) {
+      return nullptr;
+    }
+
+    const uint8_t* base = slotData(slot);
+    const UiArchiveHeader* candidate = (const UiArchiveHeader*) base;
+    const size_t index_end = sizeof(UiArchiveHeader) + candidate->n_entries * sizeof(UiArchiveEntry);
+    if (candidate->magic != UI_ARCHIVE_MAGIC || candidate->version != UI_ARCHIVE_VERSION
+        || candidate->size > slot_size || index_end > candidate->size) {
+      return nullptr;
+    }
+    const uint32_t crc = esp_rom_crc32_le(0, base + sizeof(UiArchiveHeader),
+                                          candidate->size - sizeof(UiArchiveHeader));
+    if (crc != candidate->crc32) {
+      Serial.printf("[UI] Error: Archive checksum mismatch in slot %u.\n\r", slot);
+      return nullptr;
+    }
+
+    // Entries must point into the archive
+    const UiArchiveEntry* candidate_entries = (const UiArchiveEntry*) (base + sizeof(UiArchiveHeader));
+    for (uint16_t i = 0; i < candidate->n_entries; ++i) {
+      const UiArchiveEntry &entry = candidate_entries[i];
+      if (entry.offset < index_end || entry.offset + entry.len > candidate->size
+          || entry.path[UI_PATH_SIZE - 1] || entry.content_type[UI_TYPE_SIZE - 1] || entry.etag[UI_ETAG_SIZE - 1]) {
+        return nullptr;
+      }
+    }
+    return candidate;
+  }
+
+  // => Serve assets from the valid archive in a slot
+  void activate(const uint8_t slot, const UiArchiveHeader* valid_header) {
+    active_slot = slot;
+    header = valid_header;
+    entries = (const UiArchiveEntry*) (slotData(slot) + sizeof(UiArchiveHeader));
+  }
+
+  // => Find and map the partition and check the archives
+  bool init() {
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, UI_PARTITION_LABEL);
+    if (partition == nullptr) {
+      Serial.println("[UI] Error: No UI partition, flash with rotor-partitions-ui.csv.");
+      return false;
+    }
+    if (esp_partition_mmap(partition, 0, partition->size, ESP_PARTITION_MMAP_DATA,
+                           (const void**) &mapped, &mmap_handle) != ESP_OK) {
+      Serial.println("[UI] Error: Could not map UI partition.");
+      mapped = nullptr;
+      return false;
+    }
+    slot_size = (partition->size / UI_SLOTS) & ~(UI_SECTOR_SIZE - 1);
+
+    // Only one slot is valid, unless power was lost while switching. Both are complete then.
+    for (uint8_t slot = 0; slot < UI_SLOTS && header == nullptr; ++slot) {
+      const UiArchiveHeader* valid_header = validate(slot);
+      if (valid_header != nullptr) {
+        activate(slot, valid_header);
+      }
+    }
+    if (header == nullptr) {
+      Serial.println("[UI] No valid UI archive, upload one to /ui-update.");
+      return false;
+    }
+    if (verbose) {
+      Serial.printf("[UI] Version %s, %u assets, %u bytes in slot %d\n\r",
+                    header->ui_version, header->n_entries, header->size, active_slot);
+    }
+    return true;
+  }
+
+  // => Return wether a valid archive is mapped
+  bool isValid() {
+    return header != nullptr;
+  }
+
+  // => Find an entry by path, binary search
+  const UiArchiveEntry* find(const char* path) {
+    if (header == nullptr) {
+      return nullptr;
+    }
+    size_t low = 0;
+    size_t high = header->n_entries;
+    while (low < high) {
+      const size_t mid = (low + high) / 2;
+      const int cmp = strcmp(path, entries[mid].path);
+      if (cmp == 0) {
+        return &entries[mid];
+      }
+      if (cmp < 0) {
+        high = mid;
+      } else {
+        low = mid + 1;
+      }
+    }
+    return nullptr;
+  }
+
+  // => Mapped data of an entry
+  const uint8_t* getData(const UiArchiveEntry &entry) {
+    return slotData(active_slot) + entry.offset;
+  }
+
+  // => Keep the active slot from being erased until the response to request is sent
+  void holdUntilSent(AsyncWebServerRequest *request) {
+    if (active_slot < 0) {
+      return;
+    }
+    const uint8_t slot = active_slot;
+    n_in_flight[slot]++;
+    request->onDisconnect([slot]() {
+      n_in_flight[slot]--;
+    });
+  }
+
+  // => UI version of the archive
+  const char* getVersion() {
+    return header != nullptr ? header->ui_version : "";
+  }
+
+  // => Fail the running upload, keeps the first error
+  void fail(const char* error) {
+    if (upload.error == nullptr) {
+      upload.error = error;
+      Serial.print("[UI] Update error: ");
+      Serial.println(error);
+    }
+  }
+
+  // => Write a piece of the archive at offset into the upload slot. The header is held back
+  // until the upload is complete, sectors are erased just before they are written.
+  void writeArchive(const uint8_t* data, size_t len, size_t offset) {
+    if (offset + len > slot_size) {
+      fail("Archive larger than partition slot");
+      return;
+    }
+    if (offset < sizeof(UiArchiveHeader)) {
+      const size_t n = min(len, sizeof(UiArchiveHeader) - offset);
+      memcpy((uint8_t*) &upload.header + offset, data, n);
+      data += n;
+      len -= n;
+      offset += n;
+    }
+    if (!len) {
+      return;
+    }
+    const size_t base = upload.slot * slot_size;
+    while (upload.erased_end < offset + len) {
+      if (esp_partition_erase_range(partition, base + upload.erased_end, UI_SECTOR_SIZE) != ESP_OK) {
+        fail("Erase failed");
+        return;
+      }
+      upload.erased_end += UI_SECTOR_SIZE;
+    }
+    if (esp_partition_write(partition, base + offset, data, len) != ESP_OK) {
+      fail("Write failed");
+    }
+  }
+
+  // => Switch to the uploaded archive once it is written and valid. The old archive is
+  // invalidated by clearing its magic, which needs no erase, so responses still sending from it
+  // are not disturbed. Returns false if the upload is not a valid archive, the old one stays active.
+  bool switchArchive() {
+    if (esp_partition_write(partition, upload.slot * slot_size, &upload.header, sizeof(UiArchiveHeader)) != ESP_OK) {
+      fail("Write failed");
+      return false;
+    }
+    const UiArchiveHeader* valid_header = validate(upload.slot);
+    if (valid_header == nullptr) {
+      fail("Invalid archive");
+      return false;
+    }
+    const int8_t old_slot = active_slot;
+    activate(upload.slot, valid_header);
+    if (old_slot >= 0) {
+      const uint32_t cleared_magic = 0;
+      esp_partition_write(partition, old_slot * slot_size + offsetof(UiArchiveHeader, magic),
+                          &cleared_magic, sizeof(cleared_magic));
+    }
+    return true;
+  }
+
+  // => End the running upload, if it belongs to request
+  void endUpload(AsyncWebServerRequest *request) {
+    if (upload.request == request) {
+      upload.is_active = false;
+      upload.request = nullptr;
+    }
+  }
+
+  // => Upload handler for the archive via HTTP Post multipart/formdata
+  void handleUpload(AsyncWebServerRequest *request, String filename, size_t index, uint8_t *data, size_t len, bool final) {
+
+    // First data packet
+    // *****************
+    if (!index) {
+      // Only one upload at a time, a second one is refused and answered in handleUploadResponse
+      if (upload.is_active) {
+        Serial.println("[UI] Update refused, another upload is running.");
+        return;
+      }
+      upload.is_active = true;
+      upload.request = request;
+      upload.error = nullptr;
+      upload.slot = active_slot == 0 ? 1 : 0;
+      upload.erased_end = 0;
+      upload.written = 0;
+      memset(&upload.header, 0xFF, sizeof(upload.header));
+      upload.md5.begin();
+      upload.expected_md5 = request->hasParam("md5") ? request->getParam("md5")->value() : "";
+      // Aborted uploads don't get a response, free the upload once the client is gone
+      request->onDisconnect([request]() { endUpload(request); });
+
+      if (rotor_server.config.authenticate &&
+          !request->authenticate(rotor_server.config.user.c_str(), rotor_server.config.password.c_str())) {
+        fail("Not authenticated");
+      } else if (partition == nullptr || mapped == nullptr) {
+        fail("No UI partition");
+      } else if (upload.expected_md5.length() != 32) {
+        fail("MD5 missing");
+      } else if (n_in_flight[upload.slot]) {
+        fail("UI busy, try again");
+      } else {
+        // The active archive stays valid until the new one is complete
+        Serial.printf("[UI] Start UI update into slot %u from file: %s\n\r", upload.slot, filename.c_str());
+      }
+    }
+    if (request != upload.request) {
+      return;
+    }
+
+    // Every packet, write to partition
+    // ********************************
+    if (upload.error == nullptr) {
+      upload.md5.add(data, len);
+      writeArchive(data, len, index);
+      upload.written = index + len;
+    }
+
+    // Last data packet received
+    // *************************
+    if (final && upload.error == nullptr) {
+      upload.md5.calculate();
+      if (!upload.md5.toString().equalsIgnoreCase(upload.expected_md5)) {
+        fail("MD5 mismatch");
+      } else if (upload.written < sizeof(UiArchiveHeader)) {
+        fail("Archive too small");
+      } else if (switchArchive()) {
+        Serial.printf("[UI] Update succesful | Version: %s | Bytes written: %u\n\r",
+                      header->ui_version, upload.written);
+      }
+    }
+  }
+
+  // => Handler for when the upload finished
+  void handleUploadResponse(AsyncWebServerRequest *request) {
+    if (!RotorServer::authenticateRequest(request)) { return; }
+    if (upload.is_active && upload.request != request) {
+      request->send(409, "text/plain", "Another upload is running");
+      return;
+    }
+    if (!upload.is_active) {
+      request->send(400, "text/plain", "No archive uploaded");
+    } else if (upload.error != nullptr) {
+      request->send(200, "text/plain", upload.error);
+    } else {
+      request->send(200, "text/plain", "success");
+    }
+    endUpload(request);
+  }
+}
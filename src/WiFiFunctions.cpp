@@ -12,8 +12,6 @@
 #include <Timer.h>
 #include <RotorServer.h>
 
-#include <AppAssets.h>
-
 extern BlinkingLED wifi_led;
 
 namespace WiFiFunctions {
@@ -494,37 +492,17 @@ namespace WiFiFunctions {
 
     // Fonts
     // -----
-    server->on("/inter-regular.woff2", HTTP_GET, [](AsyncWebServerRequest* request) {
-      AsyncWebServerResponse *response = request->beginResponse_P(200, "font/woff2", inter_regular_woff2, inter_regular_woff2_len);
-      response->addHeader("cache-control", ASSET_CACHE_CONTROL);
-      request->send(response);
-    });
+    server->on("/inter-regular.woff2", HTTP_GET, RotorServer::serveStaticAsset);
 
-    server->on("/inter-700.woff2", HTTP_GET, [](AsyncWebServerRequest* request) {
-      AsyncWebServerResponse *response = request->beginResponse_P(200, "font/woff2", inter_700_woff2, inter_700_woff2_len);
-      response->addHeader("cache-control", ASSET_CACHE_CONTROL);
-      request->send(response);
-    });
+    server->on("/inter-700.woff2", HTTP_GET, RotorServer::serveStaticAsset);
 
     // Favicons
     // --------
-    server->on("/favicon-16x16.png", HTTP_GET, [](AsyncWebServerRequest* request) {
-      AsyncWebServerResponse *response = request->beginResponse_P(200, "image/png", favicon_16x16_png, favicon_16x16_png_len);
-      response->addHeader("cache-control", ASSET_CACHE_CONTROL);
-      request->send(response);
-    });
+    server->on("/favicon-16x16.png", HTTP_GET, RotorServer::serveStaticAsset);
 
-    server->on("/favicon-32x32.png", HTTP_GET, [](AsyncWebServerRequest* request) {
-      AsyncWebServerResponse *response = request->beginResponse_P(200, "image/png", favicon_32x32_png, favicon_32x32_png_len);
-      response->addHeader("cache-control", ASSET_CACHE_CONTROL);
-      request->send(response);
-    });
+    server->on("/favicon-32x32.png", HTTP_GET, RotorServer::serveStaticAsset);
 
-    server->on("/apple-touch-icon.png", HTTP_GET, [](AsyncWebServerRequest* request) {
-      AsyncWebServerResponse *response = request->beginResponse_P(200, "image/png", apple_touch_icon_png, apple_touch_icon_png_len);
-      response->addHeader("cache-control", ASSET_CACHE_CONTROL);
-      request->send(response);
-    });
+    server->on("/apple-touch-icon.png", HTTP_GET, RotorServer::serveStaticAsset);
 
 
     // Captive Portal responses
@@ -21,8 +21,36 @@
 #include <Stats.h>
 #include <RotorSocket.h>      // Exposes Global: websocket 
 #include <RotorServer.h>      // Exposes Global: rotor_server 
+#include <ControlTask.h>
+#include <RotationHistory.h>  // Exposes Global: rotation_history
+#include <PositionLog.h>      // Exposes Global: position_log
+#include <Rotctld.h>
+#include <GS232.h>
+#include <MqttClient.h>
+#include <UdpRotor.h>
+#include <TelemetryMulticast.h>
+#ifdef UI_PARTITION
+#include <UiPartition.h>
+#endif
+#ifdef SIMULATION_BENCHMARK
+#include <SimulationBenchmark.h>
+#endif
+#ifdef PARSER_BENCHMARK
+#include <ParserBenchmark.h>
+#endif
+#ifdef HISTORY_BENCHMARK
+#include <HistoryBenchmark.h>
+#endif
 
 #define HAS_SCREEN true
+#define NTP_SERVER "pool.ntp.org"
+
+// Adaptive rotor telemetry
+#define TELEMETRY_MIN_INTERVAL 50       // ms, fastest rate during motion
+#define TELEMETRY_MAX_INTERVAL 250      // ms, slowest rate during motion
+#define TELEMETRY_HEARTBEAT 2000        // ms, rate while stationary
+#define TELEMETRY_STEP 1.0f             // °, angle change per frame during motion
+#define TELEMETRY_MAX_ERROR 0.3f        // °, send early if the clients' extrapolation is off by more
 //#define COUNT_LOOP_CYCLE_TIME
 
 // Software version
@@ -106,11 +134,19 @@ void setup() {
   #ifdef DEMO_MODE
   Serial.println("[ESP] Firmware built in DEMO mode.");
   #endif
+  #ifdef SIMULATE_ROTOR
+  Serial.println("[ESP] Firmware built with a simulated rotor.");
+  #endif
   Serial.print("[ESP] Firmware MD5: ");
   Serial.println(ESP.getSketchMD5());
   Serial.print("[ESP] Firmware size: ");
   Serial.println(ESP.getSketchSize());
 
+  // Web UI served from its own partition
+  #ifdef UI_PARTITION
+  UiPartition::init();
+  #endif
+
   // ESP ID derived from MAC address
   esp_id = WiFi.macAddress();
   esp_id.replace(":", "");
@@ -131,8 +167,15 @@ void setup() {
   // Initialisations
   // ---------------
 
-  // Init Settings message buffer
-  Settings::initBuffer();
+  // Compare inbound message parsers
+  #ifdef PARSER_BENCHMARK
+  ParserBenchmark::run(PARSER_BENCHMARK);
+  #endif
+
+  // Size and encode cost of the rotation history
+  #ifdef HISTORY_BENCHMARK
+  HistoryBenchmark::run(HISTORY_BENCHMARK);
+  #endif
 
   // Initialise screen
   if (has_screen) {
@@ -150,6 +193,7 @@ void setup() {
   if(!rotor_ctrl.init()) {    
     fatalError("Failed to properly initialise rotor controller instance.", false);
   }
+  rotation_history.init();
 
   // Initialise filesystem
   if (!mountFS()) {
@@ -161,6 +205,9 @@ void setup() {
   favorites.init();
   firmware.init();    
 
+  // Long-term position log
+  position_log.init(boot_counter.get(), rotor_ctrl.getSnapshot());
+
   // Default lock message, resets lock on ESP boot
   lock_msg += "|{\"isLocked\":false,\"by\":\"\"}";         
 
@@ -186,7 +233,39 @@ void setup() {
     Serial.print(":");
     Serial.println(rotor_server.config.port);
     Serial.println();
+
+    // Hamlib rotctld listener
+    Rotctld::initServer();
+
+    // GS-232 emulation on UART2 and TCP
+    GS232::init();
+
+    // N1MM / PstRotator commands over UDP
+    UdpRotor::init();
+
+    // Telemetry for any number of LAN listeners
+    Multicast::init();
+
+    // MQTT state publisher, connects in the background once configured
+    Mqtt::init();
+
+    // Wall clock for the position log
+    configTime(0, 0, NTP_SERVER);
+
+    // Start rotor control task
+    ControlTask::start();
   }
+
+  // Start UI task
+  if (has_screen) {
+    screen.startTask();
+  }
+
+  // Benchmark auto-rotation against the simulated rotor, also without WiFi
+  #ifdef SIMULATION_BENCHMARK
+  ControlTask::start();
+  SimulationBenchmark::start(SIMULATION_BENCHMARK);
+  #endif
 }
 
 
@@ -204,10 +283,11 @@ struct {                          // Intervals
   Timer reboot{86400000 * 3};     // 3 days
   Timer multiBtnHold{500};        // 500 ms, 2Hz
   Timer cleanSockets{1000};       // 1 s
-  Timer rotorUpdate{40};          // 40 ms, 25 Hz
-  Timer rotorMessage{1000};       // 1 s
-  Timer speedRamp{40};            // 40 ms, 25 Hz
-  Timer updateScreen{40};         // 40 ms, 25 Hz
+  Timer rotorPoll{20};            // 20 ms, 50 Hz
+  Timer pingClients{5000};        // 5 s
+  Timer recordHistory{50};        // 50 ms, 20 Hz
+  Timer mqttUpdate{50};           // 50 ms, 20 Hz
+  Timer controlStats{60000};      // 60 s
   Timer loopTimer{1000};          // 1 s
   Timer fwUpdateChecker{50};      // 50 ms, 20 Hz
   Timer onTime{1000 * 60};        // 1 min
@@ -215,11 +295,30 @@ struct {                          // Intervals
 } timers;
 
 bool is_reconnecting = false;   // Is WiFi trying to reconnect
-float adc_volts_prev = -1;      // Previous loop ADC-Volts
 bool is_rotating_prev = false;  // Was rotor rotating in previous loop cycle
 uint8_t clients_connected_prev; // N of clients connected in previous loop cycle
 bool is_updating_prev = false;  // Was firmware updating in previous loop cycle
 bool just_booted = true;
+uint32_t n_aborted_prev = 0;    // Aborted auto rotations in previous loop cycle
+
+// Rotor state in the last rotation message, clients extrapolate from it
+struct {
+  unsigned long ms = 0;
+  float angle = 0.0f;
+  float angular_speed = 0.0f;
+} telemetry_sent;
+
+// => Interval between rotation messages, scaled to the angular speed during motion
+unsigned long telemetryInterval(const Rotor::Snapshot &state) {
+  if (!state.is_rotating && state.angular_speed == 0.0f) {
+    return TELEMETRY_HEARTBEAT;
+  }
+  if (state.angular_speed == 0.0f) {
+    return TELEMETRY_MAX_INTERVAL;
+  }
+  return constrain((unsigned long) (TELEMETRY_STEP / abs(state.angular_speed) * 1000.0f),
+                   TELEMETRY_MIN_INTERVAL, TELEMETRY_MAX_INTERVAL);
+}
 
 #ifdef COUNT_LOOP_CYCLE_TIME
 unsigned long loopCounter = 0;
@@ -243,15 +342,16 @@ void loop() {
   // Check for multi button being pressed down
   if (multi_btn_pressed && !multi_btn_hold && !firmware.is_updating) {
     Serial.println("[BTN] pressed.");
+    bool is_rotating = rotor_ctrl.getSnapshot().is_rotating;
 
     // Toggle screen if rotor is not rotating
-    if (has_screen && use_screen && !rotor_ctrl.is_rotating) {
+    if (has_screen && use_screen && !is_rotating) {
       screen.toggleScreens();
     }
 
     // Stop rotor
-    if (rotor_ctrl.is_rotating) {
-      rotor_ctrl.stop();
+    if (is_rotating) {
+      rotor_ctrl.post(Rotor::Command::stop());
       wifi_led.blink(1, 250ul);
     }
 
@@ -272,7 +372,7 @@ void loop() {
     } else if (timers.multiBtnHold.passed()) {
       // Reset WiFi after timer 2 s
       if (timers.multiBtnHold.n_passed == 4) {
-        rotor_ctrl.stop();
+        rotor_ctrl.post(Rotor::Command::stop());
         wifi_led.blinkBlocking(4, 250ul);
         Serial.println("[BTN] held for 2s. Resetting WiFi credentials and restart.");
         WiFiFunctions::resetCredentials();
@@ -286,43 +386,89 @@ void loop() {
   // *********** Rotor ***********
   // *****************************
 
-  // Update rotor values and send rotation message to clients every second update.
-  // Update angular speed every 8th update.
-  if (in_station_mode && timers.rotorUpdate.passed() && !firmware.is_updating) {
-    rotor_ctrl.update(!(timers.rotorUpdate.n_passed % 8));
-
-    // Send rotation message every second update and only if clients are connected
-    if (RotorSocket::clients_connected && timers.rotorUpdate.n_passed % 2 == 0) {
-      /* Send rotation message if either:
-          1. voltage changed significantly compared to last message
-          2. rotor started or stopped rotation
-          3. last message was sent more than 1 second ago
-      */
-      if ((abs(rotor_ctrl.rotor.last_adc_volts - adc_volts_prev) > 0.003) ||
-          (rotor_ctrl.is_rotating != is_rotating_prev) ||
-          (timers.rotorMessage.passed())) {
-        rotor_ctrl.messenger.sendLastRotation(true);
-        adc_volts_prev = rotor_ctrl.rotor.last_adc_volts;
-        is_rotating_prev = rotor_ctrl.is_rotating;
-        timers.rotorMessage.start();
-      }      
+  // Rotor values are updated by the control task.
+  // Send rotation message from the last published rotor state, only if clients are connected.
+  if (in_station_mode && RotorSocket::clients_connected && timers.rotorPoll.passed() && !firmware.is_updating) {
+    Rotor::Snapshot rotor_state = rotor_ctrl.getSnapshot();
+    unsigned long elapsed = millis() - telemetry_sent.ms;
+    float extrapolated = telemetry_sent.angle + telemetry_sent.angular_speed * elapsed / 1000.0f;
+
+    /* Send rotation message if either:
+        1. interval passed, short during motion, a slow heartbeat while stationary
+        2. rotor started or stopped rotation
+        3. angle deviates from what clients extrapolate from the last message
+    */
+    if ((elapsed >= telemetryInterval(rotor_state)) ||
+        (rotor_state.is_rotating != is_rotating_prev) ||
+        (elapsed >= TELEMETRY_MIN_INTERVAL && abs(rotor_state.angle - extrapolated) > TELEMETRY_MAX_ERROR)) {
+      rotor_ctrl.messenger.sendNewRotation();
+      is_rotating_prev = rotor_state.is_rotating;
+      telemetry_sent.ms = millis();
+      telemetry_sent.angle = rotor_state.angle;
+      telemetry_sent.angular_speed = rotor_state.angular_speed;
     }
   }
 
-  // Watch active auto rotation
-  if (in_station_mode && rotor_ctrl.is_auto_rotating) {
-    rotor_ctrl.watchAutoRotation();
+  // Record rotation history and position log, also while no client is connected
+  if (in_station_mode && timers.recordHistory.passed() && !firmware.is_updating) {
+    const Rotor::Snapshot history_state = rotor_ctrl.getSnapshot();
+    rotation_history.record(history_state);
+    position_log.record(history_state);
+  }
+
+  // Publish rotor state to the MQTT broker, reconnect in the background
+  if (in_station_mode && timers.mqttUpdate.passed() && !firmware.is_updating) {
+    Mqtt::update(rotor_ctrl.getSnapshot());
+  }
+
+  // Multicast telemetry, paced by the stream's own rate
+  if (in_station_mode && !firmware.is_updating) {
+    Multicast::update(rotor_ctrl.getSnapshot());
+  }
+
+  // Log aborted auto rotations
+  if (rotor_ctrl.auto_rot_stats.n_aborted != n_aborted_prev) {
+    n_aborted_prev = rotor_ctrl.auto_rot_stats.n_aborted;
+    position_log.event(LOG_EVENT_AUTO_ABORTED, lround(rotor_ctrl.getSnapshot().target));
   }
 
-  // Watch active speed ramp
-  if (in_station_mode && rotor_ctrl.smooth_speed_active && timers.speedRamp.passed()) {
-    rotor_ctrl.watchSmoothSpeedRamp();
+  // Write the position log in batches
+  if (!firmware.is_updating) {
+    position_log.flush();
+  }
+
+  // Save calibration and coast model changed by the control task, flash writes would stall it
+  if (!firmware.is_updating) {
+    rotor_ctrl.savePending();
+  }
+
+  // Handle GS-232 commands received on UART2
+  if (in_station_mode && !firmware.is_updating) {
+    GS232::pollSerial();
+  }
+
+  // Apply state messages received by the websocket, greet new clients
+  if (in_station_mode && !firmware.is_updating) {
+    RotorSocket::applyPending();
+    RotorSocket::greetNewClients();
+  }
+
+  // Send all messages requested since last loop cycle, merged into one frame per client
+  if (in_station_mode && !firmware.is_updating) {
+    RotorSocket::sendAcks();
+    rotor_ctrl.messenger.flush();
+  }
+
+  // Measure round trip time to all clients
+  if (in_station_mode && timers.pingClients.passed()) {
+    RotorSocket::pingClients();
   }
 
   // Stop rotor if all clients disconnected
   if (in_station_mode && !RotorSocket::clients_connected && clients_connected_prev) {
-    rotor_ctrl.stop();
+    rotor_ctrl.post(Rotor::Command::stop());
     Serial.println("[Websocket] ALL clients disconnected.");
+    position_log.event(LOG_EVENT_CLIENTS_LOST);
     if (has_screen) {
       screen.setAlert("All clients disc.");
     }
@@ -340,14 +486,15 @@ void loop() {
   if (in_station_mode && timers.checkWiFi.passed()) {
     if (!WiFi.isConnected()) {
       // Stop rotor
-      if (rotor_ctrl.is_rotating) {
-        rotor_ctrl.stop();
+      if (rotor_ctrl.getSnapshot().is_rotating) {
+        rotor_ctrl.post(Rotor::Command::stop());
       }
 
       // Start reconnect timeout
       if (!is_reconnecting) {
         timers.reconnectTimeout.start();
         is_reconnecting = true;
+        position_log.event(LOG_EVENT_WIFI_LOST);
       }
 
       // Try to reconnect
@@ -367,6 +514,7 @@ void loop() {
   // Reboot ESP after reconnect timeout
   if (in_station_mode && is_reconnecting && timers.reconnectTimeout.passed()) {
     Serial.println("[WiFi] Reconnecting failed! Restarting ESP.");
+    position_log.flush(true);
     delay(1000);
     ESP.restart();
   }
@@ -376,11 +524,6 @@ void loop() {
   // ******** Housekeeping ********
   // ******************************
 
-  // Update the screen
-  if (has_screen && timers.updateScreen.passed()) {
-    screen.update();
-  }
-
   // Blinking-LED tick
   wifi_led.tick();
 
@@ -393,6 +536,7 @@ void loop() {
 
   // Reboot ESP after a few days
   if (in_station_mode && timers.reboot.passed() && !firmware.is_updating) {
+    position_log.flush(true);
     ESP.restart();
   }
 
@@ -411,6 +555,8 @@ void loop() {
  
     // When update starts 
     if (!is_updating_prev && firmware.is_updating) {
+      position_log.event(LOG_EVENT_FIRMWARE_UPDATE);
+      position_log.flush(true);
       websocket.enable(false);
       wifi_led.startBlinking(500);
       firmware.timeout.start();
@@ -458,6 +604,20 @@ void loop() {
   // ****** Loop Cycle Time  ******
   // ******************************
 
+  // Report timing of the control task and cost of rotor telemetry
+  if (verbose && in_station_mode && timers.controlStats.passed()) {
+    ControlTask::printStats();
+    rotor_ctrl.messenger.printTelemetryStats();
+    RotorSocket::printClientStats();
+    position_log.printStats();
+    Rotctld::printStats();
+    GS232::printStats();
+    UdpRotor::printStats();
+    Multicast::printStats();
+    RotorServer::printAssetStats();
+    Mqtt::printStats();
+  }
+
   #ifdef COUNT_LOOP_CYCLE_TIME
   if (timers.loopTimer.passed()) {
     double loop_cycle = (float) ((micros() - loop_mus) / loopCounter) / 1000.0;
@@ -0,0 +1,58 @@
+// Firmware Stubs
+// **************
+// Shared by all host tests. Globals of main.cpp and the modules that need hardware or
+// the network stack, which the host tests don't build. Files live in memory.
+
+#include <Arduino.h>
+#include <map>
+
+#include <globals.h>
+#include <RotorSocket.h>
+#include <SimpleFS.h>
+#include <Screen.h>             // Exposes Global: screen
+#include <WiFiFunctions.h>
+
+// main.cpp
+const String version = "test";
+String esp_id = "TEST";
+String lock_msg = MSG_ID_LOCK "|{\"isLocked\":false,\"by\":\"\"}";
+bool in_station_mode = true;
+bool has_screen = true;
+bool use_screen = true;
+
+// Screen.cpp, draws nothing
+Screen::Screen screen;
+
+// WiFiFunctions.cpp
+namespace WiFiFunctions {
+  struct WiFiConfig wifi_config;
+}
+
+// SimpleFS.cpp
+namespace Mock {
+  // File contents by path
+  std::map<std::string, String> files;
+}
+
+bool mountFS() {
+  return true;
+}
+
+String readFromFS(const char* path) {
+  auto file = Mock::files.find(path);
+  return file != Mock::files.end() ? file->second : String();
+}
+
+bool writeToFS(const char* path, const String &data) {
+  Mock::files[path] = data;
+  return true;
+}
+
+bool appendToFS(const char* path, const uint8_t* data, const size_t len) {
+  Mock::files[path].concat((const char*) data, len);
+  return true;
+}
+
+bool removeFromFS(const char* path) {
+  return Mock::files.erase(path) > 0;
+}
@@ -0,0 +1,64 @@
+#ifndef MOCK_ADAFRUIT_ADS1X15_H
+#define MOCK_ADAFRUIT_ADS1X15_H
+
+// ADS1115 Mock
+// ************
+// The conversion register holds whatever the test sets, volts follow the configured gain.
+
+#include <Arduino.h>
+
+typedef enum {
+  GAIN_TWOTHIRDS = 0x0000,
+  GAIN_ONE = 0x0200,
+  GAIN_TWO = 0x0400,
+  GAIN_FOUR = 0x0600,
+  GAIN_EIGHT = 0x0800,
+  GAIN_SIXTEEN = 0x0A00
+} adsGain_t;
+
+#define RATE_ADS1115_8SPS 0x0000
+#define RATE_ADS1115_16SPS 0x0020
+#define RATE_ADS1115_32SPS 0x0040
+#define RATE_ADS1115_64SPS 0x0060
+#define RATE_ADS1115_128SPS 0x0080
+#define RATE_ADS1115_250SPS 0x00A0
+#define RATE_ADS1115_475SPS 0x00C0
+#define RATE_ADS1115_860SPS 0x00E0
+
+constexpr uint16_t MUX_BY_CHANNEL[] = {0x4000, 0x5000, 0x6000, 0x7000};
+
+namespace Mock {
+  // Conversion register of the ADC
+  inline int16_t adc_conversion = 0;
+
+  // ADC answers on the bus
+  inline bool adc_present = true;
+}
+
+class Adafruit_ADS1115 {
+private:
+  adsGain_t gain = GAIN_TWOTHIRDS;
+
+public:
+  bool begin(uint8_t = 0x48) { return Mock::adc_present; }
+  void setGain(adsGain_t new_gain) { gain = new_gain; }
+  void setDataRate(uint16_t) {}
+  void startADCReading(uint16_t, bool) {}
+  int16_t getLastConversionResults() { return Mock::adc_conversion; }
+
+  // => Volts of a conversion result at the configured gain
+  float computeVolts(int16_t counts) {
+    float fs_range;
+    switch (gain) {
+      case GAIN_TWOTHIRDS: fs_range = 6.144f; break;
+      case GAIN_ONE: fs_range = 4.096f; break;
+      case GAIN_TWO: fs_range = 2.048f; break;
+      case GAIN_FOUR: fs_range = 1.024f; break;
+      case GAIN_EIGHT: fs_range = 0.512f; break;
+      default: fs_range = 0.256f; break;
+    }
+    return counts * (fs_range / 32768);
+  }
+};
+
+#endif //MOCK_ADAFRUIT_ADS1X15_H
@@ -0,0 +1,10 @@
+#ifndef MOCK_ADAFRUIT_SSD1306_H
+#define MOCK_ADAFRUIT_SSD1306_H
+
+// Adafruit SSD1306 Mock
+// *********************
+// Type only, the screen isn't drawn on the host.
+
+class Adafruit_SSD1306 {};
+
+#endif //MOCK_ADAFRUIT_SSD1306_H
@@ -0,0 +1,212 @@
+#ifndef MOCK_ARDUINO_H
+#define MOCK_ARDUINO_H
+
+// Arduino Mock
+// ************
+// Just enough of the Arduino core and FreeRTOS to build firmware modules on the host.
+// Time comes from a simulated clock and GPIO / DAC writes are recorded, both for the tests
+// to drive and inspect. Tasks are not started, tests call the task bodies themselves.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <algorithm>
+#include <string>
+
+using std::min;
+using std::max;
+
+#define PI 3.1415926535897932384626433832795
+#define constrain(x, low, high) ((x) < (low) ? (low) : ((x) > (high) ? (high) : (x)))
+#define IRAM_ATTR
+#define PROGMEM
+#define SERIAL_8N1 0x800001c
+
+namespace Mock {
+  // Simulated time since boot in µs
+  inline uint64_t now_us = 0;
+
+  // Print Serial output to stdout
+  inline bool echo_serial = false;
+
+  // Last levels written to GPIOs and DAC values, 0 if disabled
+  inline uint8_t pin_levels[40] = {0};
+  inline uint8_t dac_values[40] = {0};
+
+  // State of the random number generator
+  inline uint32_t random_state = 0x12345678;
+
+  // => Advance the simulated clock
+  inline void advance(const uint64_t us) { now_us += us; }
+}
+
+// Time
+inline unsigned long micros() { return (unsigned long) Mock::now_us; }
+inline unsigned long millis() { return (unsigned long) (Mock::now_us / 1000); }
+inline void delay(unsigned long ms) { Mock::advance(ms * 1000ULL); }
+
+// GPIO and DAC
+#define LOW 0x0
+#define HIGH 0x1
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define FALLING 0x02
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t pin, uint8_t level) { Mock::pin_levels[pin] = level; }
+inline int digitalRead(uint8_t pin) { return Mock::pin_levels[pin]; }
+inline void attachInterrupt(uint8_t, void (*)(void), int) {}
+inline void dacWrite(uint8_t pin, uint8_t value) { Mock::dac_values[pin] = value; }
+inline void dacDisable(uint8_t pin) { Mock::dac_values[pin] = 0; }
+
+// Random numbers, xorshift32
+inline uint32_t esp_random() {
+  uint32_t x = Mock::random_state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return Mock::random_state = x;
+}
+inline void randomSeed(unsigned long seed) { Mock::random_state = seed ? seed : 1; }
+inline long random(long high) { return high > 0 ? esp_random() % high : 0; }
+inline long random(long low, long high) { return high > low ? low + random(high - low) : low; }
+
+// FreeRTOS
+typedef void* TaskHandle_t;
+typedef void* SemaphoreHandle_t;
+typedef int BaseType_t;
+typedef uint32_t TickType_t;
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdPASS 1
+#define portMAX_DELAY 0xFFFFFFFF
+#define pdMS_TO_TICKS(ms) ((TickType_t) (ms))
+#define portYIELD_FROM_ISR()
+
+inline BaseType_t xTaskCreatePinnedToCore(void (*)(void*), const char*, uint32_t, void*, int, TaskHandle_t* handle, int) {
+  if (handle != nullptr) { *handle = nullptr; }
+  return pdPASS;
+}
+inline void vTaskDelete(TaskHandle_t) {}
+inline void vTaskDelay(TickType_t ticks) { delay(ticks); }
+inline TickType_t xTaskGetTickCount() { return millis(); }
+inline void vTaskDelayUntil(TickType_t* last_wake, TickType_t period) { *last_wake += period; }
+inline uint32_t ulTaskNotifyTake(BaseType_t, TickType_t) { return 0; }
+inline void vTaskNotifyGiveFromISR(TaskHandle_t, BaseType_t*) {}
+inline SemaphoreHandle_t xSemaphoreCreateMutex() { return (SemaphoreHandle_t) 1; }
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t, TickType_t) { return pdTRUE; }
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t) { return pdTRUE; }
+
+// Arduino String, backed by std::string
+class String {
+private:
+  std::string s;
+
+public:
+  String() {}
+  String(const char* str) : s(str != nullptr ? str : "") {}
+  String(const std::string &str) : s(str) {}
+  String(char c) : s(1, c) {}
+  String(int value) : s(std::to_string(value)) {}
+  String(unsigned int value) : s(std::to_string(value)) {}
+  String(long value) : s(std::to_string(value)) {}
+  String(unsigned long value) : s(std::to_string(value)) {}
+
+  const char* c_str() const { return s.c_str(); }
+  unsigned int length() const { return s.length(); }
+  bool reserve(unsigned int size) { s.reserve(size); return true; }
+  bool concat(const char* str, unsigned int len) { s.append(str, len); return true; }
+  bool concat(const String &str) { s += str.s; return true; }
+  void clear() { s.clear(); }
+  char operator[](unsigned int i) const { return i < s.size() ? s[i] : 0; }
+  bool equals(const String &other) const { return s == other.s; }
+  bool startsWith(const String &prefix) const { return s.compare(0, prefix.s.size(), prefix.s) == 0; }
+  int indexOf(char c, unsigned int from = 0) const {
+    size_t pos = s.find(c, from);
+    return pos == std::string::npos ? -1 : (int) pos;
+  }
+  String substring(unsigned int from, unsigned int to) const { return from < s.size() ? String(s.substr(from, to - from)) : String(); }
+  String substring(unsigned int from) const { return from < s.size() ? String(s.substr(from)) : String(); }
+  long toInt() const { return strtol(s.c_str(), nullptr, 10); }
+  float toFloat() const { return strtof(s.c_str(), nullptr); }
+
+  String& operator+=(const String &other) { s += other.s; return *this; }
+  String& operator+=(const char* str) { s += str; return *this; }
+  String& operator+=(char c) { s += c; return *this; }
+  String& operator+=(int value) { s += std::to_string(value); return *this; }
+  String& operator+=(unsigned int value) { s += std::to_string(value); return *this; }
+  String& operator+=(long value) { s += std::to_string(value); return *this; }
+  String& operator+=(unsigned long value) { s += std::to_string(value); return *this; }
+  friend String operator+(String a, const String &b) { a += b; return a; }
+  friend String operator+(String a, const char* b) { a += b; return a; }
+  bool operator==(const String &other) const { return s == other.s; }
+  bool operator==(const char* other) const { return s == other; }
+  bool operator!=(const String &other) const { return s != other.s; }
+};
+
+// Serial, output is dropped unless echoed or recorded. Input is fed by the test.
+class MockSerial {
+public:
+  std::string rx;               // Received, not yet read
+  std::string tx;               // Sent, if recorded
+  bool record_tx = false;
+
+  void begin(unsigned long) {}
+  void begin(unsigned long, uint32_t, int8_t, int8_t) {}
+  int available() { return rx.size(); }
+  size_t read(uint8_t* buffer, size_t len) {
+    len = std::min(len, rx.size());
+    memcpy(buffer, rx.data(), len);
+    rx.erase(0, len);
+    return len;
+  }
+  template<typename T> void print(const T &value) { if (Mock::echo_serial || record_tx) { write(value); } }
+  void print(float value, int digits) {
+    if (!Mock::echo_serial && !record_tx) { return; }
+    char str[32];
+    snprintf(str, sizeof(str), "%.*f", digits, value);
+    out(str);
+  }
+  void print(double value, int digits) { print((float) value, digits); }
+  template<typename T> void println(const T &value) { print(value); print("\n"); }
+  void println(float value, int digits) { print(value, digits); print("\n"); }
+  void println() { print("\n"); }
+  template<typename... Args> void printf(const char* format, Args... args) {
+    if (Mock::echo_serial || record_tx) {
+      char str[256];
+      snprintf(str, sizeof(str), format, args...);
+      out(str);
+    }
+  }
+
+private:
+  void out(const char* str) {
+    if (record_tx) { tx += str; }
+    if (Mock::echo_serial) { fputs(str, stdout); }
+  }
+  void write(const char* str) { out(str); }
+  void write(char* str) { out(str); }
+  void write(const String &str) { out(str.c_str()); }
+  void write(char c) { const char str[2] = {c, '\0'}; out(str); }
+  void write(float value) { char str[32]; snprintf(str, sizeof(str), "%.2f", value); out(str); }
+  void write(double value) { write((float) value); }
+  template<typename T> void write(const T &value) { out(std::to_string((long long) value).c_str()); }
+};
+
+// Chip and sketch info
+class EspClass {
+public:
+  String getSketchMD5() { return "00000000000000000000000000000000"; }
+};
+
+inline EspClass ESP;
+
+inline MockSerial Serial;
+inline MockSerial Serial2;
+
+#endif //MOCK_ARDUINO_H
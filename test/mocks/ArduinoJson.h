@@ -0,0 +1,94 @@
+#ifndef MOCK_ARDUINOJSON_H
+#define MOCK_ARDUINOJSON_H
+
+// ArduinoJson Mock
+// ****************
+// Flat objects only, as the firmware builds its messages: doc["key"] = value, then
+// serializeJson(doc, string) appends them. Members keep their insertion order.
+
+#include <Arduino.h>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+class JsonDocument {
+private:
+  std::vector<std::pair<std::string, std::string>> members;   // Key, serialized value
+
+  // => Set a serialized value, replaces one with the same key
+  void set(const std::string &key, const std::string &value) {
+    for (auto &member : members) {
+      if (member.first == key) { member.second = value; return; }
+    }
+    members.emplace_back(key, value);
+  }
+
+  static std::string quote(const char* str) {
+    std::string quoted = "\"";
+    for (const char* c = str; *c; ++c) {
+      if (*c == '"' || *c == '\\') { quoted += '\\'; }
+      quoted += *c;
+    }
+    return quoted + "\"";
+  }
+
+  template<typename T>
+  static std::string format(const T &value) {
+    if constexpr (std::is_same<T, bool>::value) {
+      return value ? "true" : "false";
+    } else if constexpr (std::is_integral<T>::value) {
+      return std::to_string((long long) value);
+    } else if constexpr (std::is_floating_point<T>::value) {
+      char buffer[32];
+      snprintf(buffer, sizeof(buffer), "%.9g", (double) value);
+      return buffer;
+    } else if constexpr (std::is_same<T, String>::value) {
+      return quote(value.c_str());
+    } else {
+      return quote(value);
+    }
+  }
+
+public:
+  // Member being assigned
+  class Member {
+  private:
+    JsonDocument &doc;
+    std::string key;
+
+  public:
+    Member(JsonDocument &doc, const char* key) : doc(doc), key(key) {}
+
+    template<typename T>
+    Member& operator=(const T &value) {
+      doc.set(key, format(value));
+      return *this;
+    }
+  };
+
+  Member operator[](const char* key) { return Member(*this, key); }
+
+  void clear() { members.clear(); }
+
+  // => Serialized object
+  std::string serialize() const {
+    std::string json = "{";
+    for (const auto &member : members) {
+      if (json.size() > 1) { json += ","; }
+      json += quote(member.first.c_str()) + ":" + member.second;
+    }
+    return json + "}";
+  }
+};
+
+template<size_t N>
+class StaticJsonDocument : public JsonDocument {};
+
+// => Append the serialized document, returns the number of characters written
+inline size_t serializeJson(const JsonDocument &doc, String &output) {
+  const std::string json = doc.serialize();
+  output += json.c_str();
+  return json.size();
+}
+
+#endif //MOCK_ARDUINOJSON_H
@@ -0,0 +1,32 @@
+#ifndef MOCK_ASYNCTCP_H
+#define MOCK_ASYNCTCP_H
+
+// AsyncTCP Mock
+// *************
+// Enough to build the TCP listeners, no connections are made. Tests feed their line parsers.
+
+#include <Arduino.h>
+#include <functional>
+
+class AsyncClient;
+typedef std::function<void(void*, AsyncClient*)> AcConnectHandler;
+typedef std::function<void(void*, AsyncClient*, void* data, size_t len)> AcDataHandler;
+
+class AsyncClient {
+public:
+  size_t write(const char* data, size_t len) { return len; }
+  void close(bool now = false) {}
+  void setNoDelay(bool nodelay) {}
+  void onData(AcDataHandler cb, void* arg = nullptr) {}
+  void onDisconnect(AcConnectHandler cb, void* arg = nullptr) {}
+  String remoteIP() const { return "127.0.0.1"; }
+};
+
+class AsyncServer {
+public:
+  AsyncServer(uint16_t port) {}
+  void onClient(AcConnectHandler cb, void* arg) {}
+  void begin() {}
+};
+
+#endif //MOCK_ASYNCTCP_H
@@ -0,0 +1,65 @@
+#ifndef MOCK_ASYNCUDP_H
+#define MOCK_ASYNCUDP_H
+
+// AsyncUDP Mock
+// *************
+// No sockets. Listeners register by port, Mock::sendDatagram delivers a datagram to the
+// packet handler of the port, like the UDP task, and returns what it wrote back.
+
+#include <Arduino.h>
+#include <functional>
+#include <map>
+#include <string>
+
+class AsyncUDPPacket {
+private:
+  std::string payload;
+
+public:
+  std::string reply;            // Written back to the sender
+
+  AsyncUDPPacket(const std::string &payload) : payload(payload) {}
+
+  uint8_t* data() { return (uint8_t*) payload.data(); }
+  size_t length() { return payload.size(); }
+  size_t write(const uint8_t* data, size_t len) {
+    reply.append((const char*) data, len);
+    return len;
+  }
+};
+
+typedef std::function<void(AsyncUDPPacket &packet)> AuPacketHandlerFunction;
+
+class AsyncUDP;
+
+namespace Mock {
+  // Listeners by port
+  inline std::map<uint16_t, AsyncUDP*> udp_listeners;
+}
+
+class AsyncUDP {
+public:
+  AuPacketHandlerFunction handler;
+
+  bool listen(uint16_t port) {
+    Mock::udp_listeners[port] = this;
+    return true;
+  }
+  void onPacket(AuPacketHandlerFunction cb) { handler = cb; }
+};
+
+namespace Mock {
+  // => Deliver a datagram to the listener on port, returns the reply. False if nobody listens.
+  inline bool sendDatagram(const uint16_t port, const std::string &datagram, std::string &reply) {
+    auto listener = udp_listeners.find(port);
+    if (listener == udp_listeners.end() || !listener->second->handler) {
+      return false;
+    }
+    AsyncUDPPacket packet(datagram);
+    listener->second->handler(packet);
+    reply = packet.reply;
+    return true;
+  }
+}
+
+#endif //MOCK_ASYNCUDP_H
@@ -0,0 +1,10 @@
+#ifndef MOCK_DNSSERVER_H
+#define MOCK_DNSSERVER_H
+
+// DNSServer Mock
+// **************
+// Type only, the captive portal isn't built on the host.
+
+class DNSServer {};
+
+#endif //MOCK_DNSSERVER_H
@@ -0,0 +1,119 @@
+#ifndef MOCK_ESPASYNCWEBSERVER_H
+#define MOCK_ESPASYNCWEBSERVER_H
+
+// ESPAsyncWebServer Mock
+// **********************
+// Websocket only. Clients record the frames sent to them, tests connect them and deliver
+// messages through the event handler like the async_tcp task would.
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <functional>
+#include <vector>
+
+typedef enum { WS_CONTINUATION, WS_TEXT, WS_BINARY, WS_DISCONNECT = 0x08, WS_PING, WS_PONG } AwsFrameType;
+
+typedef struct {
+  uint8_t message_opcode;     // Opcode of the message, of the first frame
+  uint32_t num;               // Frame number of a fragmented message
+  uint8_t final;              // Last frame of the message
+  uint8_t masked;
+  uint8_t opcode;             // Opcode of this frame, WS_CONTINUATION after the first one
+  uint64_t len;               // Length of this frame
+  uint8_t mask[4];
+  uint64_t index;             // Offset of the data in this frame
+} AwsFrameInfo;
+
+typedef enum { WS_EVT_CONNECT, WS_EVT_DISCONNECT, WS_EVT_PONG, WS_EVT_ERROR, WS_EVT_DATA } AwsEventType;
+
+class AsyncWebServer;
+class AsyncWebSocket;
+
+class AsyncWebSocketClient {
+public:
+  // Frame sent to the client
+  struct Sent {
+    bool binary;
+    std::string data;
+  };
+
+  std::vector<Sent> sent;
+  size_t queue_len = 0;               // Set by tests to simulate a slow client
+  size_t queue_size = 32;
+
+  AsyncWebSocketClient(const uint32_t id) : client_id(id) {}
+
+  uint32_t id() const { return client_id; }
+  String remoteIP() const { return "127.0.0.1"; }
+  size_t queueLen() const { return queue_len; }
+  bool queueIsFull() const { return queue_len >= queue_size; }
+
+  void text(const char* message, size_t len) { sent.push_back({false, std::string(message, len)}); }
+  void text(const char* message) { text(message, strlen(message)); }
+  void text(const String &message) { text(message.c_str(), message.length()); }
+  void binary(const uint8_t* data, size_t len) { sent.push_back({true, std::string((const char*) data, len)}); }
+
+  // => Text frames sent since the last call, binary frames are skipped
+  std::vector<std::string> takeText() {
+    std::vector<std::string> texts;
+    for (const Sent &frame : sent) {
+      if (!frame.binary) { texts.push_back(frame.data); }
+    }
+    sent.clear();
+    return texts;
+  }
+
+private:
+  uint32_t client_id;
+};
+
+typedef std::function<void(AsyncWebSocket* server, AsyncWebSocketClient* client, AwsEventType type,
+                           void* arg, uint8_t* data, size_t len)> AwsEventHandler;
+
+class AsyncWebSocket {
+public:
+  AsyncWebSocket(const char* url) {}
+
+  void onEvent(AwsEventHandler handler) { event_handler = handler; }
+
+  AsyncWebSocketClient* client(uint32_t id) {
+    for (AsyncWebSocketClient* client : clients) {
+      if (client->id() == id) { return client; }
+    }
+    return nullptr;
+  }
+
+  void textAll(const char* message) {
+    for (AsyncWebSocketClient* client : clients) { client->text(message); }
+  }
+  void textAll(const String &message) { textAll(message.c_str()); }
+
+  // => Mock: connect a client, raises WS_EVT_CONNECT
+  void connect(AsyncWebSocketClient* client) {
+    clients.push_back(client);
+    event_handler(this, client, WS_EVT_CONNECT, nullptr, nullptr, 0);
+  }
+
+  // => Mock: disconnect a client, raises WS_EVT_DISCONNECT
+  void disconnect(AsyncWebSocketClient* client) {
+    clients.erase(std::remove(clients.begin(), clients.end(), client), clients.end());
+    event_handler(this, client, WS_EVT_DISCONNECT, nullptr, nullptr, 0);
+  }
+
+  // => Mock: deliver a text message from a client as a single frame, raises WS_EVT_DATA
+  void receive(AsyncWebSocketClient* client, const char* message) {
+    AwsFrameInfo info = {};
+    info.message_opcode = WS_TEXT;
+    info.opcode = WS_TEXT;
+    info.final = 1;
+    info.len = strlen(message);
+    std::vector<uint8_t> data(message, message + info.len);
+    event_handler(this, client, WS_EVT_DATA, &info, data.data(), data.size());
+  }
+
+private:
+  AwsEventHandler event_handler;
+  std::vector<AsyncWebSocketClient*> clients;
+};
+
+#endif //MOCK_ESPASYNCWEBSERVER_H
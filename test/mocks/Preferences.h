@@ -0,0 +1,97 @@
+#ifndef MOCK_PREFERENCES_H
+#define MOCK_PREFERENCES_H
+
+// Preferences Mock
+// ****************
+// Namespaces live in memory for the run of a test, writes are counted.
+
+#include <Arduino.h>
+#include <map>
+#include <vector>
+
+namespace Mock {
+  // Stored values by namespace and key
+  inline std::map<std::string, std::map<std::string, std::vector<uint8_t>>> nvs;
+
+  // Number of put calls, each one a flash write on the device
+  inline uint32_t nvs_writes = 0;
+}
+
+class Preferences {
+private:
+  std::string name;
+  bool read_only = true;
+  bool is_open = false;
+
+  // => Store raw bytes under key
+  size_t put(const char* key, const void* value, const size_t len) {
+    if (!is_open || read_only) {
+      return 0;
+    }
+    const uint8_t* bytes = (const uint8_t*) value;
+    Mock::nvs[name][key].assign(bytes, bytes + len);
+    Mock::nvs_writes++;
+    return len;
+  }
+
+  // => Copy raw bytes of key, returns false if it doesn't exist or has another size
+  bool get(const char* key, void* value, const size_t len) const {
+    auto space = Mock::nvs.find(name);
+    if (!is_open || space == Mock::nvs.end()) {
+      return false;
+    }
+    auto entry = space->second.find(key);
+    if (entry == space->second.end() || entry->second.size() != len) {
+      return false;
+    }
+    memcpy(value, entry->second.data(), len);
+    return true;
+  }
+
+public:
+  // => Open namespace, read-only namespaces must exist
+  bool begin(const char* space, bool read_only_mode = false) {
+    name = space;
+    read_only = read_only_mode;
+    if (read_only && Mock::nvs.find(name) == Mock::nvs.end()) {
+      return false;
+    }
+    Mock::nvs[name];
+    is_open = true;
+    return true;
+  }
+  void end() { is_open = false; }
+  bool clear() {
+    if (!is_open || read_only) { return false; }
+    Mock::nvs[name].clear();
+    return true;
+  }
+  bool isKey(const char* key) const {
+    auto space = Mock::nvs.find(name);
+    return is_open && space != Mock::nvs.end() && space->second.count(key);
+  }
+
+  size_t putFloat(const char* key, float value) { return put(key, &value, sizeof(value)); }
+  size_t putInt(const char* key, int32_t value) { return put(key, &value, sizeof(value)); }
+  size_t putUInt(const char* key, uint32_t value) { return put(key, &value, sizeof(value)); }
+  size_t putULong(const char* key, uint32_t value) { return put(key, &value, sizeof(value)); }
+  size_t putBool(const char* key, bool value) { return put(key, &value, sizeof(value)); }
+  size_t putBytes(const char* key, const void* value, size_t len) { return put(key, value, len); }
+  size_t putString(const char* key, const String &value) { return put(key, value.c_str(), value.length() + 1); }
+
+  float getFloat(const char* key, float value = 0.0f) const { get(key, &value, sizeof(value)); return value; }
+  int32_t getInt(const char* key, int32_t value = 0) const { get(key, &value, sizeof(value)); return value; }
+  uint32_t getUInt(const char* key, uint32_t value = 0) const { get(key, &value, sizeof(value)); return value; }
+  uint32_t getULong(const char* key, uint32_t value = 0) const { get(key, &value, sizeof(value)); return value; }
+  bool getBool(const char* key, bool value = false) const { get(key, &value, sizeof(value)); return value; }
+  size_t getBytes(const char* key, void* buffer, size_t len) const { return get(key, buffer, len) ? len : 0; }
+  String getString(const char* key, const String &value = String()) const {
+    auto space = Mock::nvs.find(name);
+    if (!is_open || space == Mock::nvs.end() || !space->second.count(key)) {
+      return value;
+    }
+    return String((const char*) space->second.at(key).data());
+  }
+};
+
+#endif //MOCK_PREFERENCES_H
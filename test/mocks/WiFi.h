@@ -0,0 +1,18 @@
+#ifndef MOCK_WIFI_H
+#define MOCK_WIFI_H
+
+// WiFi Mock
+// *********
+// Always connected, with a fixed signal strength.
+
+#include <Arduino.h>
+
+class WiFiClass {
+public:
+  bool isConnected() { return true; }
+  int8_t RSSI() { return -60; }
+};
+
+inline WiFiClass WiFi;
+
+#endif //MOCK_WIFI_H
@@ -0,0 +1,128 @@
+#include <unity.h>
+#include <random>
+
+#include <AngleEstimator.h>
+
+// ADC sample period at 475 SPS, in µs
+#define SAMPLE_US 2105UL
+// ADC noise of the rotor model, in °
+#define NOISE_DEG 0.06f
+
+using Rotor::AngleEstimator;
+
+AngleEstimator* estimator;
+std::mt19937 rng;
+std::normal_distribution<float> noise(0.0f, NOISE_DEG);
+unsigned long now_us;
+
+void setUp() {
+  estimator = new AngleEstimator();
+  rng.seed(1);
+  now_us = 1000000;
+}
+
+void tearDown() {
+  delete estimator;
+}
+
+// => Feed a noisy measurement of the true angle and advance time by a sample period
+bool feed(const float true_angle, const float noise_deg = NOISE_DEG) {
+  const bool accepted = estimator->update(true_angle + noise(rng) * noise_deg / NOISE_DEG, now_us);
+  now_us += SAMPLE_US;
+  return accepted;
+}
+
+void test_noise_at_rest() {
+  for (int i = 0; i < 2000; ++i) {
+    feed(180.0f);
+  }
+  TEST_ASSERT_FLOAT_WITHIN(0.05f, 180.0f, estimator->angle);
+  TEST_ASSERT_FLOAT_WITHIN(0.3f, 0.0f, estimator->angular_speed);
+  TEST_ASSERT_FLOAT_WITHIN(0.03f, NOISE_DEG, estimator->getNoise());
+  TEST_ASSERT_EQUAL_UINT32(0, estimator->n_rejected);
+  TEST_ASSERT_GREATER_THAN(0.9f, estimator->confidence);
+}
+
+void test_spike_rejected() {
+  for (int i = 0; i < 500; ++i) {
+    feed(90.0f);
+  }
+  TEST_ASSERT_FALSE(feed(110.0f, 0.0f));
+  TEST_ASSERT_FLOAT_WITHIN(0.1f, 90.0f, estimator->angle);
+  for (int i = 0; i < 100; ++i) {
+    feed(90.0f);
+  }
+  TEST_ASSERT_EQUAL_UINT32(1, estimator->n_rejected);
+  TEST_ASSERT_EQUAL_UINT32(0, estimator->n_resets);
+}
+
+void test_step_at_rest() {
+  for (int i = 0; i < 500; ++i) {
+    feed(90.0f);
+  }
+
+  // A lasting jump is taken after a few rejects
+  for (int i = 0; i < 500; ++i) {
+    feed(120.0f);
+  }
+  TEST_ASSERT_FLOAT_WITHIN(0.1f, 120.0f, estimator->angle);
+  TEST_ASSERT_FLOAT_WITHIN(0.3f, 0.0f, estimator->angular_speed);
+  TEST_ASSERT_EQUAL_UINT32(1, estimator->n_resets);
+}
+
+void test_constant_speed() {
+  float angle = 10.0f;
+  const float speed = 6.0f;
+  for (int i = 0; i < 2000; ++i) {
+    feed(angle);
+    angle += speed * SAMPLE_US / 1e6f;
+  }
+  TEST_ASSERT_FLOAT_WITHIN(0.3f, speed, estimator->angular_speed);
+  TEST_ASSERT_FLOAT_WITHIN(0.2f, angle - speed * SAMPLE_US / 1e6f, estimator->angle);
+  TEST_ASSERT_EQUAL_UINT32(0, estimator->n_resets);
+}
+
+void test_fast_acceleration() {
+  // Start from rest, then accelerate hard to a high speed
+  float angle = 10.0f;
+  float speed = 0.0f;
+  for (int i = 0; i < 500; ++i) {
+    feed(angle);
+  }
+  for (int i = 0; i < 1500; ++i) {
+    speed = min(speed + 400.0f * SAMPLE_US / 1e6f, 120.0f);
+    angle += speed * SAMPLE_US / 1e6f;
+    feed(angle);
+  }
+  TEST_ASSERT_EQUAL_UINT32(0, estimator->n_resets);
+  TEST_ASSERT_FLOAT_WITHIN(1.0f, speed, estimator->angular_speed);
+}
+
+void test_step_while_rotating() {
+  // A jump during rotation keeps the speed estimate
+  float angle = 10.0f;
+  const float speed = 6.0f;
+  for (int i = 0; i < 2000; ++i) {
+    feed(angle);
+    angle += speed * SAMPLE_US / 1e6f;
+  }
+  angle += 20.0f;
+  for (int i = 0; i < 20; ++i) {
+    feed(angle);
+    angle += speed * SAMPLE_US / 1e6f;
+  }
+  TEST_ASSERT_EQUAL_UINT32(1, estimator->n_resets);
+  TEST_ASSERT_FLOAT_WITHIN(0.5f, speed, estimator->angular_speed);
+  TEST_ASSERT_FLOAT_WITHIN(0.3f, angle - speed * SAMPLE_US / 1e6f, estimator->angle);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_noise_at_rest);
+  RUN_TEST(test_spike_rejected);
+  RUN_TEST(test_step_at_rest);
+  RUN_TEST(test_constant_speed);
+  RUN_TEST(test_fast_acceleration);
+  RUN_TEST(test_step_while_rotating);
+  return UNITY_END();
+}
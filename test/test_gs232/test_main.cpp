@@ -0,0 +1,153 @@
+#include <unity.h>
+#include <string>
+#include <vector>
+
+#include <RotorController.h>    // Exposes Global: rotor_ctrl
+#include <GS232.h>
+
+// Commands handed on by the parser, instead of the control task
+std::vector<Rotor::Command> posted;
+
+bool capture(const Rotor::Command &cmd) {
+  posted.push_back(cmd);
+  return true;
+}
+
+GS232::LineBuffer buffer;
+std::string responses;
+
+void setUp() {
+  posted.clear();
+  buffer = GS232::LineBuffer();
+  responses.clear();
+}
+
+void tearDown() {}
+
+// => Feed received bytes like UART input or a TCP segment, collects the responses
+void feed(const std::string &data) {
+  GS232::feed(buffer, data.data(), data.size(), capture, [](void* ctx, const char* response) {
+    *(std::string*) ctx += response;
+  }, &responses);
+}
+
+void test_turn_to_azimuth() {
+  feed("W123 045\r");
+  TEST_ASSERT_EQUAL_STRING("", responses.c_str());
+  TEST_ASSERT_EQUAL_UINT32(1, posted.size());
+  TEST_ASSERT_TRUE(posted[0].type == Rotor::CommandType::ROTATE_TO);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 123.0f, posted[0].values[0]);
+  TEST_ASSERT_NOT_EQUAL(0, posted[0].rx_us);
+
+  feed("M450\rw 090\r");
+  TEST_ASSERT_EQUAL_UINT32(3, posted.size());
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 450.0f, posted[1].values[0]);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 90.0f, posted[2].values[0]);
+}
+
+void test_turn_to_invalid_azimuth() {
+  feed("W451 000\rW12\rMabc\rW\r");
+  TEST_ASSERT_EQUAL_STRING("?>\r\n?>\r\n?>\r\n?>\r\n", responses.c_str());
+  TEST_ASSERT_EQUAL_UINT32(0, posted.size());
+}
+
+void test_speed() {
+  feed("X1\rX4\r");
+  TEST_ASSERT_EQUAL_UINT32(2, posted.size());
+  TEST_ASSERT_TRUE(posted[0].type == Rotor::CommandType::SET_SPEED);
+  TEST_ASSERT_EQUAL_UINT8(25, posted[0].speed);
+  TEST_ASSERT_EQUAL_UINT8(100, posted[1].speed);
+
+  feed("X0\rX5\rX\r");
+  TEST_ASSERT_EQUAL_STRING("?>\r\n?>\r\n?>\r\n", responses.c_str());
+  TEST_ASSERT_EQUAL_UINT32(2, posted.size());
+}
+
+void test_position() {
+  feed("C\rC2\r");
+  #ifdef GS232_A
+  TEST_ASSERT_EQUAL_STRING("+0000\r\n+0000+0000\r\n", responses.c_str());
+  #else
+  TEST_ASSERT_EQUAL_STRING("AZ=000\r\nAZ=000  EL=000\r\n", responses.c_str());
+  #endif
+  TEST_ASSERT_EQUAL_UINT32(0, posted.size());
+}
+
+void test_rotate_and_stop() {
+  feed("R\rL\rA\rS\r");
+  TEST_ASSERT_EQUAL_STRING("", responses.c_str());
+  TEST_ASSERT_EQUAL_UINT32(4, posted.size());
+  TEST_ASSERT_TRUE(posted[0].type == Rotor::CommandType::ROTATE);
+  TEST_ASSERT_EQUAL_UINT8(1, posted[0].direction);
+  TEST_ASSERT_EQUAL_UINT8(0, posted[1].direction);
+  TEST_ASSERT_TRUE(posted[2].type == Rotor::CommandType::STOP);
+  TEST_ASSERT_TRUE(posted[3].type == Rotor::CommandType::STOP);
+}
+
+void test_unknown_command() {
+  feed("Z\r");
+  TEST_ASSERT_EQUAL_STRING("?>\r\n", responses.c_str());
+}
+
+void test_command_in_pieces() {
+  feed("W1");
+  feed("80 0");
+  TEST_ASSERT_EQUAL_UINT32(0, posted.size());
+  feed("00\r\n");
+  TEST_ASSERT_EQUAL_UINT32(1, posted.size());
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 180.0f, posted[0].values[0]);
+  TEST_ASSERT_EQUAL_STRING("", responses.c_str());
+}
+
+void test_overlong_line() {
+  feed("W090 " + std::string(GS232_LINE_SIZE * 2, '0') + "\r");
+  TEST_ASSERT_EQUAL_STRING("?>\r\n", responses.c_str());
+  TEST_ASSERT_EQUAL_UINT32(0, posted.size());
+
+  // Next command is handled again
+  feed("S\r");
+  TEST_ASSERT_EQUAL_UINT32(1, posted.size());
+}
+
+void test_serial_port() {
+  GS232::init();
+  Serial2.record_tx = true;
+
+  // Nothing pending, doesn't wait
+  GS232::pollSerial();
+  TEST_ASSERT_EQUAL_UINT32(0, Serial2.tx.size());
+
+  // Read by the loop, applied by the control task
+  Serial2.rx = "M090\rC";
+  GS232::pollSerial();
+  rotor_ctrl.tick();
+  TEST_ASSERT_TRUE(rotor_ctrl.getSnapshot().is_auto_rotating);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 90.0f, rotor_ctrl.getSnapshot().target);
+  TEST_ASSERT_EQUAL_STRING("", Serial2.tx.c_str());
+
+  Serial2.rx = "\rS\r";
+  GS232::pollSerial();
+  rotor_ctrl.tick();
+  TEST_ASSERT_FALSE(rotor_ctrl.getSnapshot().is_rotating);
+  #ifdef GS232_A
+  TEST_ASSERT_EQUAL_STRING("+0000\r\n", Serial2.tx.c_str());
+  #else
+  TEST_ASSERT_EQUAL_STRING("AZ=000\r\n", Serial2.tx.c_str());
+  #endif
+}
+
+int main(int argc, char** argv) {
+  Mock::now_us = 1000000;
+  rotor_ctrl.init();
+  UNITY_BEGIN();
+  RUN_TEST(test_turn_to_azimuth);
+  RUN_TEST(test_turn_to_invalid_azimuth);
+  RUN_TEST(test_speed);
+  RUN_TEST(test_position);
+  RUN_TEST(test_rotate_and_stop);
+  RUN_TEST(test_unknown_command);
+  RUN_TEST(test_command_in_pieces);
+  RUN_TEST(test_overlong_line);
+  RUN_TEST(test_serial_port);
+  return UNITY_END();
+}
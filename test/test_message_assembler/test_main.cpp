@@ -0,0 +1,130 @@
+#include <unity.h>
+#include <string>
+
+#include <MessageAssembler.h>
+
+using namespace RotorSocket;
+
+MessageAssembler* assembler;
+
+void setUp() {
+  assembler = new MessageAssembler();
+}
+
+void tearDown() {
+  delete assembler;
+}
+
+// => Feed a frame of a message as websocket events would, split into TCP segments of at most segment bytes.
+// Returns the message once complete, "" while pieces are missing or if dropped.
+std::string feedFrame(int8_t &slot, const uint32_t num, const uint8_t message_opcode, const bool final,
+                      const std::string &frame, const size_t segment = SIZE_MAX) {
+  AwsFrameInfo info = {};
+  info.message_opcode = message_opcode;
+  info.num = num;
+  info.final = final;
+  info.opcode = num == 0 ? message_opcode : WS_CONTINUATION;
+  info.len = frame.size();
+
+  std::string msg;
+  for (size_t index = 0; index < frame.size(); index += segment) {
+    // Room for the terminating null, like the library's receive buffer
+    std::string piece = frame.substr(index, segment);
+    piece.push_back('\0');
+    info.index = index;
+    size_t msg_len = 0;
+    char* result = assembler->feed(slot, info, (uint8_t*) &piece[0], piece.size() - 1, msg_len);
+    if (result != nullptr) {
+      msg.assign(result, msg_len);
+    }
+  }
+  return msg;
+}
+
+void test_single_frame() {
+  int8_t slot = -1;
+  TEST_ASSERT_EQUAL_STRING("ROTOR|{\"angle\":90}", feedFrame(slot, 0, WS_TEXT, true, "ROTOR|{\"angle\":90}").c_str());
+  TEST_ASSERT_EQUAL_INT8(-1, slot);
+  TEST_ASSERT_EQUAL_UINT32(0, assembler->stats.n_messages);
+}
+
+void test_three_fragments() {
+  int8_t slot = -1;
+  TEST_ASSERT_EQUAL_STRING("", feedFrame(slot, 0, WS_TEXT, false, "ROTOR|").c_str());
+  TEST_ASSERT_EQUAL_STRING("", feedFrame(slot, 1, WS_TEXT, false, "{\"angle\"").c_str());
+  TEST_ASSERT_EQUAL_STRING("ROTOR|{\"angle\":90}", feedFrame(slot, 2, WS_TEXT, true, ":90}").c_str());
+  TEST_ASSERT_EQUAL_INT8(-1, slot);
+  TEST_ASSERT_EQUAL_UINT32(1, assembler->stats.n_messages);
+  TEST_ASSERT_EQUAL_UINT32(18, assembler->stats.max_size);
+}
+
+void test_fragments_in_segments() {
+  int8_t slot = -1;
+  TEST_ASSERT_EQUAL_STRING("", feedFrame(slot, 0, WS_TEXT, false, "ROTOR|{\"an", 4).c_str());
+  TEST_ASSERT_EQUAL_STRING("", feedFrame(slot, 1, WS_TEXT, false, "gle\":1", 4).c_str());
+  TEST_ASSERT_EQUAL_STRING("ROTOR|{\"angle\":123}", feedFrame(slot, 2, WS_TEXT, true, "23}", 2).c_str());
+  TEST_ASSERT_EQUAL_UINT32(1, assembler->stats.n_messages);
+}
+
+void test_single_frame_in_segments() {
+  int8_t slot = -1;
+  TEST_ASSERT_EQUAL_STRING("LOCK|{\"lock\":true}", feedFrame(slot, 0, WS_TEXT, true, "LOCK|{\"lock\":true}", 5).c_str());
+  TEST_ASSERT_EQUAL_INT8(-1, slot);
+}
+
+void test_binary_ignored() {
+  int8_t slot = -1;
+  TEST_ASSERT_EQUAL_STRING("", feedFrame(slot, 0, WS_BINARY, true, "abc").c_str());
+  TEST_ASSERT_EQUAL_STRING("", feedFrame(slot, 0, WS_BINARY, false, "abc").c_str());
+  TEST_ASSERT_EQUAL_STRING("", feedFrame(slot, 1, WS_BINARY, true, "def").c_str());
+  TEST_ASSERT_EQUAL_INT8(-1, slot);
+  TEST_ASSERT_EQUAL_UINT32(0, assembler->stats.n_messages);
+}
+
+void test_too_large_dropped() {
+  int8_t slot = -1;
+  const std::string half(SOCKET_MAX_MESSAGE_SIZE / 2 + 1, 'x');
+  TEST_ASSERT_EQUAL_STRING("", feedFrame(slot, 0, WS_TEXT, false, half).c_str());
+  TEST_ASSERT_EQUAL_STRING("", feedFrame(slot, 1, WS_TEXT, true, half).c_str());
+  TEST_ASSERT_EQUAL_INT8(-1, slot);
+  TEST_ASSERT_EQUAL_UINT32(1, assembler->stats.n_too_large);
+
+  // Next message is received again
+  TEST_ASSERT_EQUAL_STRING("", feedFrame(slot, 0, WS_TEXT, false, "A|").c_str());
+  TEST_ASSERT_EQUAL_STRING("A|{}", feedFrame(slot, 1, WS_TEXT, true, "{}").c_str());
+}
+
+void test_no_slot() {
+  int8_t slots[SOCKET_REASSEMBLY_SLOTS + 1];
+  for (int8_t &slot : slots) {
+    slot = -1;
+    feedFrame(slot, 0, WS_TEXT, false, "A|");
+  }
+  TEST_ASSERT_EQUAL_INT8(-1, slots[SOCKET_REASSEMBLY_SLOTS]);
+  TEST_ASSERT_EQUAL_UINT32(1, assembler->stats.n_no_slot);
+
+  // Continuation of the dropped message is ignored, the others complete
+  TEST_ASSERT_EQUAL_STRING("", feedFrame(slots[SOCKET_REASSEMBLY_SLOTS], 1, WS_TEXT, true, "{}").c_str());
+  TEST_ASSERT_EQUAL_STRING("A|{}", feedFrame(slots[0], 1, WS_TEXT, true, "{}").c_str());
+  TEST_ASSERT_EQUAL_UINT8(SOCKET_REASSEMBLY_SLOTS, assembler->stats.max_slots_used);
+}
+
+void test_unfinished_message_replaced() {
+  int8_t slot = -1;
+  feedFrame(slot, 0, WS_TEXT, false, "OLD|");
+  TEST_ASSERT_EQUAL_STRING("", feedFrame(slot, 0, WS_TEXT, false, "NEW|").c_str());
+  TEST_ASSERT_EQUAL_STRING("NEW|{}", feedFrame(slot, 1, WS_TEXT, true, "{}").c_str());
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_single_frame);
+  RUN_TEST(test_three_fragments);
+  RUN_TEST(test_fragments_in_segments);
+  RUN_TEST(test_single_frame_in_segments);
+  RUN_TEST(test_binary_ignored);
+  RUN_TEST(test_too_large_dropped);
+  RUN_TEST(test_no_slot);
+  RUN_TEST(test_unfinished_message_replaced);
+  return UNITY_END();
+}
@@ -0,0 +1,171 @@
+#include <unity.h>
+#include <string>
+#include <vector>
+
+#include <RotorController.h>    // Exposes Global: rotor_ctrl
+#include <Rotctld.h>
+
+// Commands handed on by the parser, instead of the control task
+std::vector<Rotor::Command> posted;
+bool accept_commands = true;
+
+bool capture(const Rotor::Command &cmd) {
+  posted.push_back(cmd);
+  return accept_commands;
+}
+
+Rotctld::LineBuffer buffer;
+std::string responses;
+bool keep_open;
+
+void setUp() {
+  posted.clear();
+  accept_commands = true;
+  buffer = Rotctld::LineBuffer();
+  responses.clear();
+  keep_open = true;
+}
+
+void tearDown() {}
+
+// => Feed received bytes like a TCP segment, collects the responses
+void feed(const std::string &data) {
+  keep_open = Rotctld::feed(buffer, data.data(), data.size(), capture, [](void* ctx, const char* response) {
+    *(std::string*) ctx += response;
+  }, &responses);
+}
+
+void test_set_pos() {
+  feed("P 123.5 0\n");
+  TEST_ASSERT_EQUAL_STRING("RPRT 0\n", responses.c_str());
+  TEST_ASSERT_EQUAL_UINT32(1, posted.size());
+  TEST_ASSERT_TRUE(posted[0].type == Rotor::CommandType::ROTATE_TO);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 123.5f, posted[0].values[0]);
+  TEST_ASSERT_NOT_EQUAL(0, posted[0].rx_us);
+}
+
+void test_set_pos_long_form_negative_azimuth() {
+  feed("\\set_pos -90 10\n");
+  TEST_ASSERT_EQUAL_STRING("RPRT 0\n", responses.c_str());
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 270.0f, posted[0].values[0]);
+}
+
+void test_set_pos_bounds() {
+  feed("P 360 0\nP -180 0\n");
+  TEST_ASSERT_EQUAL_STRING("RPRT 0\nRPRT 0\n", responses.c_str());
+  TEST_ASSERT_EQUAL_UINT32(2, posted.size());
+
+  responses.clear();
+  feed("P 360.1 0\nP -180.1 0\nP abc 0\nP 100\nP\n");
+  TEST_ASSERT_EQUAL_STRING("RPRT -1\nRPRT -1\nRPRT -1\nRPRT -1\nRPRT -1\n", responses.c_str());
+  TEST_ASSERT_EQUAL_UINT32(2, posted.size());
+}
+
+void test_stop() {
+  feed("S\n");
+  TEST_ASSERT_EQUAL_STRING("RPRT 0\n", responses.c_str());
+  TEST_ASSERT_TRUE(posted[0].type == Rotor::CommandType::STOP);
+}
+
+void test_rejected_command() {
+  accept_commands = false;
+  feed("S\n");
+  TEST_ASSERT_EQUAL_STRING("RPRT -9\n", responses.c_str());
+}
+
+void test_move_with_speed() {
+  feed("M 16 40\n");
+  TEST_ASSERT_EQUAL_STRING("RPRT 0\n", responses.c_str());
+  TEST_ASSERT_EQUAL_UINT32(2, posted.size());
+  TEST_ASSERT_TRUE(posted[0].type == Rotor::CommandType::SET_SPEED);
+  TEST_ASSERT_EQUAL_UINT8(40, posted[0].speed);
+  TEST_ASSERT_TRUE(posted[1].type == Rotor::CommandType::ROTATE);
+  TEST_ASSERT_EQUAL_UINT8(1, posted[1].direction);
+}
+
+void test_move_bounds() {
+  // Speed out of range or missing keeps the speed
+  feed("M 8 0\nM 8 101\n\\move 8\n");
+  TEST_ASSERT_EQUAL_STRING("RPRT 0\nRPRT 0\nRPRT 0\n", responses.c_str());
+  TEST_ASSERT_EQUAL_UINT32(3, posted.size());
+  for (const Rotor::Command &cmd : posted) {
+    TEST_ASSERT_TRUE(cmd.type == Rotor::CommandType::ROTATE);
+    TEST_ASSERT_EQUAL_UINT8(0, cmd.direction);
+  }
+
+  // No elevation, unknown directions
+  responses.clear();
+  feed("M 2 50\nM 4\nM 5 50\nM\n");
+  TEST_ASSERT_EQUAL_STRING("RPRT -4\nRPRT -4\nRPRT -1\nRPRT -1\n", responses.c_str());
+  TEST_ASSERT_EQUAL_UINT32(3, posted.size());
+}
+
+void test_get_pos_and_info() {
+  feed("p\n_\n");
+  TEST_ASSERT_EQUAL_STRING("0.000000\n0.000000\nRotorControl\n", responses.c_str());
+  TEST_ASSERT_EQUAL_UINT32(0, posted.size());
+}
+
+void test_dump_state() {
+  feed("\\dump_state\n");
+  TEST_ASSERT_NOT_NULL(strstr(responses.c_str(), "max_az=360.000000\n"));
+  TEST_ASSERT_NOT_NULL(strstr(responses.c_str(), "done\n"));
+}
+
+void test_unknown_command() {
+  feed("Z 1\n");
+  TEST_ASSERT_EQUAL_STRING("RPRT -4\n", responses.c_str());
+}
+
+void test_line_in_segments() {
+  feed("P 1");
+  feed("0 ");
+  TEST_ASSERT_EQUAL_STRING("", responses.c_str());
+  feed("0\r\n");
+  TEST_ASSERT_EQUAL_STRING("RPRT 0\n", responses.c_str());
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 10.0f, posted[0].values[0]);
+}
+
+void test_overlong_line() {
+  feed("P " + std::string(ROTCTLD_LINE_SIZE * 2, '1') + " 0\n");
+  TEST_ASSERT_EQUAL_STRING("RPRT -1\n", responses.c_str());
+  TEST_ASSERT_EQUAL_UINT32(0, posted.size());
+
+  // Next line is handled again
+  responses.clear();
+  feed("S\n");
+  TEST_ASSERT_EQUAL_STRING("RPRT 0\n", responses.c_str());
+}
+
+void test_quit() {
+  feed("S\nq\nS\n");
+  TEST_ASSERT_FALSE(keep_open);
+  TEST_ASSERT_EQUAL_STRING("RPRT 0\n", responses.c_str());
+  TEST_ASSERT_EQUAL_UINT32(1, posted.size());
+}
+
+void test_empty_lines_ignored() {
+  feed("\n\r\n  \n");
+  TEST_ASSERT_EQUAL_STRING("", responses.c_str());
+  TEST_ASSERT_TRUE(keep_open);
+}
+
+int main(int argc, char** argv) {
+  Mock::now_us = 1000000;
+  UNITY_BEGIN();
+  RUN_TEST(test_set_pos);
+  RUN_TEST(test_set_pos_long_form_negative_azimuth);
+  RUN_TEST(test_set_pos_bounds);
+  RUN_TEST(test_stop);
+  RUN_TEST(test_rejected_command);
+  RUN_TEST(test_move_with_speed);
+  RUN_TEST(test_move_bounds);
+  RUN_TEST(test_get_pos_and_info);
+  RUN_TEST(test_dump_state);
+  RUN_TEST(test_unknown_command);
+  RUN_TEST(test_line_in_segments);
+  RUN_TEST(test_overlong_line);
+  RUN_TEST(test_quit);
+  RUN_TEST(test_empty_lines_ignored);
+  return UNITY_END();
+}
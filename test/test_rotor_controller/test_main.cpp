@@ -0,0 +1,141 @@
+#include <unity.h>
+
+#include <Preferences.h>
+#include <RotorController.h>    // Exposes Global: rotor_ctrl
+
+void setUp() {}
+
+void tearDown() {}
+
+// => Read a float saved in PREFS
+float savedFloat(const char* space, const char* key) {
+  Preferences prefs;
+  prefs.begin(space, true);
+  const float value = prefs.getFloat(key, NAN);
+  prefs.end();
+  return value;
+}
+
+void test_calibration_saved_by_loop() {
+  const uint32_t n_writes = Mock::nvs_writes;
+
+  // Control task only applies the calibration
+  rotor_ctrl.setCalibration(0.1f, 4.4f, 5.0f, 440.0f);
+  rotor_ctrl.setAngleOffset(3);
+  TEST_ASSERT_EQUAL_UINT32(n_writes, Mock::nvs_writes);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 3.0f, rotor_ctrl.rotor.calibration.offset);
+
+  // Loop saves the last one, once
+  rotor_ctrl.savePending();
+  TEST_ASSERT_GREATER_THAN(n_writes, Mock::nvs_writes);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 4.4f, savedFloat("calPrefs", "u2"));
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 3.0f, savedFloat("calPrefs", "offset"));
+  const uint32_t n_saved = Mock::nvs_writes;
+  rotor_ctrl.savePending();
+  TEST_ASSERT_EQUAL_UINT32(n_saved, Mock::nvs_writes);
+}
+
+void test_coast_model_saved_rate_limited() {
+  Rotor::CoastModel model;
+  model.load();
+  const uint32_t n_writes = Mock::nvs_writes;
+
+  // Learning doesn't write, the loop saves at once
+  model.learn(50, 3.0f, 0.9f);
+  TEST_ASSERT_EQUAL_UINT32(n_writes, Mock::nvs_writes);
+  model.saveChanged();
+  const uint32_t n_saved = Mock::nvs_writes;
+  TEST_ASSERT_GREATER_THAN(n_writes, n_saved);
+
+  // Then at most once per interval
+  model.learn(50, 3.0f, 1.2f);
+  Mock::advance(COAST_SAVE_INTERVAL * 500);
+  model.saveChanged();
+  TEST_ASSERT_EQUAL_UINT32(n_saved, Mock::nvs_writes);
+  Mock::advance(COAST_SAVE_INTERVAL * 500);
+  model.saveChanged();
+  TEST_ASSERT_GREATER_THAN(n_saved, Mock::nvs_writes);
+
+  // Nothing learned, nothing saved
+  const uint32_t n_saved_again = Mock::nvs_writes;
+  Mock::advance(COAST_SAVE_INTERVAL * 1000);
+  model.saveChanged();
+  TEST_ASSERT_EQUAL_UINT32(n_saved_again, Mock::nvs_writes);
+
+  // Saved model predicts the same
+  Rotor::CoastModel loaded;
+  loaded.load();
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, model.predict(50, 3.0f), loaded.predict(50, 3.0f));
+}
+
+// => Post a command as received from a client at rx_us
+void postReceived(Rotor::Command cmd, const unsigned long rx_us) {
+  cmd.rx_us = rx_us;
+  rotor_ctrl.post(cmd);
+}
+
+void test_latency_recorded_when_applied() {
+  rotor_ctrl.setCalibration(0.0f, 4.5f, 0.0f, 450.0f);
+  const uint32_t n = rotor_ctrl.command_latency.n;
+
+  // Starting the rotor counts to the relay change
+  postReceived(Rotor::Command::rotateTo(300.0f, false, false), micros());
+  Mock::advance(3000);
+  rotor_ctrl.tick();
+  TEST_ASSERT_TRUE(rotor_ctrl.is_rotating);
+  TEST_ASSERT_EQUAL_UINT32(n + 1, rotor_ctrl.command_latency.n);
+
+  // New target while rotating doesn't switch the relays, but counts
+  postReceived(Rotor::Command::rotateTo(350.0f, false, false), micros());
+  Mock::advance(5000);
+  rotor_ctrl.tick();
+  TEST_ASSERT_TRUE(rotor_ctrl.is_rotating);
+  TEST_ASSERT_EQUAL_UINT32(n + 2, rotor_ctrl.command_latency.n);
+  TEST_ASSERT_GREATER_OR_EQUAL(5000, rotor_ctrl.command_latency.max_us);
+
+  // Commands of the device itself don't count
+  rotor_ctrl.post(Rotor::Command::stop());
+  rotor_ctrl.tick();
+  TEST_ASSERT_EQUAL_UINT32(n + 2, rotor_ctrl.command_latency.n);
+}
+
+void test_latency_bins() {
+  Rotor::LatencyHistogram latency;
+  latency.add(999);
+  latency.add(1000);
+  latency.add(200000);
+  TEST_ASSERT_EQUAL_UINT32(1, latency.bins[0]);
+  TEST_ASSERT_EQUAL_UINT32(1, latency.bins[1]);
+  TEST_ASSERT_EQUAL_UINT32(1, latency.bins[LATENCY_BINS - 1]);
+
+  // Last bin has no upper limit
+  TEST_ASSERT_EQUAL_INT32(1, Rotor::LatencyHistogram::binLimitMs(0));
+  TEST_ASSERT_EQUAL_INT32(1 << (LATENCY_BINS - 2), Rotor::LatencyHistogram::binLimitMs(LATENCY_BINS - 2));
+  TEST_ASSERT_EQUAL_INT32(-1, Rotor::LatencyHistogram::binLimitMs(LATENCY_BINS - 1));
+}
+
+void test_snapshot_stamped_with_sample_time() {
+  rotor_ctrl.tick();
+  Mock::advance(7000);
+  const unsigned long sample_us = micros();
+  rotor_ctrl.rotor.readConversion(sample_us);
+
+  // Consumed by a tick 23 ms later
+  Mock::advance(23000);
+  rotor_ctrl.tick();
+  const Rotor::Snapshot state = rotor_ctrl.getSnapshot();
+  TEST_ASSERT_EQUAL_UINT32(sample_us / 1000, state.ms);
+  TEST_ASSERT_EQUAL_UINT32(sample_us, rotor_ctrl.rotor.last_us);
+}
+
+int main(int argc, char** argv) {
+  Mock::now_us = 1000000;
+  rotor_ctrl.init();
+  UNITY_BEGIN();
+  RUN_TEST(test_calibration_saved_by_loop);
+  RUN_TEST(test_coast_model_saved_rate_limited);
+  RUN_TEST(test_latency_recorded_when_applied);
+  RUN_TEST(test_latency_bins);
+  RUN_TEST(test_snapshot_stamped_with_sample_time);
+  return UNITY_END();
+}
@@ -0,0 +1,284 @@
+#include <unity.h>
+#include <string>
+#include <vector>
+
+#include <globals.h>
+#include <RotorController.h>    // Exposes Global: rotor_ctrl
+#include <RotorSocket.h>        // Exposes Global: websocket
+#include <Settings.h>
+#include <SimpleFS.h>
+#include <Favorites.h>
+
+extern String lock_msg;
+extern bool use_screen;
+
+// Clients of a test, connected and greeted by setUp
+uint32_t next_client_id = 1;
+AsyncWebSocketClient* client_a = nullptr;
+AsyncWebSocketClient* client_b = nullptr;
+
+// => Connect a client and take its connect snapshot, sent by the loop
+AsyncWebSocketClient* connect(std::vector<std::string> *snapshot = nullptr) {
+  AsyncWebSocketClient* client = new AsyncWebSocketClient(next_client_id++);
+  websocket.connect(client);
+  TEST_ASSERT_EQUAL_UINT32(0, client->sent.size());
+  RotorSocket::greetNewClients();
+  const std::vector<std::string> texts = client->takeText();
+  if (snapshot != nullptr) {
+    *snapshot = texts;
+  }
+  return client;
+}
+
+// => Disconnect and free a client
+void disconnect(AsyncWebSocketClient* &client) {
+  websocket.disconnect(client);
+  delete client;
+  client = nullptr;
+}
+
+// => Run a loop cycle: apply commands and state messages, send acks and changes
+void loopCycle() {
+  rotor_ctrl.tick();
+  RotorSocket::applyPending();
+  RotorSocket::greetNewClients();
+  RotorSocket::sendAcks();
+  rotor_ctrl.messenger.flush();
+}
+
+// => Index of the first frame starting with prefix, -1 if none
+int find(const std::vector<std::string> &texts, const char* prefix) {
+  for (size_t i = 0; i < texts.size(); ++i) {
+    if (texts[i].rfind(prefix, 0) == 0) { return i; }
+  }
+  return -1;
+}
+
+void setUp() {
+  client_a = connect();
+  client_b = connect();
+}
+
+void tearDown() {
+  disconnect(client_a);
+  disconnect(client_b);
+}
+
+void test_connect_snapshot_sent_by_loop() {
+  std::vector<std::string> snapshot;
+  AsyncWebSocketClient* client = connect(&snapshot);
+
+  // One message per frame, lock first
+  TEST_ASSERT_GREATER_OR_EQUAL(5, snapshot.size());
+  TEST_ASSERT_EQUAL_INT(0, find(snapshot, MSG_ID_LOCK "|"));
+  TEST_ASSERT_GREATER_OR_EQUAL(0, find(snapshot, MSG_ID_SETTINGS "|"));
+  TEST_ASSERT_GREATER_OR_EQUAL(0, find(snapshot, MSG_ID_CALIBRATION "|"));
+  TEST_ASSERT_GREATER_OR_EQUAL(0, find(snapshot, MSG_ID_ROTOR "|"));
+  for (const std::string &text : snapshot) {
+    TEST_ASSERT_TRUE(text.find('\n') == std::string::npos);
+  }
+  disconnect(client);
+}
+
+void test_rotor_command_acknowledged() {
+  websocket.receive(client_a, "ROTOR|{\"rotation\":1,\"seq\":7}");
+  TEST_ASSERT_FALSE(rotor_ctrl.is_rotating);
+  loopCycle();
+  TEST_ASSERT_TRUE(rotor_ctrl.is_rotating);
+
+  const std::vector<std::string> texts = client_a->takeText();
+  const int ack = find(texts, MSG_ID_ACK "|{\"seq\":7,\"ok\":true");
+  TEST_ASSERT_GREATER_OR_EQUAL(0, ack);
+
+  // Other clients see the rotation, not the ack
+  const std::vector<std::string> other = client_b->takeText();
+  TEST_ASSERT_EQUAL_INT(-1, find(other, MSG_ID_ACK "|"));
+  TEST_ASSERT_GREATER_OR_EQUAL(0, find(other, MSG_ID_ROTOR "|{\"rotation\":1"));
+
+  websocket.receive(client_a, "ROTOR|{\"rotation\":0}");
+  loopCycle();
+  TEST_ASSERT_FALSE(rotor_ctrl.is_rotating);
+}
+
+void test_protocol_negotiation() {
+  websocket.receive(client_a, "PROTOCOL|{\"binary\":true,\"bundle\":true}");
+  const std::vector<std::string> texts = client_a->takeText();
+  TEST_ASSERT_EQUAL_INT(0, find(texts, MSG_ID_PROTOCOL "|{\"binary\":true,\"bundle\":true}"));
+  TEST_ASSERT_TRUE(RotorSocket::getClient(client_a->id())->binary);
+  TEST_ASSERT_TRUE(RotorSocket::getClient(client_a->id())->bundle);
+  TEST_ASSERT_FALSE(RotorSocket::getClient(client_b->id())->binary);
+}
+
+void test_malformed_messages_ignored() {
+  websocket.receive(client_a, "UNKNOWN|{}");
+  websocket.receive(client_a, "no separator");
+  websocket.receive(client_a, "|{}");
+  websocket.receive(client_a, "PROTOCOL|not json");
+  loopCycle();
+  TEST_ASSERT_EQUAL_INT(-1, find(client_a->takeText(), MSG_ID_PROTOCOL "|"));
+}
+
+void test_favorites_applied_by_loop() {
+  const char* msg = MSG_ID_FAVORITES "|[{\"name\":\"EU\",\"angle\":45}]";
+  websocket.receive(client_b, "SUBSCRIBE|{\"favorites\":false}");
+  client_b->takeText();
+
+  // Handler only hands the message over
+  websocket.receive(client_a, msg);
+  TEST_ASSERT_EQUAL_UINT32(0, client_a->sent.size());
+  TEST_ASSERT_EQUAL_UINT32(0, readFromFS(FAVORITES_PATH).length());
+
+  // Loop saves and sends it to subscribed clients
+  loopCycle();
+  TEST_ASSERT_EQUAL_STRING(msg, readFromFS(FAVORITES_PATH).c_str());
+  TEST_ASSERT_GREATER_OR_EQUAL(0, find(client_a->takeText(), msg));
+  TEST_ASSERT_EQUAL_INT(-1, find(client_b->takeText(), MSG_ID_FAVORITES "|"));
+
+  // Part of the connect snapshot from now on
+  std::vector<std::string> snapshot;
+  AsyncWebSocketClient* client = connect(&snapshot);
+  TEST_ASSERT_GREATER_OR_EQUAL(0, find(snapshot, msg));
+  disconnect(client);
+}
+
+void test_lock_distributed_by_loop() {
+  const char* msg = MSG_ID_LOCK "|{\"isLocked\":true,\"by\":\"A\"}";
+  websocket.receive(client_a, msg);
+  TEST_ASSERT_EQUAL_UINT32(0, client_b->sent.size());
+
+  loopCycle();
+  TEST_ASSERT_EQUAL_STRING(msg, lock_msg.c_str());
+  TEST_ASSERT_GREATER_OR_EQUAL(0, find(client_a->takeText(), msg));
+  TEST_ASSERT_GREATER_OR_EQUAL(0, find(client_b->takeText(), msg));
+
+  websocket.receive(client_a, MSG_ID_LOCK "|{\"isLocked\":false,\"by\":\"\"}");
+  loopCycle();
+}
+
+void test_other_transports_only_move_rotor() {
+  const String lock_before = lock_msg;
+  char lock[] = MSG_ID_LOCK "|{\"isLocked\":true,\"by\":\"broker\"}";
+  RotorSocket::receiveMessage(lock, strlen(lock));
+  char settings[] = MSG_ID_SETTINGS "|{\"useScreen\":false}";
+  RotorSocket::receiveMessage(settings, strlen(settings));
+  loopCycle();
+  TEST_ASSERT_TRUE(lock_before == lock_msg);
+  TEST_ASSERT_TRUE(use_screen);
+
+  char rotate[] = MSG_ID_ROTOR "|{\"rotation\":-1}";
+  RotorSocket::receiveMessage(rotate, strlen(rotate));
+  loopCycle();
+  TEST_ASSERT_TRUE(rotor_ctrl.is_rotating);
+  char stop[] = MSG_ID_ROTOR "|{\"rotation\":0}";
+  RotorSocket::receiveMessage(stop, strlen(stop));
+  loopCycle();
+  TEST_ASSERT_FALSE(rotor_ctrl.is_rotating);
+}
+
+void test_flush_merges_messages() {
+  websocket.receive(client_a, "PROTOCOL|{\"bundle\":true}");
+  client_a->takeText();
+
+  rotor_ctrl.messenger.sendNewRotation();
+  Settings::sendScreen();
+  rotor_ctrl.messenger.flush();
+
+  // One frame with both messages for the bundling client
+  const std::vector<std::string> bundled = client_a->takeText();
+  TEST_ASSERT_EQUAL_UINT32(1, bundled.size());
+  TEST_ASSERT_TRUE(bundled[0].rfind(MSG_ID_ROTOR "|", 0) == 0);
+  TEST_ASSERT_TRUE(bundled[0].find("\n" MSG_ID_SETTINGS "|{\"useScreen\":true}") != std::string::npos);
+
+  // One frame per message for the other
+  const std::vector<std::string> split = client_b->takeText();
+  TEST_ASSERT_EQUAL_UINT32(2, split.size());
+  TEST_ASSERT_EQUAL_INT(0, find(split, MSG_ID_ROTOR "|"));
+  TEST_ASSERT_EQUAL_INT(1, find(split, MSG_ID_SETTINGS "|"));
+}
+
+void test_binary_telemetry() {
+  websocket.receive(client_a, "PROTOCOL|{\"binary\":true}");
+  client_a->sent.clear();
+
+  rotor_ctrl.messenger.sendNewRotation();
+  rotor_ctrl.messenger.flush();
+  TEST_ASSERT_EQUAL_UINT32(1, client_a->sent.size());
+  TEST_ASSERT_TRUE(client_a->sent[0].binary);
+  TEST_ASSERT_EQUAL_UINT32(sizeof(Rotor::RotationFrame), client_a->sent[0].data.size());
+  TEST_ASSERT_EQUAL_UINT8(Rotor::FRAME_ROTATION, (uint8_t) client_a->sent[0].data[0]);
+  TEST_ASSERT_FALSE(client_b->sent[0].binary);
+}
+
+void test_subscription_filters_flush() {
+  websocket.receive(client_a, "SUBSCRIBE|{\"rotation\":false,\"speed\":false}");
+  const std::vector<std::string> reply = client_a->takeText();
+  TEST_ASSERT_EQUAL_INT(0, find(reply, MSG_ID_SUBSCRIBE "|{\"rotation\":false,\"speed\":false,"));
+
+  rotor_ctrl.messenger.sendNewRotation();
+  rotor_ctrl.messenger.flush();
+  TEST_ASSERT_EQUAL_UINT32(0, client_a->sent.size());
+  TEST_ASSERT_EQUAL_UINT32(1, client_b->sent.size());
+}
+
+void test_telemetry_held_back_for_slow_client() {
+  client_a->queue_len = TELEMETRY_MAX_QUEUED;
+  rotor_ctrl.messenger.sendNewRotation();
+  rotor_ctrl.messenger.flush();
+  TEST_ASSERT_EQUAL_UINT32(0, client_a->sent.size());
+  TEST_ASSERT_EQUAL_UINT32(1, client_b->sent.size());
+  TEST_ASSERT_TRUE(RotorSocket::getClient(client_a->id())->telemetry_stale);
+  TEST_ASSERT_FALSE(RotorSocket::hasStaleClients());
+
+  // Queue drained, the next flush catches up only this client
+  client_a->queue_len = 0;
+  client_b->sent.clear();
+  TEST_ASSERT_TRUE(RotorSocket::hasStaleClients());
+  rotor_ctrl.messenger.flush();
+  TEST_ASSERT_EQUAL_INT(0, find(client_a->takeText(), MSG_ID_ROTOR "|"));
+  TEST_ASSERT_EQUAL_UINT32(0, client_b->sent.size());
+  TEST_ASSERT_FALSE(RotorSocket::getClient(client_a->id())->telemetry_stale);
+}
+
+void test_ping_round_trip() {
+  RotorSocket::pingClients();
+  const std::vector<std::string> texts = client_a->takeText();
+  TEST_ASSERT_EQUAL_UINT32(1, texts.size());
+  const uint16_t ping_id = RotorSocket::getClient(client_a->id())->ping_id;
+  char pong[32];
+  snprintf(pong, sizeof(pong), MSG_ID_PONG "|{\"id\":%u}", ping_id);
+  TEST_ASSERT_EQUAL_STRING((std::string(MSG_ID_PING) + (pong + strlen(MSG_ID_PONG))).c_str(), texts[0].c_str());
+
+  Mock::advance(2500);
+  websocket.receive(client_a, pong);
+  TEST_ASSERT_EQUAL_UINT32(2500, RotorSocket::getClient(client_a->id())->rtt_us);
+  TEST_ASSERT_EQUAL_UINT32(1, RotorSocket::getClient(client_a->id())->n_pongs);
+}
+
+void test_diag_latency_bins() {
+  websocket.receive(client_a, MSG_ID_DIAG "|{}");
+  const std::vector<std::string> texts = client_a->takeText();
+  TEST_ASSERT_EQUAL_UINT32(1, texts.size());
+  TEST_ASSERT_TRUE(texts[0].find("\"binsMs\":[1,2,4,8,16,32,64,-1]") != std::string::npos);
+}
+
+int main(int argc, char** argv) {
+  Mock::now_us = 1000000;
+  rotor_ctrl.init();
+  rotor_ctrl.setCalibration(0.0f, 4.5f, 0.0f, 450.0f);
+  RotorSocket::initWebsocket();
+  UNITY_BEGIN();
+  RUN_TEST(test_connect_snapshot_sent_by_loop);
+  RUN_TEST(test_rotor_command_acknowledged);
+  RUN_TEST(test_protocol_negotiation);
+  RUN_TEST(test_malformed_messages_ignored);
+  RUN_TEST(test_favorites_applied_by_loop);
+  RUN_TEST(test_lock_distributed_by_loop);
+  RUN_TEST(test_other_transports_only_move_rotor);
+  RUN_TEST(test_flush_merges_messages);
+  RUN_TEST(test_binary_telemetry);
+  RUN_TEST(test_subscription_filters_flush);
+  RUN_TEST(test_telemetry_held_back_for_slow_client);
+  RUN_TEST(test_ping_round_trip);
+  RUN_TEST(test_diag_latency_bins);
+  return UNITY_END();
+}
@@ -0,0 +1,188 @@
+#include <unity.h>
+#include <chrono>
+
+#include <globals.h>
+#include <ControlTask.h>
+#include <Adafruit_ADS1X15.h>
+#include <RotorController.h>    // Exposes Global: rotor_ctrl
+#include <RotorSimulator.h>     // Exposes Global: rotor_sim
+
+// Randomized auto-rotations, can be overridden with build flags
+#ifndef SIMULATION_SCENARIOS
+#define SIMULATION_SCENARIOS 2000
+#endif
+
+#define SIM_ADC_PERIOD_US (1000000UL / 475)
+#define SIM_TICK_US (CONTROL_PERIOD_MS * 1000UL)
+// Give up on a scenario after this time, in ms. Slowest full turn takes about 400 s.
+#define SIM_SCENARIO_TIMEOUT 600000UL
+// Pause between scenarios, in ms
+#define SIM_PAUSE_MS 300
+
+
+// Simulation Harness
+// ******************
+// Runs the control cycle against the rotor model in simulated time. Relays and DAC are read
+// back from the GPIO mock, the model's voltage is put into the ADC mock's conversion register.
+namespace Harness {
+  unsigned long next_sample_us = 0;
+  float volts_per_count = 0.0f;
+
+  // Control cycles and host time spent in them
+  uint32_t n_ticks = 0;
+  std::chrono::nanoseconds tick_time{0};
+  std::chrono::nanoseconds worst_tick_time{0};
+
+  // => Drive the model with the relays and DAC as last written, relays switch on LOW
+  void readActuators() {
+    const bool ccw = Mock::pin_levels[rot_pins[0]] == LOW;
+    const bool cw = Mock::pin_levels[rot_pins[1]] == LOW;
+    rotor_sim.relay = cw ? 1 : (ccw ? -1 : 0);
+    rotor_sim.dac_speed = (uint8_t) roundf(Mock::dac_values[speed_pin] / 2.55f);
+  }
+
+  // => Run the ADC conversions of one control period, then a control cycle
+  void tick() {
+    const unsigned long tick_us = micros() + SIM_TICK_US;
+    while (next_sample_us <= tick_us) {
+      Mock::now_us = next_sample_us;
+      readActuators();
+      rotor_sim.step(micros());
+      Mock::adc_conversion = (int16_t) constrain(rotor_sim.readADCVolts() / volts_per_count, -32768.0f, 32767.0f);
+      rotor_ctrl.rotor.readConversion(micros());
+      next_sample_us += SIM_ADC_PERIOD_US;
+    }
+    Mock::now_us = tick_us;
+
+    const auto start = std::chrono::steady_clock::now();
+    rotor_ctrl.tick();
+    const std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start;
+    tick_time += elapsed;
+    worst_tick_time = max(worst_tick_time, elapsed);
+    n_ticks++;
+  }
+
+  // => Run control cycles for given simulated time
+  void run(const unsigned long ms) {
+    for (unsigned long t = 0; t < ms; t += CONTROL_PERIOD_MS) {
+      tick();
+    }
+  }
+
+  // => Boot controller and model, calibrated to the model's position output
+  void boot() {
+    Mock::now_us = 1000000;
+    next_sample_us = micros();
+    randomSeed(42);
+    rotor_ctrl.init();
+    Adafruit_ADS1115 adc;
+    adc.setGain(GAIN_ONE);
+    volts_per_count = adc.computeVolts(1);
+    rotor_ctrl.setCalibration(rotor_sim.model.volts_offset, rotor_sim.model.volts_offset + 450.0f * rotor_sim.model.volts_per_degree,
+                              0.0f, 450.0f);
+    rotor_ctrl.setMaxSpeed(100);
+    run(2000);
+  }
+}
+
+// Results accumulated over all scenarios
+struct {
+  uint32_t n_scenarios = 0;
+  uint32_t n_completed = 0;
+  uint32_t n_aborted = 0;
+  uint32_t n_timed_out = 0;
+  float sum_error = 0.0f;             // True final angle - target in rotation direction, in °
+  float sum_abs_error = 0.0f;
+  float max_abs_error = 0.0f;
+  float max_overshoot = 0.0f;         // Travel beyond the target, in °
+  unsigned long sum_time_ms = 0;      // Command posted to rotor settled
+} results;
+
+// => Run a single randomized auto-rotation until the rotor settled, like the on-device benchmark
+void runScenario() {
+  float target;
+  do {
+    target = random(0, 4490) / 10.0f;
+  } while (abs(target - rotor_sim.angle) < 5.0f);
+  const uint8_t speed = random(20, 101);
+  const bool use_smooth_speed = random(2);
+  const uint32_t completed_prev = rotor_ctrl.auto_rot_stats.n_completed;
+  const uint32_t aborted_prev = rotor_ctrl.auto_rot_stats.n_aborted;
+  const int8_t dir = (target > rotor_sim.angle) ? 1 : -1;
+
+  rotor_ctrl.post(Rotor::Command::setSpeed(speed));
+  rotor_ctrl.post(Rotor::Command::rotateTo(target, false, use_smooth_speed));
+
+  const unsigned long start_ms = millis();
+  float overshoot = 0.0f;
+  results.n_scenarios++;
+  for (;;) {
+    Harness::tick();
+    overshoot = max(overshoot, dir * (rotor_sim.angle - target));
+
+    if (rotor_ctrl.auto_rot_stats.n_completed != completed_prev) {
+      break;
+    }
+    if (rotor_ctrl.auto_rot_stats.n_aborted != aborted_prev) {
+      results.n_aborted++;
+      return;
+    }
+    if (millis() - start_ms > SIM_SCENARIO_TIMEOUT) {
+      rotor_ctrl.post(Rotor::Command::stop());
+      results.n_timed_out++;
+      return;
+    }
+  }
+
+  const float abs_error = abs(rotor_sim.angle - target);
+  results.n_completed++;
+  results.sum_error += dir * (rotor_sim.angle - target);
+  results.sum_time_ms += millis() - start_ms;
+  results.sum_abs_error += abs_error;
+  results.max_abs_error = max(results.max_abs_error, abs_error);
+  results.max_overshoot = max(results.max_overshoot, overshoot);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_randomized_auto_rotations() {
+  const unsigned long sim_start_ms = millis();
+  const auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < SIMULATION_SCENARIOS; ++i) {
+    runScenario();
+    Harness::run(SIM_PAUSE_MS);
+  }
+  const float host_s = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+  const float sim_s = (millis() - sim_start_ms) / 1000.0f;
+  const uint32_t n = max(results.n_completed, (uint32_t) 1);
+
+  char buffer[256];
+  snprintf(buffer, sizeof(buffer), "Scenarios: %u | Completed: %u | Aborted: %u | Timed out: %u",
+           results.n_scenarios, results.n_completed, results.n_aborted, results.n_timed_out);
+  TEST_MESSAGE(buffer);
+  snprintf(buffer, sizeof(buffer), "Mean time to target: %lu ms | Final error (bias/mean/max): %.2f / %.2f / %.2f° | Max overshoot: %.2f°",
+           results.sum_time_ms / n, results.sum_error / n, results.sum_abs_error / n, results.max_abs_error, results.max_overshoot);
+  TEST_MESSAGE(buffer);
+  snprintf(buffer, sizeof(buffer), "Simulated %.0f s in %.2f s (%.0fx real time) | Control tick (mean/worst): %.2f / %.2f us on the host (%u ticks)",
+           sim_s, host_s, sim_s / max(host_s, 0.001f),
+           Harness::tick_time.count() / 1000.0f / max(Harness::n_ticks, (uint32_t) 1),
+           Harness::worst_tick_time.count() / 1000.0f, Harness::n_ticks);
+  TEST_MESSAGE(buffer);
+
+  TEST_ASSERT_EQUAL_UINT32(0, results.n_timed_out);
+  TEST_ASSERT_EQUAL_UINT32(0, results.n_aborted);
+  // Relays cut at the predicted coast, the rotor neither stops short nor runs past on average
+  TEST_ASSERT_FLOAT_WITHIN(0.1f, 0.0f, results.sum_error / n);
+  TEST_ASSERT_LESS_THAN(0.2f, results.sum_abs_error / n);
+  TEST_ASSERT_LESS_THAN(0.7f, results.max_abs_error);
+  TEST_ASSERT_LESS_THAN(sim_s, host_s * 10.0f);
+}
+
+int main(int argc, char** argv) {
+  Harness::boot();
+  UNITY_BEGIN();
+  RUN_TEST(test_randomized_auto_rotations);
+  return UNITY_END();
+}
@@ -0,0 +1,74 @@
+#include <unity.h>
+#include <string.h>
+
+#include <FlatJson.h>
+#include <SocketMessages.h>
+
+void setUp() {}
+
+void tearDown() {}
+
+// => Parse a rotor message payload
+SocketMessages::RotorMsg parseRotor(const char* json) {
+  SocketMessages::RotorMsg msg;
+  TEST_ASSERT_TRUE(SocketMessages::parse(json, strlen(json), msg));
+  return msg;
+}
+
+void test_seq_exact_beyond_float_precision() {
+  // 2^24 + 1 is the first integer a float can't hold
+  TEST_ASSERT_EQUAL_UINT32(16777217, parseRotor("{\"rotation\":0,\"seq\":16777217}").seq);
+  TEST_ASSERT_EQUAL_UINT32(4294967295u, parseRotor("{\"seq\":4294967295}").seq);
+}
+
+void test_seq_out_of_range_saturates() {
+  TEST_ASSERT_EQUAL_UINT32(4294967295u, parseRotor("{\"seq\":99999999999}").seq);
+  TEST_ASSERT_EQUAL_UINT32(0, parseRotor("{\"seq\":-1}").seq);
+}
+
+void test_fractions_rounded() {
+  const SocketMessages::RotorMsg msg = parseRotor("{\"speed\":49.6,\"rotation\":-1.0,\"seq\":1e3}");
+  TEST_ASSERT_EQUAL_INT(50, msg.speed);
+  TEST_ASSERT_EQUAL_INT(-1, msg.rotation);
+  TEST_ASSERT_EQUAL_UINT32(1000, msg.seq);
+}
+
+void test_calibration_seq() {
+  const char* json = "{\"offset\":1.5,\"seq\":123456789}";
+  SocketMessages::CalibrationMsg msg;
+  TEST_ASSERT_TRUE(SocketMessages::parse(json, strlen(json), msg));
+  TEST_ASSERT_EQUAL_UINT32(123456789, msg.seq);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 1.5f, msg.offset);
+}
+
+void test_pong_id() {
+  const char* json = "{\"id\":65535}";
+  SocketMessages::PongMsg msg;
+  TEST_ASSERT_TRUE(SocketMessages::parse(json, strlen(json), msg));
+  TEST_ASSERT_EQUAL_UINT16(65535, msg.id);
+  TEST_ASSERT_EQUAL_UINT8(PONG_MSG_ID, msg.fields);
+}
+
+void test_int_accessors() {
+  const char* json = "{\"a\":-2147483649,\"b\":true,\"c\":\"7\"}";
+  FlatJson::Reader reader(json, strlen(json));
+  FlatJson::Pair pair;
+  TEST_ASSERT_TRUE(reader.next(pair));
+  TEST_ASSERT_EQUAL_INT32(INT32_MIN, pair.toInt());
+  TEST_ASSERT_EQUAL_UINT32(0, pair.toUint());
+  TEST_ASSERT_TRUE(reader.next(pair));
+  TEST_ASSERT_EQUAL_INT32(1, pair.toInt());
+  TEST_ASSERT_TRUE(reader.next(pair));
+  TEST_ASSERT_EQUAL_UINT32(0, pair.toUint());
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_seq_exact_beyond_float_precision);
+  RUN_TEST(test_seq_out_of_range_saturates);
+  RUN_TEST(test_fractions_rounded);
+  RUN_TEST(test_calibration_seq);
+  RUN_TEST(test_pong_id);
+  RUN_TEST(test_int_accessors);
+  return UNITY_END();
+}
@@ -0,0 +1,141 @@
+#include <unity.h>
+#include <string>
+#include <vector>
+
+#include <RotorController.h>    // Exposes Global: rotor_ctrl
+#include <UdpRotor.h>
+#include <AsyncUDP.h>
+
+// Commands handed on by the parser, instead of the control task
+std::vector<Rotor::Command> posted;
+
+bool capture(const Rotor::Command &cmd) {
+  posted.push_back(cmd);
+  return true;
+}
+
+char response[96];
+
+void setUp() {
+  posted.clear();
+  response[0] = '\0';
+}
+
+void tearDown() {}
+
+// => Handle a datagram, not null-terminated like the received packet
+bool receive(const std::string &datagram) {
+  std::vector<char> data(datagram.begin(), datagram.end());
+  data.push_back('X');
+  return UdpRotor::handleDatagram(data.data(), datagram.size(), 1234, capture, response, sizeof(response));
+}
+
+void test_n1mm_goazi() {
+  TEST_ASSERT_TRUE(receive("<N1MMRotor><rotor>Beam</rotor><goazi>123.4</goazi><offset>0</offset></N1MMRotor>"));
+  TEST_ASSERT_EQUAL_UINT32(1, posted.size());
+  TEST_ASSERT_TRUE(posted[0].type == Rotor::CommandType::ROTATE_TO);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 123.4f, posted[0].values[0]);
+  TEST_ASSERT_EQUAL_UINT32(1234, posted[0].rx_us);
+  TEST_ASSERT_EQUAL_STRING("<N1MMRotor><rotor>Beam</rotor><azimuth>0.0</azimuth></N1MMRotor>", response);
+}
+
+void test_n1mm_stop() {
+  TEST_ASSERT_TRUE(receive("<?xml version=\"1.0\"?><N1MMRotor><stop>Beam</stop></N1MMRotor>"));
+  TEST_ASSERT_EQUAL_UINT32(1, posted.size());
+  TEST_ASSERT_TRUE(posted[0].type == Rotor::CommandType::STOP);
+  TEST_ASSERT_EQUAL_STRING("<N1MMRotor><rotor>Beam</rotor><azimuth>0.0</azimuth></N1MMRotor>", response);
+}
+
+void test_n1mm_malformed() {
+  TEST_ASSERT_FALSE(receive("<N1MMRotor><rotor>Beam</rotor><goazi>360.5</goazi></N1MMRotor>"));
+  TEST_ASSERT_FALSE(receive("<N1MMRotor><goazi>-1</goazi></N1MMRotor>"));
+  TEST_ASSERT_FALSE(receive("<N1MMRotor><goazi>abc</goazi></N1MMRotor>"));
+  TEST_ASSERT_FALSE(receive("<N1MMRotor><goazi>90"));
+  TEST_ASSERT_FALSE(receive("<N1MMRotor><goazi>" + std::string(40, '1') + "</goazi></N1MMRotor>"));
+  TEST_ASSERT_FALSE(receive("<N1MMRotor><rotor>Beam</rotor></N1MMRotor>"));
+  TEST_ASSERT_EQUAL_UINT32(0, posted.size());
+}
+
+void test_n1mm_long_rotor_name() {
+  // Name doesn't fit, the command still counts
+  TEST_ASSERT_TRUE(receive("<N1MMRotor><rotor>" + std::string(40, 'n') + "</rotor><goazi>10</goazi></N1MMRotor>"));
+  TEST_ASSERT_EQUAL_UINT32(1, posted.size());
+  TEST_ASSERT_EQUAL_STRING("<N1MMRotor><rotor></rotor><azimuth>0.0</azimuth></N1MMRotor>", response);
+}
+
+void test_pst_azimuth() {
+  TEST_ASSERT_TRUE(receive("<PST><AZIMUTH>90</AZIMUTH></PST>"));
+  TEST_ASSERT_EQUAL_UINT32(1, posted.size());
+  TEST_ASSERT_TRUE(posted[0].type == Rotor::CommandType::ROTATE_TO);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 90.0f, posted[0].values[0]);
+  TEST_ASSERT_EQUAL_STRING("AZ:000\r", response);
+}
+
+void test_pst_stop_and_query() {
+  TEST_ASSERT_TRUE(receive("<PST><STOP>1</STOP></PST>"));
+  TEST_ASSERT_TRUE(posted[0].type == Rotor::CommandType::STOP);
+  TEST_ASSERT_TRUE(receive("<PST>AZ?</PST>"));
+  TEST_ASSERT_EQUAL_UINT32(1, posted.size());
+  TEST_ASSERT_EQUAL_STRING("AZ:000\r", response);
+}
+
+void test_pst_malformed() {
+  TEST_ASSERT_FALSE(receive("<PST><AZIMUTH>400</AZIMUTH></PST>"));
+  TEST_ASSERT_FALSE(receive("<PST><AZIMUTH></AZIMUTH></PST>"));
+  TEST_ASSERT_FALSE(receive("<PST><azimuth>90</azimuth></PST>"));
+  TEST_ASSERT_FALSE(receive("<PST></PST>"));
+  TEST_ASSERT_EQUAL_UINT32(0, posted.size());
+}
+
+void test_unknown_datagrams() {
+  TEST_ASSERT_FALSE(receive(""));
+  TEST_ASSERT_FALSE(receive("AZ?"));
+  TEST_ASSERT_FALSE(receive("<Rotor><goazi>90</goazi></Rotor>"));
+  TEST_ASSERT_FALSE(receive(std::string(300, '<')));
+  TEST_ASSERT_EQUAL_UINT32(0, posted.size());
+}
+
+void test_tag_beyond_datagram_limit() {
+  // Only the first UDP_ROTOR_MAX_DATAGRAM bytes are read
+  TEST_ASSERT_FALSE(receive("<PST>" + std::string(300, ' ') + "<AZIMUTH>90</AZIMUTH></PST>"));
+  TEST_ASSERT_EQUAL_UINT32(0, posted.size());
+}
+
+void test_listener_posts_to_control_task() {
+  std::string reply;
+  TEST_ASSERT_FALSE(Mock::sendDatagram(UDP_ROTOR_PORT, "<PST>AZ?</PST>", reply));
+  UdpRotor::init();
+
+  // Received on the UDP task, applied by the control task
+  TEST_ASSERT_TRUE(Mock::sendDatagram(UDP_ROTOR_PORT, "<PST><AZIMUTH>90</AZIMUTH></PST>", reply));
+  TEST_ASSERT_EQUAL_STRING("AZ:000\r", reply.c_str());
+  rotor_ctrl.tick();
+  TEST_ASSERT_TRUE(rotor_ctrl.getSnapshot().is_auto_rotating);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 90.0f, rotor_ctrl.getSnapshot().target);
+
+  TEST_ASSERT_TRUE(Mock::sendDatagram(UDP_ROTOR_PORT, "<N1MMRotor><stop>Beam</stop></N1MMRotor>", reply));
+  TEST_ASSERT_EQUAL_STRING("<N1MMRotor><rotor>Beam</rotor><azimuth>0.0</azimuth></N1MMRotor>", reply.c_str());
+  rotor_ctrl.tick();
+  TEST_ASSERT_FALSE(rotor_ctrl.getSnapshot().is_rotating);
+
+  // Unknown datagrams aren't answered
+  TEST_ASSERT_TRUE(Mock::sendDatagram(UDP_ROTOR_PORT, "AZ?", reply));
+  TEST_ASSERT_EQUAL_UINT32(0, reply.size());
+}
+
+int main(int argc, char** argv) {
+  Mock::now_us = 1000000;
+  rotor_ctrl.init();
+  UNITY_BEGIN();
+  RUN_TEST(test_n1mm_goazi);
+  RUN_TEST(test_n1mm_stop);
+  RUN_TEST(test_n1mm_malformed);
+  RUN_TEST(test_n1mm_long_rotor_name);
+  RUN_TEST(test_pst_azimuth);
+  RUN_TEST(test_pst_stop_and_query);
+  RUN_TEST(test_pst_malformed);
+  RUN_TEST(test_unknown_datagrams);
+  RUN_TEST(test_tag_beyond_datagram_limit);
+  RUN_TEST(test_listener_posts_to_control_task);
+  return UNITY_END();
+}
@@ -1,4 +1,4 @@
-import { computed, reactive, watch } from 'vue';
+import { computed, reactive, ref, watch } from 'vue';
 import { defineStore } from 'pinia';
 
 export const useRotorStore = defineStore('rotor', () => {
@@ -31,9 +31,30 @@ export const useRotorStore = defineStore('rotor', () => {
         angle: 0.0,
         adc_v: 0.0,
         speed: 0, // 0-100
-        target: null
+        target: null,
+        t: 0, // Time of angle measurement, device ms
+        v: 0.0 // Angular speed in °/s
     });
 
+    // Angle extrapolated from the last message, for smooth needle motion between messages
+    const maxExtrapolation = 0.5; // s
+    const smoothAngle = ref(0.0);
+    let lastAngleReceived = performance.now();
+
+    watch(
+        () => rotor.t,
+        () => {
+            lastAngleReceived = performance.now();
+        }
+    );
+
+    function extrapolateAngle() {
+        const dt = Math.min((performance.now() - lastAngleReceived) / 1000, maxExtrapolation);
+        smoothAngle.value = rotor.angle + rotor.v * dt;
+        requestAnimationFrame(extrapolateAngle);
+    }
+    requestAnimationFrame(extrapolateAngle);
+
     // *************
     //    Getters
     // *************
@@ -60,6 +81,11 @@ export const useRotorStore = defineStore('rotor', () => {
         return rotor.angle.toFixed(1);
     });
 
+    // Get extrapolated angle as string with one decimal
+    const smoothAngle1D = computed(() => {
+        return smoothAngle.value.toFixed(1);
+    });
+
     // Get wether rotor is in overlap mode
     const isOverlap = computed(() => {
         return rotor.angle > 360;
@@ -113,6 +139,7 @@ export const useRotorStore = defineStore('rotor', () => {
         cardinal,
         angle,
         angle1D,
+        smoothAngle1D,
         isOverlap,
         hasTarget,
         getRotationMsg,
@@ -63,9 +63,12 @@ export const useUmbrellaStore = defineStore('umbrella', () => {
         console.log('[' + socket.gateway + '] Open connection...');
         updateTimeOfLastMsg();
         socket.socket = new WebSocket(socket.gateway);
+        socket.socket.binaryType = 'arraybuffer';
         // Open
         socket.socket.onopen = function (event) {
             console.log('[' + socket.gateway + '] Connected.');
+            // Request binary rotor telemetry and bundled messages, older firmware ignores this
+            sendMsg(identifiers.protocol, JSON.stringify({ binary: true, bundle: true }));
         };
         // Close
         socket.socket.onclose = function (event) {
@@ -100,7 +103,13 @@ export const useUmbrellaStore = defineStore('umbrella', () => {
         ui: 'UI',
         calibration: 'CALIBRATION',
         favorites: 'FAVORITES',
-        lock: 'LOCK'
+        lock: 'LOCK',
+        protocol: 'PROTOCOL',
+        subscribe: 'SUBSCRIBE',
+        ack: 'ACK',
+        ping: 'PING',
+        pong: 'PONG',
+        diag: 'DIAG'
     };
 
     // Receivers collection
@@ -110,7 +119,17 @@ export const useUmbrellaStore = defineStore('umbrella', () => {
         [identifiers.ui]: () => {},
         [identifiers.calibration]: receiveCalibrationMsg,
         [identifiers.favorites]: receiveFavoritesMsg,
-        [identifiers.lock]: receiveLockMsg
+        [identifiers.lock]: receiveLockMsg,
+        [identifiers.protocol]: receiveProtocolMsg,
+        [identifiers.subscribe]: () => {},
+        [identifiers.ack]: () => {},
+        [identifiers.ping]: receivePingMsg,
+        [identifiers.diag]: receiveDiagMsg
+    };
+
+    // Binary rotor frame types, must match RotorMessenger.h
+    const frameTypes = {
+        rotation: 1
     };
 
     // Receive websocket message
@@ -118,15 +137,24 @@ export const useUmbrellaStore = defineStore('umbrella', () => {
         hasLostConnection.value = false;
         updateTimeOfLastMsg();
 
-        // Split msg-type-identifier from JSON data
-        var [identifier, msg] = event.data.split('|');
+        // Binary rotor frame
+        if (event.data instanceof ArrayBuffer) {
+            receiveRotorFrame(new DataView(event.data));
+            return;
+        }
 
-        // Receive JSON message
-        if (receivers.hasOwnProperty(identifier)) {
-            receivers[identifier](msg);
-            //console.log('[' + event.origin + '] ' + event.data);
-        } else {
-            console.warn(`ERROR: unknown message identifier '${identifier}'`);
+        // A frame may bundle several messages separated by newlines, e.g. the state sent on connect
+        for (const line of event.data.split('\n')) {
+            // Split msg-type-identifier from JSON data
+            var [identifier, msg] = line.split('|');
+
+            // Receive JSON message
+            if (receivers.hasOwnProperty(identifier)) {
+                receivers[identifier](msg);
+                //console.log('[' + event.origin + '] ' + line);
+            } else {
+                console.warn(`ERROR: unknown message identifier '${identifier}'`);
+            }
         }
     }
 
@@ -142,6 +170,48 @@ export const useUmbrellaStore = defineStore('umbrella', () => {
         }
     }
 
+    // Receiver for binary rotor frame, little-endian, angles in 1/100 °
+    function receiveRotorFrame(view) {
+        switch (view.getUint8(0)) {
+            case frameTypes.rotation: {
+                const flags = view.getUint8(2);
+                rotorStore.rotor.rotation = view.getInt8(1);
+                if (flags & 0x01) {
+                    rotorStore.rotor.angle = view.getInt32(3, true) / 100;
+                    rotorStore.rotor.adc_v = view.getUint16(7, true) / 1000;
+                    rotorStore.rotor.t = view.getUint32(14, true);
+                    rotorStore.rotor.v = view.getInt16(18, true) / 100;
+                }
+                if (flags & 0x02) {
+                    rotorStore.rotor.target = view.getInt32(9, true) / 100;
+                }
+                if (flags & 0x04) {
+                    rotorStore.rotor.speed = view.getUint8(13);
+                }
+                break;
+            }
+            default:
+                console.warn(`ERROR: unknown binary frame type '${view.getUint8(0)}'`);
+        }
+    }
+
+    // Receiver for protocol confirmation
+    function receiveProtocolMsg(msg) {
+        const protocolMsg = JSON.parse(msg);
+        console.log('[' + socket.gateway + '] Binary rotor frames: ' + protocolMsg.binary + ', bundled messages: ' + protocolMsg.bundle);
+    }
+
+    // Receiver for ping message, answer immediately so the device can measure the round trip time
+    function receivePingMsg(msg) {
+        const pingMsg = JSON.parse(msg);
+        sendMsg(identifiers.pong, JSON.stringify({ id: pingMsg.id }));
+    }
+
+    // Receiver for diagnostics message
+    function receiveDiagMsg(msg) {
+        console.log('[' + socket.gateway + '] Diagnostics:', JSON.parse(msg));
+    }
+
     // Receiver for calibration message
     function receiveCalibrationMsg(msg) {
         let calibrationMsg = JSON.parse(msg);